@@ -0,0 +1,262 @@
+/*
+ * This file is part of the Falcon Player (FPP) and is Copyright (C)
+ * 2013-2022 by the Falcon Player Developers.
+ *
+ * The Falcon Player (FPP) is free software, and is covered under
+ * multiple Open Source licenses.  Please see the included 'LICENSES'
+ * file for descriptions of what files are covered by each license.
+ *
+ * This source file is covered under the LGPL v2.1 as described in the
+ * included LICENSE.LGPL file.
+ */
+
+#include "fpp-pch.h"
+
+#include <chrono>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Sequence.h"
+#include "common.h"
+#include "log.h"
+#include "settings.h"
+#include "channeloutput/channeloutputthread.h"
+#include "commands/Commands.h"
+#include "fseq/FSEQFile.h"
+
+#include "BridgeRecorder.h"
+
+// limit the memory used for queued frames
+#define BRIDGE_RECORD_QUEUE_FRAMES 64
+#define BRIDGE_RECORD_QUEUE_MAX_BYTES (64 * 1024 * 1024)
+
+BridgeRecorder BridgeRecorder::INSTANCE;
+
+BridgeRecorder::BridgeRecorder() :
+    m_recording(false),
+    m_snapshotThread(nullptr),
+    m_writerThread(nullptr),
+    m_file(nullptr),
+    m_channelCount(0),
+    m_stepTime(50),
+    m_maxFrames(0),
+    m_head(0),
+    m_tail(0),
+    m_framesWritten(0),
+    m_framesDropped(0) {
+}
+BridgeRecorder::~BridgeRecorder() {
+    Stop();
+}
+
+bool BridgeRecorder::Start(const std::string& filename, uint32_t channelCount, int maxMinutes, std::string& error) {
+    std::unique_lock<std::mutex> lock(m_lock);
+    if (m_recording) {
+        error = "Already recording to " + m_filename;
+        return false;
+    }
+    // previous recording hit its max length, finish it up
+    StopInternal();
+    if (channelCount == 0) {
+        channelCount = sequence->GetBridgeChannelCount();
+    }
+    if (channelCount == 0) {
+        error = "No bridge data has been received";
+        return false;
+    }
+    if (channelCount > FPPD_MAX_CHANNELS) {
+        channelCount = FPPD_MAX_CHANNELS;
+    }
+    if (maxMinutes <= 0) {
+        maxMinutes = 60;
+    }
+    std::string fn = filename;
+    if (!endsWith(fn, ".fseq")) {
+        fn += ".fseq";
+    }
+    if (sequence->IsSequenceRunning(fn)) {
+        error = "Cannot record over the running sequence " + fn;
+        return false;
+    }
+
+    float rate = GetChannelOutputRefreshRate();
+    m_stepTime = rate > 0 ? (int)(1000.0f / rate) : 50;
+    if (m_stepTime < 1) {
+        m_stepTime = 1;
+    }
+    m_maxFrames = (uint32_t)maxMinutes * 60 * 1000 / m_stepTime;
+    m_channelCount = channelCount;
+
+    FSEQFile* file = FSEQFile::createFSEQFile(FPP_DIR_SEQUENCE("/" + fn), 2, FSEQFile::CompressionType::zstd);
+    if (file == nullptr) {
+        error = "Could not create " + fn;
+        return false;
+    }
+    // the number of frames is not known yet, the header is sized for the
+    // max duration and updated with the real count when finalized
+    file->enableMinorVersionFeatures(1);
+    file->setChannelCount(m_channelCount);
+    file->setStepTime(m_stepTime);
+    file->setNumFrames(m_maxFrames);
+    file->writeHeader();
+    m_file = file;
+    m_filename = fn;
+
+    int queueSize = BRIDGE_RECORD_QUEUE_FRAMES;
+    while (queueSize > 4 && ((uint64_t)queueSize * m_channelCount) > BRIDGE_RECORD_QUEUE_MAX_BYTES) {
+        queueSize /= 2;
+    }
+    m_frames.resize(queueSize);
+    m_frameNumbers.resize(queueSize);
+    for (auto& f : m_frames) {
+        f = (uint8_t*)malloc(m_channelCount);
+    }
+    m_head = 0;
+    m_tail = 0;
+    m_framesWritten = 0;
+    m_framesDropped = 0;
+
+    LogInfo(VB_E131BRIDGE, "Recording bridge data to %s, %d channels, %dms per frame\n",
+            m_filename.c_str(), m_channelCount, m_stepTime);
+
+    m_recording = true;
+    m_writerThread = new std::thread([this]() { WriterThread(); });
+    m_snapshotThread = new std::thread([this]() { SnapshotThread(); });
+    return true;
+}
+
+void BridgeRecorder::Stop() {
+    std::unique_lock<std::mutex> lock(m_lock);
+    StopInternal();
+}
+
+void BridgeRecorder::StopInternal() {
+    if (m_snapshotThread == nullptr) {
+        return;
+    }
+    m_recording = false;
+    m_snapshotThread->join();
+    delete m_snapshotThread;
+    m_snapshotThread = nullptr;
+    m_writerThread->join();
+    delete m_writerThread;
+    m_writerThread = nullptr;
+
+    m_file->setNumFrames(m_framesWritten);
+    m_file->finalize();
+    delete m_file;
+    m_file = nullptr;
+
+    for (auto f : m_frames) {
+        free(f);
+    }
+    m_frames.clear();
+    m_frameNumbers.clear();
+
+    LogInfo(VB_E131BRIDGE, "Recorded %d frames of bridge data to %s, %d frames dropped\n",
+            (int)m_framesWritten, m_filename.c_str(), (int)m_framesDropped);
+}
+
+void BridgeRecorder::SnapshotThread() {
+    SetThreadName("FPP-BridgeSnap");
+    uint32_t size = m_frames.size();
+    uint32_t frame = 0;
+    auto next = std::chrono::steady_clock::now();
+    while (m_recording && frame < m_maxFrames) {
+        uint32_t head = m_head.load(std::memory_order_relaxed);
+        if ((head - m_tail.load(std::memory_order_acquire)) < size) {
+            uint32_t idx = head % size;
+            sequence->GetBridgeDataSnapshot(m_frames[idx], m_channelCount);
+            m_frameNumbers[idx] = frame;
+            m_head.store(head + 1, std::memory_order_release);
+        } else {
+            // writer can't keep up, it will repeat the previous frame
+            ++m_framesDropped;
+        }
+        ++frame;
+        next += std::chrono::milliseconds(m_stepTime);
+        std::this_thread::sleep_until(next);
+    }
+    if (frame >= m_maxFrames) {
+        LogInfo(VB_E131BRIDGE, "Bridge recording reached maximum length\n");
+    }
+    m_recording = false;
+}
+
+void BridgeRecorder::WriterThread() {
+    SetThreadName("FPP-BridgeRec");
+    uint32_t size = m_frames.size();
+    uint32_t nextFrame = 0;
+    // the ring slot is handed back as soon as it is written so keep our own
+    // copy of the previous frame to repeat if the snapshot thread dropped any
+    std::vector<uint8_t> last;
+    while (true) {
+        uint32_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail == m_head.load(std::memory_order_acquire)) {
+            if (!m_recording && tail == m_head.load(std::memory_order_acquire)) {
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            continue;
+        }
+        uint32_t idx = tail % size;
+        uint32_t frame = m_frameNumbers[idx];
+        while (!last.empty() && nextFrame < frame) {
+            m_file->addFrame(nextFrame++, &last[0]);
+            ++m_framesWritten;
+        }
+        m_file->addFrame(nextFrame++, m_frames[idx]);
+        ++m_framesWritten;
+        last.assign(m_frames[idx], m_frames[idx] + m_channelCount);
+        m_tail.store(tail + 1, std::memory_order_release);
+    }
+}
+
+void BridgeRecorder::GetStatus(Json::Value& status) {
+    std::unique_lock<std::mutex> lock(m_lock);
+    status["recording"] = (bool)m_recording;
+    if (m_file) {
+        status["filename"] = m_filename;
+        status["channelCount"] = m_channelCount;
+        status["stepTime"] = m_stepTime;
+        status["framesWritten"] = (uint32_t)m_framesWritten;
+        status["framesDropped"] = (uint32_t)m_framesDropped;
+    }
+}
+
+class StartBridgeRecordingCommand : public Command {
+public:
+    StartBridgeRecordingCommand() :
+        Command("Bridge Recording Start", "Record the incoming E1.31/ArtNet/DDP data to a sequence.") {
+        args.push_back(CommandArg("filename", "string", "Sequence Name"));
+        args.push_back(CommandArg("maxMinutes", "int", "Maximum Length (minutes)").setDefaultValue("60").setRange(1, 1440));
+        args.push_back(CommandArg("channelCount", "int", "Channel Count (0 for auto)").setDefaultValue("0").setRange(0, FPPD_MAX_CHANNELS));
+    }
+    virtual std::unique_ptr<Command::Result> run(const std::vector<std::string>& args) override {
+        if (args.empty() || args[0].empty()) {
+            return std::make_unique<Command::ErrorResult>("Missing sequence name");
+        }
+        int maxMinutes = args.size() > 1 ? std::atoi(args[1].c_str()) : 60;
+        uint32_t channelCount = args.size() > 2 ? std::atoi(args[2].c_str()) : 0;
+        std::string error;
+        if (!BridgeRecorder::INSTANCE.Start(args[0], channelCount, maxMinutes, error)) {
+            return std::make_unique<Command::ErrorResult>(error);
+        }
+        return std::make_unique<Command::Result>("Recording Started");
+    }
+};
+class StopBridgeRecordingCommand : public Command {
+public:
+    StopBridgeRecordingCommand() :
+        Command("Bridge Recording Stop", "Stop recording the incoming bridge data.") {
+    }
+    virtual std::unique_ptr<Command::Result> run(const std::vector<std::string>& args) override {
+        BridgeRecorder::INSTANCE.Stop();
+        return std::make_unique<Command::Result>("Recording Stopped");
+    }
+};
+
+void BridgeRecorder::RegisterCommands() {
+    CommandManager::INSTANCE.addCommand(new StartBridgeRecordingCommand());
+    CommandManager::INSTANCE.addCommand(new StopBridgeRecordingCommand());
+}
@@ -0,0 +1,65 @@
+#pragma once
+/*
+ * This file is part of the Falcon Player (FPP) and is Copyright (C)
+ * 2013-2022 by the Falcon Player Developers.
+ *
+ * The Falcon Player (FPP) is free software, and is covered under
+ * multiple Open Source licenses.  Please see the included 'LICENSES'
+ * file for descriptions of what files are covered by each license.
+ *
+ * This source file is covered under the LGPL v2.1 as described in the
+ * included LICENSE.LGPL file.
+ */
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class FSEQFile;
+
+// Records the incoming bridge data (E1.31/ArtNet/DDP) to a zstd compressed
+// FSEQ file.  A snapshot thread copies the bridge buffer at the output
+// refresh rate into a fixed ring of frames and a writer thread compresses
+// them so neither the receive path nor the output thread ever waits on
+// the disk.
+class BridgeRecorder {
+public:
+    static BridgeRecorder INSTANCE;
+
+    bool Start(const std::string& filename, uint32_t channelCount, int maxMinutes, std::string& error);
+    void Stop();
+    bool IsRecording() const { return m_recording; }
+
+    void GetStatus(Json::Value& status);
+    void RegisterCommands();
+
+private:
+    BridgeRecorder();
+    ~BridgeRecorder();
+
+    void StopInternal();
+    void SnapshotThread();
+    void WriterThread();
+
+    std::mutex m_lock;
+    std::atomic_bool m_recording;
+    std::thread* m_snapshotThread;
+    std::thread* m_writerThread;
+
+    FSEQFile* m_file;
+    std::string m_filename;
+    uint32_t m_channelCount;
+    int m_stepTime;
+    uint32_t m_maxFrames;
+
+    // single producer (snapshot thread), single consumer (writer thread)
+    std::vector<uint8_t*> m_frames;
+    std::vector<uint32_t> m_frameNumbers;
+    std::atomic<uint32_t> m_head;
+    std::atomic<uint32_t> m_tail;
+
+    std::atomic<uint32_t> m_framesWritten;
+    std::atomic<uint32_t> m_framesDropped;
+};
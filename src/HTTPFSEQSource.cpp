@@ -0,0 +1,485 @@
+/*
+ * This file is part of the Falcon Player (FPP) and is Copyright (C)
+ * 2013-2024 by the Falcon Player Developers.
+ *
+ * The Falcon Player (FPP) is free software, and is covered under
+ * multiple Open Source licenses.  Please see the included 'LICENSES'
+ * file for descriptions of what files are covered by each license.
+ *
+ * This source file is covered under the LGPL v2.1 as described in the
+ * included LICENSE.LGPL file.
+ */
+
+#include "fpp-pch.h"
+
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+
+#include "CurlManager.h"
+#include "MultiSync.h"
+#include "common.h"
+#include "log.h"
+#include "settings.h"
+
+#include "HTTPFSEQSource.h"
+
+#define HTTP_FSEQ_CHUNK_SIZE (256 * 1024)
+// bytes of the fixed FSEQ header compared to tell if a local copy is current
+#define HTTP_FSEQ_HEADER_CHECK_SIZE 32
+// chunks kept in memory while playing, older ones are dropped first
+#define HTTP_FSEQ_MAX_MEMORY_CHUNKS 64
+// chunks ahead of the current read position to request
+#define HTTP_FSEQ_READ_AHEAD_CHUNKS 2
+// background requests outstanding while saving a copy
+#define HTTP_FSEQ_BACKGROUND_REQUESTS 2
+#define HTTP_FSEQ_MAX_FAILURES 10
+#define HTTP_FSEQ_READ_TIMEOUT_MS 10000
+
+class HTTPFSEQSource::State {
+public:
+    ~State() {
+        if (cacheFd >= 0) {
+            close(cacheFd);
+        }
+    }
+
+    uint32_t chunkSize(uint32_t chunk) const {
+        uint64_t start = (uint64_t)chunk * HTTP_FSEQ_CHUNK_SIZE;
+        return std::min((uint64_t)HTTP_FSEQ_CHUNK_SIZE, size - start);
+    }
+
+    std::string url;
+    std::string filename;
+    uint64_t size = 0;
+    uint32_t numChunks = 0;
+
+    std::mutex lock;
+    std::condition_variable signal;
+    std::map<uint32_t, std::vector<uint8_t>> chunks;
+    std::set<uint32_t> pending;
+    uint32_t lastRead = 0;
+    int readers = 0;
+    int failures = 0;
+
+    // local copy being written
+    int cacheFd = -1;
+    std::string cachePath;
+    std::string finalPath;
+    std::vector<bool> saved;
+    uint32_t savedCount = 0;
+    uint32_t nextBackground = 0;
+};
+
+// copies of sequences still being downloaded, by destination path
+static std::mutex downloadsLock;
+static std::map<std::string, std::shared_ptr<HTTPFSEQSource::State>> downloads;
+
+static void RequestChunk(std::shared_ptr<HTTPFSEQSource::State> st, uint32_t chunk);
+
+static void RemoveDownload(std::shared_ptr<HTTPFSEQSource::State> st) {
+    std::unique_lock<std::mutex> lock(downloadsLock);
+    auto it = downloads.find(st->finalPath);
+    if (it != downloads.end() && it->second == st) {
+        downloads.erase(it);
+    }
+}
+
+// All chunks are saved, move the copy into place
+static void FinishCopy(std::shared_ptr<HTTPFSEQSource::State> st) {
+    std::unique_lock<std::mutex> lock(st->lock);
+    if (st->cacheFd < 0) {
+        return;
+    }
+    close(st->cacheFd);
+    st->cacheFd = -1;
+    if (rename(st->cachePath.c_str(), st->finalPath.c_str()) == 0) {
+        LogInfo(VB_SEQUENCE, "Finished copying %s from %s\n", st->filename.c_str(), st->url.c_str());
+    } else {
+        LogWarn(VB_SEQUENCE, "Could not move %s to %s: %s\n", st->cachePath.c_str(), st->finalPath.c_str(), strerror(errno));
+        unlink(st->cachePath.c_str());
+    }
+    lock.unlock();
+    RemoveDownload(st);
+}
+
+// Must be called with the state locked
+static void DropChunks(HTTPFSEQSource::State* st) {
+    if (st->readers == 0) {
+        // nobody is reading, only the header needs to be kept
+        for (auto it = st->chunks.begin(); it != st->chunks.end();) {
+            it = (it->first == 0) ? std::next(it) : st->chunks.erase(it);
+        }
+        return;
+    }
+    for (auto it = st->chunks.begin(); it != st->chunks.end() && st->chunks.size() > HTTP_FSEQ_MAX_MEMORY_CHUNKS;) {
+        if (it->first != 0 && (it->first + 1) < st->lastRead) {
+            it = st->chunks.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    while (st->chunks.size() > HTTP_FSEQ_MAX_MEMORY_CHUNKS) {
+        // still too many, drop the furthest ahead
+        st->chunks.erase(std::prev(st->chunks.end()));
+    }
+}
+
+static void ChunkReceived(std::shared_ptr<HTTPFSEQSource::State> st, uint32_t chunk, CURL* c) {
+    CurlManager::CurlPrivateData* data = nullptr;
+    long rc = 0;
+    curl_easy_getinfo(c, CURLINFO_PRIVATE, &data);
+    curl_easy_getinfo(c, CURLINFO_RESPONSE_CODE, &rc);
+
+    std::unique_lock<std::mutex> lock(st->lock);
+    st->pending.erase(chunk);
+    if (rc == 206 && data->resp.size() == st->chunkSize(chunk)) {
+        st->failures = 0;
+        if (st->cacheFd >= 0 && !st->saved[chunk]) {
+            uint64_t pos = (uint64_t)chunk * HTTP_FSEQ_CHUNK_SIZE;
+            if (pwrite(st->cacheFd, &data->resp[0], data->resp.size(), pos) == (ssize_t)data->resp.size()) {
+                st->saved[chunk] = true;
+                st->savedCount++;
+            }
+        }
+        if (st->readers) {
+            st->chunks[chunk].swap(data->resp);
+            DropChunks(st.get());
+        }
+    } else {
+        st->failures++;
+        LogWarn(VB_SEQUENCE, "Could not fetch %s chunk %d: %d %s\n", st->filename.c_str(), chunk, (int)rc, data->errorResp);
+    }
+    st->signal.notify_all();
+
+    if (st->cacheFd < 0) {
+        return;
+    }
+    if (st->savedCount == st->numChunks) {
+        lock.unlock();
+        FinishCopy(st);
+        return;
+    }
+    if (st->failures >= HTTP_FSEQ_MAX_FAILURES) {
+        if (st->readers == 0) {
+            LogWarn(VB_SEQUENCE, "Giving up copying %s from %s\n", st->filename.c_str(), st->url.c_str());
+            close(st->cacheFd);
+            st->cacheFd = -1;
+            unlink(st->cachePath.c_str());
+            lock.unlock();
+            RemoveDownload(st);
+        }
+        return;
+    }
+
+    // keep the rest of the file trickling in behind the playback requests
+    int next = -1;
+    if (st->pending.size() < HTTP_FSEQ_BACKGROUND_REQUESTS) {
+        while (st->nextBackground < st->numChunks &&
+               (st->saved[st->nextBackground] || st->pending.count(st->nextBackground))) {
+            st->nextBackground++;
+        }
+        if (st->nextBackground < st->numChunks) {
+            next = st->nextBackground;
+        }
+    }
+    lock.unlock();
+    if (next >= 0) {
+        RequestChunk(st, next);
+    }
+}
+
+static void RequestChunk(std::shared_ptr<HTTPFSEQSource::State> st, uint32_t chunk) {
+    std::unique_lock<std::mutex> lock(st->lock);
+    if (chunk >= st->numChunks || st->pending.count(chunk) || st->chunks.count(chunk) ||
+        (st->cacheFd >= 0 && st->saved[chunk])) {
+        return;
+    }
+    st->pending.insert(chunk);
+    uint64_t start = (uint64_t)chunk * HTTP_FSEQ_CHUNK_SIZE;
+    uint64_t end = start + st->chunkSize(chunk) - 1;
+    lock.unlock();
+
+    char range[64];
+    snprintf(range, sizeof(range), "%" PRIu64 "-%" PRIu64, start, end);
+    CURL* c = CurlManager::INSTANCE.createCurl(st->url);
+    curl_easy_setopt(c, CURLOPT_RANGE, range);
+    // ranges of compressed content don't map to the file
+    curl_easy_setopt(c, CURLOPT_ACCEPT_ENCODING, nullptr);
+    // fail up front if the server ignores the range and sends the whole file
+    curl_easy_setopt(c, CURLOPT_MAXFILESIZE_LARGE, (curl_off_t)HTTP_FSEQ_CHUNK_SIZE);
+    CurlManager::INSTANCE.addCURL(st->url, c, [st, chunk](CURL* c) {
+        ChunkReceived(st, chunk, c);
+    });
+}
+
+static size_t ContentRangeHeader(char* buffer, size_t size, size_t nitems, void* userdata) {
+    size_t len = size * nitems;
+    static const char* CONTENT_RANGE = "Content-Range:";
+    if (len > strlen(CONTENT_RANGE) && strncasecmp(buffer, CONTENT_RANGE, strlen(CONTENT_RANGE)) == 0) {
+        std::string value(buffer + strlen(CONTENT_RANGE), len - strlen(CONTENT_RANGE));
+        size_t slash = value.find('/');
+        if (slash != std::string::npos) {
+            *(uint64_t*)userdata = std::strtoull(value.c_str() + slash + 1, nullptr, 10);
+        }
+    }
+    return len;
+}
+
+// Synchronously fetches the first len bytes of url along with the total
+// size of the file.  Returns the HTTP response code.
+static long FetchStart(const std::string& url, uint32_t len, std::vector<uint8_t>& resp, uint64_t& total) {
+    total = 0;
+    char range[64];
+    snprintf(range, sizeof(range), "0-%u", len - 1);
+    CURL* c = CurlManager::INSTANCE.createCurl(url);
+    curl_easy_setopt(c, CURLOPT_RANGE, range);
+    curl_easy_setopt(c, CURLOPT_ACCEPT_ENCODING, nullptr);
+    curl_easy_setopt(c, CURLOPT_MAXFILESIZE_LARGE, (curl_off_t)len);
+    curl_easy_setopt(c, CURLOPT_HEADERFUNCTION, ContentRangeHeader);
+    curl_easy_setopt(c, CURLOPT_HEADERDATA, &total);
+
+    bool done = false;
+    CurlManager::INSTANCE.addCURL(
+        url, c, [&done](CURL* c) { done = true; }, false);
+    while (!done && CurlManager::INSTANCE.processCurls()) {
+        std::this_thread::yield();
+    }
+
+    CurlManager::CurlPrivateData* data = nullptr;
+    long rc = 0;
+    curl_easy_getinfo(c, CURLINFO_PRIVATE, &data);
+    curl_easy_getinfo(c, CURLINFO_RESPONSE_CODE, &rc);
+    if (rc != 200 && rc != 206) {
+        LogDebug(VB_SEQUENCE, "Could not fetch %s: %d %s\n", url.c_str(), (int)rc, data->errorResp);
+    }
+    resp.swap(data->resp);
+    delete data;
+    curl_easy_cleanup(c);
+    return rc;
+}
+
+// Fetches the first chunk of the file, which includes the header, and
+// the total size of the file
+static bool FetchFirstChunk(HTTPFSEQSource::State* st) {
+    std::vector<uint8_t> resp;
+    uint64_t total = 0;
+    long rc = FetchStart(st->url, HTTP_FSEQ_CHUNK_SIZE, resp, total);
+
+    bool ok = false;
+    if (rc == 206 && total) {
+        ok = true;
+    } else if (rc == 200 && resp.size() < HTTP_FSEQ_CHUNK_SIZE) {
+        // small file, server sent all of it
+        total = resp.size();
+        ok = true;
+    } else if (rc == 200) {
+        LogWarn(VB_SEQUENCE, "%s does not support range requests\n", st->url.c_str());
+    }
+    if (ok) {
+        st->size = total;
+        st->numChunks = (total + HTTP_FSEQ_CHUNK_SIZE - 1) / HTTP_FSEQ_CHUNK_SIZE;
+        if (resp.size() != st->chunkSize(0)) {
+            ok = false;
+        } else {
+            st->chunks[0].swap(resp);
+        }
+    }
+    return ok;
+}
+
+// Compares the fixed header and size of the master's file with the local
+// copy using a small range request.  Only returns true if the master's
+// file is known to be different, if it can't be fetched the local copy
+// is used as before.
+static bool LocalCopyDiffers(const std::string& url, const std::string& localPath) {
+    struct stat st;
+    if (stat(localPath.c_str(), &st) != 0) {
+        return true;
+    }
+    uint8_t header[HTTP_FSEQ_HEADER_CHECK_SIZE];
+    int len = 0;
+    int fd = open(localPath.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        len = pread(fd, header, sizeof(header), 0);
+        close(fd);
+    }
+    if (len <= 0) {
+        return true;
+    }
+
+    std::vector<uint8_t> resp;
+    uint64_t total = 0;
+    long rc = FetchStart(url, HTTP_FSEQ_HEADER_CHECK_SIZE, resp, total);
+    if (rc == 200 && !resp.empty() && resp.size() <= HTTP_FSEQ_HEADER_CHECK_SIZE) {
+        total = resp.size();
+    } else if (rc != 206 || !total) {
+        return false;
+    }
+    return total != (uint64_t)st.st_size || resp.size() != (size_t)len || memcmp(&resp[0], header, len) != 0;
+}
+
+HTTPFSEQSource::HTTPFSEQSource(std::shared_ptr<State> state) :
+    m_state(state) {
+    std::unique_lock<std::mutex> lock(m_state->lock);
+    m_state->readers++;
+}
+HTTPFSEQSource::~HTTPFSEQSource() {
+    std::unique_lock<std::mutex> lock(m_state->lock);
+    m_state->readers--;
+    DropChunks(m_state.get());
+}
+
+uint64_t HTTPFSEQSource::size() {
+    return m_state->size;
+}
+
+uint64_t HTTPFSEQSource::read(uint64_t pos, void* ptr, uint64_t size) {
+    State* st = m_state.get();
+    uint8_t* dst = (uint8_t*)ptr;
+    uint64_t total = 0;
+    long long timeout = GetTimeMS() + HTTP_FSEQ_READ_TIMEOUT_MS;
+
+    std::unique_lock<std::mutex> lock(st->lock);
+    while (total < size && pos < st->size) {
+        uint32_t chunk = pos / HTTP_FSEQ_CHUNK_SIZE;
+        uint32_t off = pos % HTTP_FSEQ_CHUNK_SIZE;
+        uint32_t len = std::min((uint64_t)(st->chunkSize(chunk) - off), size - total);
+        st->lastRead = chunk;
+
+        auto it = st->chunks.find(chunk);
+        if (it != st->chunks.end()) {
+            memcpy(dst + total, &it->second[off], len);
+        } else if (st->cacheFd >= 0 && st->saved[chunk]) {
+            if (pread(st->cacheFd, dst + total, len, pos) != (ssize_t)len) {
+                break;
+            }
+        } else if (GetTimeMS() > timeout) {
+            LogWarn(VB_SEQUENCE, "Timed out waiting for %s data at %" PRIu64 "\n", st->filename.c_str(), pos);
+            break;
+        } else {
+            int failures = st->failures;
+            lock.unlock();
+            if (failures) {
+                // don't hammer a master that is not responding
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            }
+            RequestChunk(m_state, chunk);
+            // nobody else may be processing the requests right now
+            CurlManager::INSTANCE.processCurls();
+            lock.lock();
+            st->signal.wait_for(lock, std::chrono::milliseconds(2));
+            continue;
+        }
+        total += len;
+        pos += len;
+    }
+    lock.unlock();
+
+    // keep the next chunks coming for sequential readers
+    preload(pos, HTTP_FSEQ_READ_AHEAD_CHUNKS * HTTP_FSEQ_CHUNK_SIZE);
+    return total;
+}
+
+void HTTPFSEQSource::preload(uint64_t pos, uint64_t size) {
+    if (pos >= m_state->size) {
+        return;
+    }
+    uint32_t first = pos / HTTP_FSEQ_CHUNK_SIZE;
+    uint32_t last = std::min(pos + size, m_state->size - 1) / HTTP_FSEQ_CHUNK_SIZE;
+    for (uint32_t chunk = first; chunk <= last; chunk++) {
+        RequestChunk(m_state, chunk);
+    }
+}
+
+FSEQFile* HTTPFSEQSource::OpenFromMaster(const std::string& filename, const std::string& localPath) {
+    int mode = getSettingInt("MultiSyncFetchSequences");
+    std::string master = multiSync->GetSyncMaster();
+    if (!mode || master.empty()) {
+        return nullptr;
+    }
+
+    std::shared_ptr<State> st = std::make_shared<State>();
+    char* escaped = curl_easy_escape(nullptr, filename.c_str(), filename.size());
+    st->url = "http://" + master + "/api/sequence/" + escaped;
+    curl_free(escaped);
+    st->filename = filename;
+    st->finalPath = FPP_DIR_SEQUENCE("/" + filename);
+    st->cachePath = FPP_DIR_MEDIA("/tmp/" + filename + ".part");
+
+    // only fetch from the master if the local copy is missing or stale
+    if (FileExists(localPath)) {
+        if (!LocalCopyDiffers(st->url, localPath)) {
+            return nullptr;
+        }
+        LogInfo(VB_SEQUENCE, "Local copy of %s differs from the master's\n", filename.c_str());
+    }
+    if (!FetchFirstChunk(st.get())) {
+        return nullptr;
+    }
+
+    // reuse a copy still being downloaded from an earlier play if it's
+    // the same file
+    std::unique_lock<std::mutex> dlock(downloadsLock);
+    auto it = downloads.find(st->finalPath);
+    if (it != downloads.end()) {
+        std::shared_ptr<State> old = it->second;
+        std::unique_lock<std::mutex> lock(old->lock);
+        if (old->url == st->url && old->size == st->size && old->chunks[0] == st->chunks[0]) {
+            lock.unlock();
+            st = old;
+        } else {
+            // master's file has changed, start over
+            if (old->cacheFd >= 0) {
+                close(old->cacheFd);
+                old->cacheFd = -1;
+            }
+            downloads.erase(it);
+        }
+    }
+    dlock.unlock();
+
+    FSEQFile* file = FSEQFile::openFSEQFile(filename, new HTTPFSEQSource(st));
+    if (!file) {
+        return nullptr;
+    }
+
+    std::unique_lock<std::mutex> lock(st->lock);
+    bool startCopy = (mode == 2) && (st->cacheFd < 0) && st->saved.empty();
+    if (startCopy) {
+        st->cacheFd = open(st->cachePath.c_str(), O_CREAT | O_TRUNC | O_RDWR, 0644);
+        if (st->cacheFd < 0 || ftruncate(st->cacheFd, st->size) != 0) {
+            LogWarn(VB_SEQUENCE, "Could not create %s: %s\n", st->cachePath.c_str(), strerror(errno));
+            startCopy = false;
+        } else {
+            st->saved.assign(st->numChunks, false);
+            if (pwrite(st->cacheFd, &st->chunks[0][0], st->chunks[0].size(), 0) == (ssize_t)st->chunks[0].size()) {
+                st->saved[0] = true;
+                st->savedCount = 1;
+            }
+            st->nextBackground = 1;
+        }
+    }
+    lock.unlock();
+    if (startCopy) {
+        dlock.lock();
+        downloads[st->finalPath] = st;
+        dlock.unlock();
+        if (st->savedCount == st->numChunks) {
+            FinishCopy(st);
+        } else {
+            RequestChunk(st, 1);
+        }
+    }
+
+    LogInfo(VB_SEQUENCE, "Playing %s from %s\n", filename.c_str(), st->url.c_str());
+    return file;
+}
@@ -0,0 +1,44 @@
+#pragma once
+/*
+ * This file is part of the Falcon Player (FPP) and is Copyright (C)
+ * 2013-2024 by the Falcon Player Developers.
+ *
+ * The Falcon Player (FPP) is free software, and is covered under
+ * multiple Open Source licenses.  Please see the included 'LICENSES'
+ * file for descriptions of what files are covered by each license.
+ *
+ * This source file is covered under the LGPL v2.1 as described in the
+ * included LICENSE.LGPL file.
+ */
+
+#include <memory>
+#include <string>
+
+#include "fseq/FSEQFile.h"
+
+// Reads a sequence from another FPP system using HTTP range requests via
+// the CurlManager.  The file is fetched in fixed size chunks, chunks
+// ahead of the playhead are requested when the FSEQ reader preloads them.
+// Optionally every chunk is written to a local copy which, once the
+// remaining chunks have been fetched in the background, replaces the
+// local sequence.
+class HTTPFSEQSource : public FSEQFileSource {
+public:
+    virtual ~HTTPFSEQSource();
+
+    virtual uint64_t size() override;
+    virtual uint64_t read(uint64_t pos, void* ptr, uint64_t size) override;
+    virtual void preload(uint64_t pos, uint64_t size) override;
+
+    // If enabled via the MultiSyncFetchSequences setting, open the sequence
+    // from the sync master when localPath is missing or is not the same
+    // sequence as the master's.  Returns nullptr to use the local file.
+    static FSEQFile* OpenFromMaster(const std::string& filename, const std::string& localPath);
+
+    class State;
+
+private:
+    HTTPFSEQSource(std::shared_ptr<State> state);
+
+    std::shared_ptr<State> m_state;
+};
@@ -0,0 +1,76 @@
+/*
+ * This file is part of the Falcon Player (FPP) and is Copyright (C)
+ * 2013-2022 by the Falcon Player Developers.
+ *
+ * The Falcon Player (FPP) is free software, and is covered under
+ * multiple Open Source licenses.  Please see the included 'LICENSES'
+ * file for descriptions of what files are covered by each license.
+ *
+ * This source file is covered under the LGPL v2.1 as described in the
+ * included LICENSE.LGPL file.
+ */
+
+#include "fpp-pch.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "MasterClock.h"
+
+// PLL gains for following the master's frame clock
+#define MASTER_CLOCK_PHASE_GAIN 8
+#define MASTER_CLOCK_FREQ_GAIN 128
+#define MASTER_CLOCK_MAX_RATE_ERROR 0.001
+
+// position changes larger than this (us) are a seek or new sequence
+#define MASTER_CLOCK_MAX_JUMP 100000
+
+bool MasterClockEstimator::addSample(long long t1, long long t2, long long t3, long long t4) {
+    if ((t4 - t1) > 1000000 || t4 < t1) {
+        return false;
+    }
+    long long d = std::max((t4 - t1) - (t3 - t2), 0LL);
+    long long o = ((t2 - t1) + (t3 - t4)) / 2;
+
+    samples[sampleCount % MAX_CLOCK_SAMPLES] = std::make_pair(o, d);
+    sampleCount++;
+
+    int count = std::min(sampleCount, MAX_CLOCK_SAMPLES);
+    int best = 0;
+    for (int x = 1; x < count; x++) {
+        if (samples[x].second < samples[best].second) {
+            best = x;
+        }
+    }
+    offset = samples[best].first;
+    delay = samples[best].second;
+    return true;
+}
+
+bool MasterClockPLL::update(long long sampleTime, long long position, long long& err) {
+    err = 0;
+    if (origin == 0) {
+        origin = sampleTime - position;
+        rate = 1.0;
+        lastSample = sampleTime;
+        return false;
+    }
+
+    long long predicted = (long long)((sampleTime - origin) * rate);
+    err = position - predicted;
+    if (std::abs(err) > MASTER_CLOCK_MAX_JUMP) {
+        // position jumped, keep the rate
+        origin = sampleTime - (long long)(position / rate);
+        lastSample = sampleTime;
+        return false;
+    }
+
+    long long interval = sampleTime - lastSample;
+    lastSample = sampleTime;
+    origin -= (long long)(err / rate) / MASTER_CLOCK_PHASE_GAIN;
+    if (interval > 0) {
+        rate += ((double)err / interval) / MASTER_CLOCK_FREQ_GAIN;
+        rate = std::clamp(rate, 1.0 - MASTER_CLOCK_MAX_RATE_ERROR, 1.0 + MASTER_CLOCK_MAX_RATE_ERROR);
+    }
+    return true;
+}
@@ -0,0 +1,67 @@
+#pragma once
+/*
+ * This file is part of the Falcon Player (FPP) and is Copyright (C)
+ * 2013-2022 by the Falcon Player Developers.
+ *
+ * The Falcon Player (FPP) is free software, and is covered under
+ * multiple Open Source licenses.  Please see the included 'LICENSES'
+ * file for descriptions of what files are covered by each license.
+ *
+ * This source file is covered under the LGPL v2.1 as described in the
+ * included LICENSE.LGPL file.
+ */
+
+#include <utility>
+
+#define MAX_CLOCK_SAMPLES 8
+
+// Estimates the offset between the master's clock and ours from NTP style
+// time request/reply exchanges.  The offset from the sample with the
+// shortest round trip out of the last MAX_CLOCK_SAMPLES is used as it has
+// the least queuing delay and thus is the most accurate.
+class MasterClockEstimator {
+public:
+    void reset() { sampleCount = 0; }
+
+    // t1 request sent, t2 request received by the master, t3 reply sent
+    // by the master, t4 reply received.  Returns false if the reply is
+    // stale or bogus and was ignored.
+    bool addSample(long long t1, long long t2, long long t3, long long t4);
+
+    bool isValid() const { return sampleCount >= 3; }
+    int getSampleCount() const { return sampleCount; }
+    long long getOffset() const { return offset; } // master clock - local clock
+    long long getDelay() const { return delay; }   // round trip network delay
+
+private:
+    std::pair<long long, long long> samples[MAX_CLOCK_SAMPLES]; // offset, delay
+    int sampleCount = 0;
+    long long offset = 0;
+    long long delay = 0;
+};
+
+// Follows the master's frame clock with a second order PLL fed by the
+// sync packets.  Each sample is the local time the master was at the
+// given position (us), either from the master's timestamp and the
+// estimated clock offset or just the packet receive time.  The phase term
+// absorbs network jitter, the frequency term tracks the difference
+// between the master's and our clock so frames stay on the master's
+// timeline between sync packets even when they are infrequent.
+class MasterClockPLL {
+public:
+    void reset() { origin = 0; }
+
+    // Returns false if the timeline was (re)started from this sample
+    // rather than adjusted, err is the error of the predicted position.
+    bool update(long long sampleTime, long long position, long long& err);
+
+    bool isValid() const { return origin != 0; }
+    // local time the master is at position
+    long long getLocalTime(long long position) const { return origin + (long long)(position / rate); }
+    double getRate() const { return rate; }
+
+private:
+    long long origin = 0; // local time (us) of master position 0, 0 if unknown
+    double rate = 1.0;    // master us per local us
+    long long lastSample = 0;
+};
@@ -47,6 +47,7 @@
 #include "Player.h"
 #include "Plugins.h"
 #include "Sequence.h"
+#include "SequenceStream.h"
 #include "command.h"
 #include "common.h"
 #include "falcon.h"
@@ -69,6 +70,7 @@ static uint32_t MULTISYNC_MULTICAST_ADD = inet_addr(MULTISYNC_MULTICAST_ADDRESS)
 
 NetInterfaceInfo::NetInterfaceInfo() :
     address(0),
+    netmask(0),
     broadcastAddress(0),
     multicastSocket(-1) {
 }
@@ -200,7 +202,10 @@ MultiSync::MultiSync() :
     m_lastCheckTime(0),
     m_lastFrame(0),
     m_sendMulticast(false),
-    m_sendBroadcast(false) {
+    m_sendBroadcast(false),
+    m_clockValid(false),
+    m_clockOffset(0),
+    m_clockDelay(0) {
     memset(rcvBuffers, 0, sizeof(rcvBuffers));
     memset(rcvCmbuf, 0, sizeof(rcvCmbuf));
 }
@@ -239,6 +244,9 @@ int MultiSync::Init(void) {
     if (m_multiSyncEnabled) {
         if (!OpenControlSockets())
             return 0;
+    } else if (getFPPmode() == REMOTE_MODE) {
+        if (!OpenRelaySockets())
+            return 0;
     }
 
     std::function<void(NetworkMonitor::NetEventType i, int up, const std::string&)> f = [this](NetworkMonitor::NetEventType i, int up, const std::string& name) {
@@ -756,6 +764,18 @@ Json::Value MultiSync::GetSyncStats() {
 
     result["masterIP"] = m_syncMaster;
     result["masterHostname"] = masterHostname;
+    if (m_syncHops) {
+        result["relayHops"] = m_syncHops;
+    }
+    if (m_clockValid) {
+        result["clockOffset"] = (Json::Int64)m_clockOffset;
+        result["clockDelay"] = (Json::Int64)m_clockDelay;
+    }
+    Json::Value stream;
+    SequenceStreamReceiver::INSTANCE.GetStats(stream);
+    if (!stream.empty()) {
+        result["sequenceStream"] = stream;
+    }
 
     return result;
 }
@@ -1267,6 +1287,8 @@ void MultiSync::SendSeqOpenPacket(const std::string& filename) {
     }
     m_lastFrame = -1;
     m_lastFrameSent = -1;
+    m_syncFastUntil = 32;
+    m_syncStableCount = 0;
 
     char outBuf[2048];
     bzero(outBuf, sizeof(outBuf));
@@ -1304,6 +1326,8 @@ void MultiSync::SendSeqSyncStartPacket(const std::string& filename) {
     }
     m_lastFrame = -1;
     m_lastFrameSent = -1;
+    m_syncFastUntil = 32;
+    m_syncStableCount = 0;
 
     char outBuf[2048];
     bzero(outBuf, sizeof(outBuf));
@@ -1363,11 +1387,87 @@ void MultiSync::SendSeqSyncStopPacket(const std::string& filename) {
 
     m_lastFrame = -1;
     m_lastFrameSent = -1;
+    m_syncFastUntil = 32;
+    m_syncStableCount = 0;
 }
 
 /*
  *
  */
+/*
+ * Offset of the optional trailers in a sync packet, after the filename
+ */
+static int GetSyncTrailerOffset(SyncPkt* spkt, int extraDataLen) {
+    int fnOffset = offsetof(SyncPkt, filename);
+    return fnOffset + strnlen(spkt->filename, extraDataLen - fnOffset) + 1;
+}
+
+/*
+ * Find an optional trailer in a sync packet by its marker
+ */
+static bool GetSyncTrailer(SyncPkt* spkt, int extraDataLen, const char* marker, void* data, int size) {
+    int offset = GetSyncTrailerOffset(spkt, extraDataLen);
+    while ((offset + 2) <= extraDataLen) {
+        const char* m = ((const char*)spkt) + offset;
+        int len = 0;
+        if (m[0] == 'T' && m[1] == 'S') {
+            len = sizeof(SyncPktTimestamp);
+        } else if (m[0] == 'R' && m[1] == 'H') {
+            len = sizeof(SyncPktRelay);
+        } else {
+            return false;
+        }
+        if ((offset + len) > extraDataLen) {
+            return false;
+        }
+        if (m[0] == marker[0] && m[1] == marker[1]) {
+            memcpy(data, m, size);
+            return true;
+        }
+        offset += len;
+    }
+    return false;
+}
+
+/*
+ * Relays mark the packets they forward with a SyncPktRelay trailer.  In
+ * sync packets it is with the other trailers after the filename, other
+ * packet types have it at the very end of the extra data with a zero
+ * pathDelay.  Plugin packets are passed through unmarked as the plugin
+ * gets all of the extra data.
+ */
+static bool GetRelayTrailer(ControlPkt* pkt, SyncPktRelay* rh) {
+    if (pkt->pktType == CTRL_PKT_SYNC) {
+        if (pkt->extraDataLen < sizeof(SyncPkt)) {
+            return false;
+        }
+        SyncPkt* spkt = (SyncPkt*)(((char*)pkt) + sizeof(ControlPkt));
+        return GetSyncTrailer(spkt, pkt->extraDataLen, "RH", rh, sizeof(SyncPktRelay));
+    }
+    if (pkt->pktType == CTRL_PKT_PLUGIN || pkt->extraDataLen < sizeof(SyncPktRelay)) {
+        return false;
+    }
+    const char* t = ((const char*)pkt) + sizeof(ControlPkt) + pkt->extraDataLen - sizeof(SyncPktRelay);
+    if (t[0] != 'R' || t[1] != 'H') {
+        return false;
+    }
+    memcpy(rh, t, sizeof(SyncPktRelay));
+    return rh->hops > 0 && rh->pathDelay == 0;
+}
+
+/*
+ * Add the master timestamp trailer to a sync packet, returns the new length
+ */
+static int AppendSyncTimestamp(ControlPkt* cpkt, int len) {
+    SyncPktTimestamp ts;
+    ts.marker[0] = 'T';
+    ts.marker[1] = 'S';
+    ts.masterTime = GetTimeMicros();
+    memcpy(((uint8_t*)cpkt) + len, &ts, sizeof(ts));
+    cpkt->extraDataLen += sizeof(ts);
+    return len + sizeof(ts);
+}
+
 void MultiSync::SendSeqSyncPacket(const std::string& filename, int frames, float seconds) {
     if (filename.empty()) {
         return;
@@ -1379,14 +1479,29 @@ void MultiSync::SendSeqSyncPacket(const std::string& filename, int frames, float
     for (auto a : m_plugins) {
         a->SendSeqSyncPacket(filename, frames, seconds);
     }
+    if (frames != m_lastFrame + 1) {
+        // seek or frame skip, resync the remotes quickly
+        m_syncFastUntil = frames + 32;
+        m_syncStableCount = 0;
+        m_lastFrameSent = -1;
+    }
     m_lastFrame = frames;
     int diff = frames - m_lastFrameSent;
-    if (frames > 32) {
+    if (m_lastFrameSent < 0) {
+        // always send right away after a discontinuity
+    } else if (frames > m_syncFastUntil) {
         // after 32 frames, we send every 10
         //  that's either twice a second (50ms sequences) or 4 times (25ms)
-        if (diff < 10) {
+        // once the remotes have had a while to lock onto our frame clock
+        // back off to about twice a second regardless of the frame rate
+        int interval = 10;
+        if (m_syncStableCount >= SYNC_STABLE_PACKETS) {
+            interval = std::max(interval, SYNC_STABLE_INTERVAL / std::max(sequence->GetSeqStepTime(), 1));
+        }
+        if (diff < interval) {
             return;
         }
+        m_syncStableCount++;
     } else if (frames && diff < 4) {
         // under 32 frames, we send every 4
         return;
@@ -1412,7 +1527,8 @@ void MultiSync::SendSeqSyncPacket(const std::string& filename, int frames, float
     spkt->secondsElapsed = seconds;
     strcpy(spkt->filename, filename.c_str());
 
-    SendControlPacket(outBuf, sizeof(ControlPkt) + sizeof(SyncPkt) + filename.length());
+    int len = AppendSyncTimestamp(cpkt, sizeof(ControlPkt) + sizeof(SyncPkt) + filename.length());
+    SendControlPacket(outBuf, len);
 }
 
 void MultiSync::SendMediaOpenPacket(const std::string& filename) {
@@ -1569,7 +1685,8 @@ void MultiSync::SendMediaSyncPacket(const std::string& filename, float seconds)
     spkt->secondsElapsed = seconds;
     strcpy(spkt->filename, filename.c_str());
 
-    SendControlPacket(outBuf, sizeof(ControlPkt) + sizeof(SyncPkt) + filename.length());
+    int len = AppendSyncTimestamp(cpkt, sizeof(ControlPkt) + sizeof(SyncPkt) + filename.length());
+    SendControlPacket(outBuf, len);
 }
 
 void MultiSync::SendPluginData(const std::string& name, const uint8_t* data, int len) {
@@ -1698,8 +1815,7 @@ int MultiSync::OpenBroadcastSocket(void) {
 /*
  *
  */
-int MultiSync::OpenControlSockets() {
-    LogDebug(VB_SYNC, "OpenControlSockets()\n");
+int MultiSync::OpenControlSocket() {
     if (m_controlSock >= 0) {
         return 1;
     }
@@ -1717,18 +1833,15 @@ int MultiSync::OpenControlSockets() {
                strerror(errno));
         return 0;
     }
+    return 1;
+}
 
-    std::string remotesString = getSetting("MultiSyncRemotes");
-    std::string extraRemotes = getSetting("MultiSyncExtraRemotes");
-    if (extraRemotes != "") {
-        if (remotesString == "") {
-            remotesString = extraRemotes;
-        } else {
-            remotesString += ",";
-            remotesString += extraRemotes;
-        }
-    }
-
+/*
+ * Resolve a comma separated list of remotes and setup the messages
+ * to send to them via sendmmsg
+ */
+void MultiSync::AddDestinations(const std::string& remotesString, std::vector<struct sockaddr_in>& addrs,
+                                std::vector<struct mmsghdr>& msgs, struct iovec* iov) {
     std::vector<std::string> tokens = split(remotesString, ',');
     std::set<std::string> remotes;
     for (auto& token : tokens) {
@@ -1738,17 +1851,6 @@ int MultiSync::OpenControlSockets() {
         }
     }
 
-    if (getSettingInt("MultiSyncBroadcast")) {
-        m_sendBroadcast = true;
-    }
-
-    if (getSettingInt("MultiSyncMulticast")) {
-        m_sendMulticast = true;
-    }
-    if (remotesString == "" && m_multiSyncEnabled) {
-        m_sendMulticast = true;
-    }
-
     for (auto& s : remotes) {
         LogDebug(VB_SYNC, "Setting up Remote Sync for %s\n", s.c_str());
         struct sockaddr_in newRemote;
@@ -1772,61 +1874,127 @@ int MultiSync::OpenControlSockets() {
             newRemote.sin_addr.s_addr = inet_addr(s.c_str());
         }
         if (valid) {
-            m_destAddr.push_back(newRemote);
+            addrs.push_back(newRemote);
         }
     }
-    for (int x = 0; x < m_destAddr.size(); x++) {
+    msgs.clear();
+    for (int x = 0; x < addrs.size(); x++) {
         struct mmsghdr msg;
         memset(&msg, 0, sizeof(msg));
 
-        msg.msg_hdr.msg_name = &m_destAddr[x];
+        msg.msg_hdr.msg_name = &addrs[x];
         msg.msg_hdr.msg_namelen = sizeof(sockaddr_in);
-        msg.msg_hdr.msg_iov = &m_destIovec;
+        msg.msg_hdr.msg_iov = iov;
         msg.msg_hdr.msg_iovlen = 1;
         msg.msg_len = 0;
-        m_destMsgs.push_back(msg);
+        msgs.push_back(msg);
+    }
+}
+
+/*
+ *
+ */
+int MultiSync::OpenControlSockets() {
+    LogDebug(VB_SYNC, "OpenControlSockets()\n");
+    if (m_controlSock >= 0) {
+        return 1;
+    }
+
+    if (!OpenControlSocket()) {
+        return 0;
+    }
+
+    std::string remotesString = getSetting("MultiSyncRemotes");
+    std::string extraRemotes = getSetting("MultiSyncExtraRemotes");
+    if (extraRemotes != "") {
+        if (remotesString == "") {
+            remotesString = extraRemotes;
+        } else {
+            remotesString += ",";
+            remotesString += extraRemotes;
+        }
+    }
+
+    if (getSettingInt("MultiSyncBroadcast")) {
+        m_sendBroadcast = true;
+    }
+
+    if (getSettingInt("MultiSyncMulticast")) {
+        m_sendMulticast = true;
+    }
+    if (remotesString == "" && m_multiSyncEnabled) {
+        m_sendMulticast = true;
     }
 
+    AddDestinations(remotesString, m_destAddr, m_destMsgs, &m_destIovec);
+
     LogDebug(VB_SYNC, "%d Remote Sync systems configured\n",
              m_destAddr.size());
     FillInInterfaces();
     return 1;
 }
 
-void MultiSync::SendControlPacket(void* outBuf, int len) {
-    if (WillLog(LOG_EXCESSIVE, VB_SYNC)) {
-        LogExcess(VB_SYNC, "SendControlPacket()\n");
-        HexDump("Sending Control packet with contents:", outBuf, len, VB_SYNC);
+/*
+ * Setup the downstream remotes on a remote acting as a relay
+ */
+int MultiSync::OpenRelaySockets() {
+    std::string relayRemotes = getSetting("MultiSyncRelayRemotes");
+    m_relayMulticast = getSettingInt("MultiSyncRelayMulticast");
+    if (relayRemotes == "" && !m_relayMulticast) {
+        return 1;
+    }
+
+    if (!OpenControlSocket()) {
+        return 0;
     }
 
-    int msgCount = m_destMsgs.size();
-    if (msgCount != 0) {
-        m_destIovec.iov_base = outBuf;
-        m_destIovec.iov_len = len;
+    AddDestinations(relayRemotes, m_relayAddr, m_relayMsgs, &m_relayIovec);
+    m_relayEnabled = true;
 
-        std::unique_lock<std::mutex> lock(m_socketLock);
-        int oc = sendmmsg(m_controlSock, &m_destMsgs[0], msgCount, MSG_DONTWAIT);
-        int outputCount = oc;
-        long long startTime = GetTimeMS();
-        while (oc >= 0 && outputCount != msgCount) {
-            int oc = sendmmsg(m_controlSock, &m_destMsgs[outputCount], msgCount - outputCount, MSG_DONTWAIT);
-            if (oc > 0) {
-                outputCount += oc;
+    LogInfo(VB_SYNC, "Relaying MultiSync to %d remotes%s\n",
+            m_relayAddr.size(), m_relayMulticast ? " and via multicast" : "");
+    return 1;
+}
+
+void MultiSync::SendToDestinations(std::vector<struct mmsghdr>& msgs, struct iovec& iov, void* outBuf, int len) {
+    int msgCount = msgs.size();
+    if (msgCount == 0) {
+        return;
+    }
+    iov.iov_base = outBuf;
+    iov.iov_len = len;
+
+    std::unique_lock<std::mutex> lock(m_socketLock);
+    int oc = sendmmsg(m_controlSock, &msgs[0], msgCount, MSG_DONTWAIT);
+    int outputCount = oc;
+    long long startTime = GetTimeMS();
+    while (oc >= 0 && outputCount != msgCount) {
+        int oc = sendmmsg(m_controlSock, &msgs[outputCount], msgCount - outputCount, MSG_DONTWAIT);
+        if (oc > 0) {
+            outputCount += oc;
+        } else {
+            long long tm = GetTimeMS();
+            long long totalTime = tm - startTime;
+            if (totalTime < 10) {
+                // we'll keep trying for up to 15ms, but give the network stack some time to flush some buffers
+                std::this_thread::sleep_for(std::chrono::microseconds(250));
             } else {
-                long long tm = GetTimeMS();
-                long long totalTime = tm - startTime;
-                if (totalTime < 10) {
-                    // we'll keep trying for up to 15ms, but give the network stack some time to flush some buffers
-                    std::this_thread::sleep_for(std::chrono::microseconds(250));
-                } else {
-                    oc = -1;
-                }
+                oc = -1;
             }
         }
-        if (outputCount != msgCount) {
-            LogErr(VB_SYNC, "Error: Unable to send multisync packet: %s   (%d/%d)\n", strerror(errno), outputCount, msgCount);
-        }
     }
+    if (outputCount != msgCount) {
+        LogErr(VB_SYNC, "Error: Unable to send multisync packet: %s   (%d/%d)\n", strerror(errno), outputCount, msgCount);
+    }
+}
+
+void MultiSync::SendControlPacket(void* outBuf, int len) {
+    if (WillLog(LOG_EXCESSIVE, VB_SYNC)) {
+        LogExcess(VB_SYNC, "SendControlPacket()\n");
+        HexDump("Sending Control packet with contents:", outBuf, len, VB_SYNC);
+    }
+
+    SendToDestinations(m_destMsgs, m_destIovec, outBuf, len);
     if (m_sendMulticast) {
         SendMulticastPacket(outBuf, len);
     }
@@ -1851,9 +2019,12 @@ void MultiSync::SendBroadcastPacket(void* outBuf, int len) {
             LogErr(VB_SYNC, "Error: Unable to send packet: %s\n", strerror(errno));
     }
 }
-void MultiSync::SendMulticastPacket(void* outBuf, int len) {
+void MultiSync::SendMulticastPacket(void* outBuf, int len, in_addr_t skipSubnetOf) {
     std::unique_lock<std::mutex> lock(m_socketLock);
     for (auto& a : m_interfaces) {
+        if (skipSubnetOf && a.second.netmask && ((a.second.address ^ skipSubnetOf) & a.second.netmask) == 0) {
+            continue;
+        }
         struct sockaddr_in bda;
         memset((void*)&bda, 0, sizeof(struct sockaddr_in));
         bda.sin_family = AF_INET;
@@ -1946,6 +2117,7 @@ bool MultiSync::FillInInterfaces() {
                 info.interfaceName = tmp->ifa_name;
                 info.interfaceAddress = inet_ntoa(sa->sin_addr);
                 info.address = sa->sin_addr.s_addr;
+                info.netmask = tmp->ifa_netmask ? ((struct sockaddr_in*)(tmp->ifa_netmask))->sin_addr.s_addr : 0xFFFFFFFF;
                 info.broadcastAddress = ba->sin_addr.s_addr;
             }
         } else if (tmp->ifa_addr && tmp->ifa_addr->sa_family == AF_INET6) {
@@ -2029,6 +2201,11 @@ int MultiSync::OpenReceiveSocket(void) {
         LogErr(VB_SYNC, "Error calling setsockopt; %s\n", strerror(errno));
         return 0;
     }
+    // kernel receive timestamps for the clock offset estimation, falls
+    // back to the time the packet is processed if not available
+    if (setsockopt(m_receiveSock, SOL_SOCKET, SO_TIMESTAMP, &optval, sizeof(optval)) < 0) {
+        LogDebug(VB_SYNC, "Could not enable SO_TIMESTAMP; %s\n", strerror(errno));
+    }
 
     if (getFPPmode() == REMOTE_MODE) {
         int remoteOffsetInt = getSettingInt("remoteOffset");
@@ -2111,7 +2288,11 @@ void MultiSync::ProcessControlPacket(bool pingOnly) {
 
     ControlPkt* pkt;
 
+    for (int i = 0; i < MAX_MS_RCV_MSG; i++) {
+        rcvMsgs[i].msg_hdr.msg_controllen = 0x100;
+    }
     int msgcnt = recvmmsg(m_receiveSock, rcvMsgs, MAX_MS_RCV_MSG, MSG_DONTWAIT, nullptr);
+    long long processTime = GetTimeMicros();
     while (msgcnt > 0) {
         std::vector<unsigned char*> v;
         for (int msg = 0; msg < msgcnt; msg++) {
@@ -2218,6 +2399,25 @@ void MultiSync::ProcessControlPacket(bool pingOnly) {
                 HexDump("Received MultiSync packet with contents:", (void*)inBuf, len, VB_SYNC);
             }
 
+            m_rcvTime = processTime;
+            for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&rcvMsgs[msg].msg_hdr); cmsg != NULL; cmsg = CMSG_NXTHDR(&rcvMsgs[msg].msg_hdr, cmsg)) {
+                if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMP) {
+                    struct timeval tv;
+                    memcpy(&tv, CMSG_DATA(cmsg), sizeof(tv));
+                    m_rcvTime = tv.tv_sec * 1000000LL + tv.tv_usec;
+                }
+            }
+
+            if (!pingOnly && !isLocal && getFPPmode() == REMOTE_MODE && !AcceptFromSyncSource(pkt, sourceIP)) {
+                LogExcess(VB_SYNC, "Dropping type %d packet from %s, using %s as the master\n",
+                          pkt->pktType, sourceIP.c_str(), m_syncMaster.c_str());
+                continue;
+            }
+
+            if (m_relayEnabled && !pingOnly && !isLocal) {
+                RelayControlPacket(pkt, len, sourceIP);
+            }
+
             if (!pingOnly || pkt->pktType == CTRL_PKT_PING) {
                 switch (pkt->pktType) {
                 case CTRL_PKT_CMD:
@@ -2245,10 +2445,17 @@ void MultiSync::ProcessControlPacket(bool pingOnly) {
                 case CTRL_PKT_FPPCOMMAND:
                     ProcessFPPCommandPacket(pkt, len, stats);
                     break;
+                case CTRL_PKT_TIME:
+                    ProcessTimePacket(pkt, len, sourceIP, stats);
+                    break;
                 }
             }
         }
+        for (int i = 0; i < MAX_MS_RCV_MSG; i++) {
+            rcvMsgs[i].msg_hdr.msg_controllen = 0x100;
+        }
         msgcnt = recvmmsg(m_receiveSock, rcvMsgs, MAX_MS_RCV_MSG, MSG_DONTWAIT, nullptr);
+        processTime = GetTimeMicros();
     }
 }
 
@@ -2428,7 +2635,15 @@ void MultiSync::ProcessSyncPacket(ControlPkt* pkt, int len, MultiSyncStats* stat
         return;
     }
 
-    m_syncMaster = stats->sourceIP;
+    if (m_syncMaster != m_clockMaster) {
+        ResetClockEstimate();
+        m_clockMaster = m_syncMaster;
+        SequenceStreamReceiver::INSTANCE.SetSyncMaster(m_syncMaster);
+    }
+    long long now = GetTimeMicros();
+    if ((now - m_lastTimeRequest) > (m_clock.getSampleCount() < MAX_CLOCK_SAMPLES ? 250000 : 2000000)) {
+        SendTimeRequest(m_syncMaster);
+    }
 
     SyncPkt* spkt = (SyncPkt*)(((char*)pkt) + sizeof(ControlPkt));
 
@@ -2436,6 +2651,8 @@ void MultiSync::ProcessSyncPacket(ControlPkt* pkt, int len, MultiSyncStats* stat
              spkt->filename, spkt->pktType, spkt->fileType, spkt->frameNumber, spkt->secondsElapsed);
 
     float secondsElapsed = 0.0;
+    float masterPosition = 0.0;
+    long long sampleTime = 0;
 
     if (spkt->fileType == SYNC_FILE_SEQ) {
         switch (spkt->pktType) {
@@ -2453,11 +2670,16 @@ void MultiSync::ProcessSyncPacket(ControlPkt* pkt, int len, MultiSyncStats* stat
             break;
         case SYNC_PKT_SYNC:
             secondsElapsed = spkt->secondsElapsed - m_remoteOffset;
+            masterPosition = secondsElapsed;
+            AdjustForMasterClock(spkt, pkt->extraDataLen, secondsElapsed, sampleTime);
             if (secondsElapsed < 0)
                 secondsElapsed = 0.0;
 
             SyncSyncedSequence(spkt->filename,
                                spkt->frameNumber, secondsElapsed);
+            if (sequence->IsSequenceRunning(spkt->filename)) {
+                UpdateMasterTimeline(sampleTime, masterPosition);
+            }
             stats->pktSyncSeqSync++;
             break;
         }
@@ -2477,6 +2699,7 @@ void MultiSync::ProcessSyncPacket(ControlPkt* pkt, int len, MultiSyncStats* stat
             break;
         case SYNC_PKT_SYNC:
             secondsElapsed = spkt->secondsElapsed - m_remoteOffset;
+            AdjustForMasterClock(spkt, pkt->extraDataLen, secondsElapsed, sampleTime);
             if (secondsElapsed < 0)
                 secondsElapsed = 0.0;
 
@@ -2488,6 +2711,267 @@ void MultiSync::ProcessSyncPacket(ControlPkt* pkt, int len, MultiSyncStats* stat
     }
 }
 
+/*
+ * If the master included its timestamp and we have a clock offset
+ * estimate, move the master position forward by the time the packet
+ * spent in transit.  Otherwise only the delay reported by relays is
+ * accounted for.  sampleTime is set to the local time the master sampled
+ * its position, or the receive time if that isn't known.
+ */
+bool MultiSync::AdjustForMasterClock(SyncPkt* spkt, int extraDataLen, float& secondsElapsed, long long& sampleTime) {
+    // relays tell us how long ago the master sampled its position
+    SyncPktRelay rh;
+    long long pathDelay = 0;
+    if (GetSyncTrailer(spkt, extraDataLen, "RH", &rh, sizeof(rh))) {
+        pathDelay = rh.pathDelay;
+    }
+    sampleTime = m_rcvTime - pathDelay;
+    if (!m_clockValid) {
+        secondsElapsed += pathDelay / 1000000.0f;
+        return false;
+    }
+    SyncPktTimestamp ts;
+    if (!GetSyncTrailer(spkt, extraDataLen, "TS", &ts, sizeof(ts))) {
+        secondsElapsed += pathDelay / 1000000.0f;
+        return false;
+    }
+
+    // local time when the master sampled its position
+    long long masterSampleTime = (long long)ts.masterTime - m_clockOffset;
+    long long transit = GetTimeMicros() - masterSampleTime;
+    if (transit < 0 || transit > 1000000) {
+        // estimate is off (clock stepped?), start over
+        LogDebug(VB_SYNC, "Sync packet transit time of %lldus is out of range, resetting clock offset estimate\n", transit);
+        ResetClockEstimate();
+        secondsElapsed += pathDelay / 1000000.0f;
+        return false;
+    }
+    sampleTime = masterSampleTime;
+    secondsElapsed += transit / 1000000.0f;
+    return true;
+}
+
+/*
+ * Remotes can hear the master directly and through relays, or through
+ * more than one relay.  Stick with one source for sync packets, only
+ * moving to one fewer hops from the master or when the current one has
+ * gone quiet, and drop relayed copies of other packets from everyone else
+ * so commands aren't run twice.  Sets m_syncMaster.
+ */
+bool MultiSync::AcceptFromSyncSource(ControlPkt* pkt, const std::string& sourceIP) {
+    SyncPktRelay rh;
+    bool relayed = GetRelayTrailer(pkt, &rh);
+    if (pkt->pktType != CTRL_PKT_SYNC) {
+        return !relayed || m_syncMaster.empty() || sourceIP == m_syncMaster;
+    }
+    if (pkt->extraDataLen < sizeof(SyncPkt)) {
+        // ProcessSyncPacket will count the error
+        return true;
+    }
+
+    uint8_t hops = relayed ? rh.hops : 0;
+    long long now = GetTimeMS();
+    if (sourceIP != m_syncMaster) {
+        if (!m_syncMaster.empty() && hops >= m_syncHops && (now - m_syncMasterLastSeen) < SYNC_MASTER_TIMEOUT) {
+            return false;
+        }
+        LogInfo(VB_SYNC, "Using %s as the MultiSync master, %d relays away\n", sourceIP.c_str(), hops);
+        m_syncMaster = sourceIP;
+    }
+    m_syncHops = hops;
+    m_syncMasterLastSeen = now;
+    return true;
+}
+
+/*
+ * Only forward packets from our master so relays sending to each other
+ * don't loop.  Until we know the master, accept sync packets (limited by
+ * the hop count) and anything from a system in player mode sending
+ * MultiSync.
+ */
+bool MultiSync::IsRelayUpstream(const std::string& sourceIP, uint8_t pktType) {
+    in_addr_t addr = inet_addr(sourceIP.c_str());
+    for (auto& a : m_relayAddr) {
+        if (a.sin_addr.s_addr == addr) {
+            return false;
+        }
+    }
+    if (sourceIP == m_syncMaster) {
+        return true;
+    }
+    if (!m_syncMaster.empty()) {
+        return false;
+    }
+    if (pktType == CTRL_PKT_SYNC) {
+        return true;
+    }
+    std::unique_lock<std::recursive_mutex> lock(m_systemsLock);
+    for (auto& sys : m_remoteSystems) {
+        if (sys.address == sourceIP) {
+            return sys.fppMode == PLAYER_MODE && sys.sendingMultiSync;
+        }
+    }
+    return false;
+}
+
+/*
+ * Re-send a packet from the master to the downstream remotes.  Sync
+ * packets get the relay trailer with the hop count and the time since
+ * the master sampled its position, and their timestamp is converted to
+ * our clock as downstream remotes estimate their clock offset against us.
+ */
+void MultiSync::RelayControlPacket(ControlPkt* pkt, int len, const std::string& sourceIP) {
+    switch (pkt->pktType) {
+    case CTRL_PKT_CMD:
+    case CTRL_PKT_SYNC:
+    case CTRL_PKT_BLANK:
+    case CTRL_PKT_PLUGIN:
+    case CTRL_PKT_FPPCOMMAND:
+        break;
+    default:
+        return;
+    }
+    if (!IsRelayUpstream(sourceIP, pkt->pktType)) {
+        return;
+    }
+
+    char outBuf[MAX_MS_RCV_BUFSIZE + sizeof(SyncPktTimestamp) + sizeof(SyncPktRelay)];
+    if (pkt->pktType == CTRL_PKT_SYNC) {
+        if (pkt->extraDataLen < sizeof(SyncPkt)) {
+            return;
+        }
+        SyncPkt* spkt = (SyncPkt*)(((char*)pkt) + sizeof(ControlPkt));
+        SyncPktRelay rh;
+        if (!GetSyncTrailer(spkt, pkt->extraDataLen, "RH", &rh, sizeof(rh))) {
+            rh.hops = 0;
+            rh.pathDelay = 0;
+        }
+        if (rh.hops >= MAX_RELAY_HOPS) {
+            LogDebug(VB_SYNC, "Not relaying sync packet from %s, already relayed %d times\n", sourceIP.c_str(), rh.hops);
+            return;
+        }
+
+        int trailerOffset = GetSyncTrailerOffset(spkt, pkt->extraDataLen);
+        if (trailerOffset > pkt->extraDataLen) {
+            return;
+        }
+        len = sizeof(ControlPkt) + trailerOffset;
+        memcpy(outBuf, pkt, len);
+        ControlPkt* cpkt = (ControlPkt*)outBuf;
+        cpkt->extraDataLen = trailerOffset;
+
+        if (spkt->pktType == SYNC_PKT_SYNC) {
+            long long sampleTime = m_rcvTime - rh.pathDelay;
+            SyncPktTimestamp ts;
+            if (m_clockValid && GetSyncTrailer(spkt, pkt->extraDataLen, "TS", &ts, sizeof(ts))) {
+                sampleTime = (long long)ts.masterTime - m_clockOffset;
+            }
+            long long now = GetTimeMicros();
+            rh.pathDelay = std::clamp(now - sampleTime, 0LL, 1000000LL);
+
+            ts.marker[0] = 'T';
+            ts.marker[1] = 'S';
+            ts.masterTime = now - rh.pathDelay;
+            memcpy(outBuf + len, &ts, sizeof(ts));
+            len += sizeof(ts);
+        }
+        rh.marker[0] = 'R';
+        rh.marker[1] = 'H';
+        rh.hops++;
+        memcpy(outBuf + len, &rh, sizeof(rh));
+        len += sizeof(rh);
+        cpkt->extraDataLen = len - sizeof(ControlPkt);
+    } else if (pkt->pktType == CTRL_PKT_PLUGIN) {
+        memcpy(outBuf, pkt, len);
+    } else {
+        // mark it so remotes that also hear the master drop this copy
+        SyncPktRelay rh;
+        if (GetRelayTrailer(pkt, &rh)) {
+            if (rh.hops >= MAX_RELAY_HOPS) {
+                return;
+            }
+            len -= sizeof(rh);
+        } else {
+            rh.hops = 0;
+        }
+        memcpy(outBuf, pkt, len);
+        rh.marker[0] = 'R';
+        rh.marker[1] = 'H';
+        rh.hops++;
+        rh.pathDelay = 0;
+        memcpy(outBuf + len, &rh, sizeof(rh));
+        len += sizeof(rh);
+        ((ControlPkt*)outBuf)->extraDataLen = len - sizeof(ControlPkt);
+    }
+
+    if (WillLog(LOG_EXCESSIVE, VB_SYNC)) {
+        HexDump("Relaying Control packet with contents:", outBuf, len, VB_SYNC);
+    }
+    SendToDestinations(m_relayMsgs, m_relayIovec, outBuf, len);
+    if (m_relayMulticast) {
+        // not back onto the network the master is on
+        SendMulticastPacket(outBuf, len, inet_addr(sourceIP.c_str()));
+    }
+}
+
+void MultiSync::ResetClockEstimate() {
+    m_clock.reset();
+    m_clockValid = false;
+    m_lastTimeRequest = 0;
+}
+
+void MultiSync::SendTimeRequest(const std::string& address) {
+    char outBuf[sizeof(ControlPkt) + sizeof(TimePkt)];
+    bzero(outBuf, sizeof(outBuf));
+
+    ControlPkt* cpkt = (ControlPkt*)outBuf;
+    InitControlPacket(cpkt);
+    cpkt->pktType = CTRL_PKT_TIME;
+    cpkt->extraDataLen = sizeof(TimePkt);
+
+    TimePkt tpkt;
+    memset(&tpkt, 0, sizeof(tpkt));
+    tpkt.pktType = TIME_PKT_REQUEST;
+    m_lastTimeRequest = GetTimeMicros();
+    tpkt.originateTime = m_lastTimeRequest;
+    memcpy(outBuf + sizeof(ControlPkt), &tpkt, sizeof(tpkt));
+
+    SendUnicastPacket(address, outBuf, sizeof(outBuf));
+}
+
+void MultiSync::ProcessTimePacket(ControlPkt* pkt, int len, const std::string& srcIp, MultiSyncStats* stats) {
+    if (pkt->extraDataLen < sizeof(TimePkt)) {
+        LogErr(VB_SYNC, "Error: Invalid length of received time packet\n");
+        stats->pktError++;
+        return;
+    }
+    stats->pktTime++;
+
+    TimePkt tpkt;
+    memcpy(&tpkt, ((uint8_t*)pkt) + sizeof(ControlPkt), sizeof(tpkt));
+    if (tpkt.pktType == TIME_PKT_REQUEST) {
+        tpkt.pktType = TIME_PKT_REPLY;
+        tpkt.receiveTime = m_rcvTime;
+        tpkt.transmitTime = GetTimeMicros();
+        memcpy(((uint8_t*)pkt) + sizeof(ControlPkt), &tpkt, sizeof(tpkt));
+        SendUnicastPacket(srcIp, pkt, sizeof(ControlPkt) + sizeof(TimePkt));
+        return;
+    }
+    if (tpkt.pktType != TIME_PKT_REPLY || srcIp != m_clockMaster) {
+        return;
+    }
+
+    if (!m_clock.addSample(tpkt.originateTime, tpkt.receiveTime, tpkt.transmitTime, m_rcvTime)) {
+        // stale or bogus reply
+        return;
+    }
+    m_clockOffset = m_clock.getOffset();
+    m_clockDelay = m_clock.getDelay();
+    m_clockValid = m_clock.isValid();
+    LogExcess(VB_SYNC, "Clock sample %d, using offset: %lldus  delay: %lldus\n",
+              m_clock.getSampleCount(), (long long)m_clockOffset, (long long)m_clockDelay);
+}
+
 /*
  *
  */
@@ -2741,6 +3225,7 @@ MultiSyncStats::MultiSyncStats(std::string ip, std::string host) :
     pktPing(0),
     pktPlugin(0),
     pktFPPCommand(0),
+    pktTime(0),
     pktError(0) {
     lastReceiveTime = time(NULL);
 }
@@ -2773,6 +3258,7 @@ Json::Value MultiSyncStats::toJSON() {
     result["pktPing"] = pktPing;
     result["pktPlugin"] = pktPlugin;
     result["pktFPPCommand"] = pktFPPCommand;
+    result["pktTime"] = pktTime;
     result["pktError"] = pktError;
 
     return result;
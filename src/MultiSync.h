@@ -13,10 +13,12 @@
 
 #include <netinet/in.h>
 #include <sys/types.h>
+#include <atomic>
 #include <mutex>
 #include <pthread.h>
 #include <set>
 
+#include "MasterClock.h"
 #include "SysSocket.h"
 #include "settings.h"
 
@@ -29,6 +31,12 @@
 #define CTRL_PKT_PING 4
 #define CTRL_PKT_PLUGIN 5
 #define CTRL_PKT_FPPCOMMAND 6
+#define CTRL_PKT_TIME 7
+
+// Once this many sequence sync packets have been sent without a seek or
+// frame skip, the master reduces the sync rate to one per interval (ms)
+#define SYNC_STABLE_PACKETS 20
+#define SYNC_STABLE_INTERVAL 500
 
 typedef struct __attribute__((packed)) {
     char fppd[4];          // 'FPPD'
@@ -57,6 +65,43 @@ typedef struct __attribute__((packed)) {
                           // (data may continue past this header)
 } SyncPkt;
 
+// Optional trailer after the filename's null in SYNC_PKT_SYNC packets
+// holding the master's clock (GetTimeMicros()) when the position was
+// sampled.  Older remotes ignore it.
+typedef struct __attribute__((packed)) {
+    char marker[2]; // 'TS'
+    uint64_t masterTime;
+} SyncPktTimestamp;
+
+// Optional trailer added by relays to sync packets, after the timestamp
+// trailer if present.  pathDelay is the time from the master sampling its
+// position to the last relay sending the packet.
+typedef struct __attribute__((packed)) {
+    char marker[2];     // 'RH'
+    uint8_t hops;       // Number of relays the packet has passed through
+    uint32_t pathDelay; // Microseconds
+} SyncPktRelay;
+
+#define MAX_RELAY_HOPS 4
+
+// A remote sticks with the system it gets sync packets from, only taking
+// sync from another one (ex: a relay) if it is fewer hops from the master
+// or nothing has been heard from the current one for this long (ms)
+#define SYNC_MASTER_TIMEOUT 30000
+
+#define TIME_PKT_REQUEST 0
+#define TIME_PKT_REPLY 1
+
+// NTP style timestamp exchange used by remotes to estimate the clock
+// offset to the master and the network delay.  Times are in microseconds,
+// each on the clock of the system that filled it in.
+typedef struct __attribute__((packed)) {
+    uint8_t pktType;        // Time Packet Type
+    uint64_t originateTime; // Remote time the request was sent
+    uint64_t receiveTime;   // Master time the request was received
+    uint64_t transmitTime;  // Master time the reply was sent
+} TimePkt;
+
 typedef enum systemType {
     kSysTypeUnknown = 0x00,
     kSysTypeFPP = 0x01,
@@ -171,6 +216,7 @@ public:
     uint32_t pktPing;
     uint32_t pktPlugin;
     uint32_t pktFPPCommand;
+    uint32_t pktTime;
     uint32_t pktError;
 };
 
@@ -204,6 +250,7 @@ public:
     std::string interfaceName;
     std::string interfaceAddress;
     uint32_t address;
+    uint32_t netmask;
     uint32_t broadcastAddress;
     int multicastSocket;
 };
@@ -286,6 +333,7 @@ public:
 
     [[nodiscard]] std::vector<MultiSyncSystem> const& GetLocalSystems() { return m_localSystems; }
     [[nodiscard]] std::vector<MultiSyncSystem> const& GetRemoteSystems() { return m_remoteSystems; }
+    [[nodiscard]] const std::string& GetSyncMaster() const { return m_syncMaster; }
 
 private:
     bool isSupportedForMultisync(const char* address, const char* intface);
@@ -301,8 +349,12 @@ private:
     int OpenBroadcastSocket(void);
     void SendBroadcastPacket(void* outBuf, int len);
     void SendControlPacket(void* outBuf, int len);
-    void SendMulticastPacket(void* outBuf, int len);
+    void SendMulticastPacket(void* outBuf, int len, in_addr_t skipSubnetOf = 0);
     void SendUnicastPacket(const std::string& address, void* outBuf, int len);
+    void SendToDestinations(std::vector<struct mmsghdr>& msgs, struct iovec& iov, void* outBuf, int len);
+    void AddDestinations(const std::string& remotesString, std::vector<struct sockaddr_in>& addrs,
+                         std::vector<struct mmsghdr>& msgs, struct iovec* iov);
+    int OpenControlSocket();
     bool FillInInterfaces();
     bool RemoveInterface(const std::string& interface);
 
@@ -319,6 +371,39 @@ private:
     void ProcessPingPacket(ControlPkt* pkt, int len, const std::string& src, MultiSyncStats* stats, const std::string& incomingIp = "");
     void ProcessPluginPacket(ControlPkt* pkt, int len, MultiSyncStats* stats);
     void ProcessFPPCommandPacket(ControlPkt* pkt, int len, MultiSyncStats* stats);
+    void ProcessTimePacket(ControlPkt* pkt, int len, const std::string& srcIp, MultiSyncStats* stats);
+
+    // Clock offset estimation on remotes.  Timestamp requests are sent to
+    // the master along with the sync packets, the offset from the sample
+    // with the lowest round trip delay is used.
+    void SendTimeRequest(const std::string& address);
+    void ResetClockEstimate();
+    bool AdjustForMasterClock(SyncPkt* spkt, int extraDataLen, float& secondsElapsed, long long& sampleTime);
+
+    // Relay mode, remotes re-send sync, command and blanking packets from
+    // their master to downstream remotes on networks the master can't
+    // reach via multicast
+    int OpenRelaySockets();
+    bool IsRelayUpstream(const std::string& sourceIP, uint8_t pktType);
+    bool AcceptFromSyncSource(ControlPkt* pkt, const std::string& sourceIP);
+    void RelayControlPacket(ControlPkt* pkt, int len, const std::string& sourceIP);
+
+    bool m_relayEnabled = false;
+    bool m_relayMulticast = false;
+    struct iovec m_relayIovec;
+    std::vector<struct mmsghdr> m_relayMsgs;
+    std::vector<struct sockaddr_in> m_relayAddr;
+    uint8_t m_syncHops = 0; // relays between us and the master
+    long long m_syncMasterLastSeen = 0;
+
+    MasterClockEstimator m_clock;
+    std::string m_clockMaster;
+    long long m_lastTimeRequest = 0;
+    // m_clock's estimate, published for the other threads
+    std::atomic<bool> m_clockValid;
+    std::atomic<long long> m_clockOffset; // master clock - local clock
+    std::atomic<long long> m_clockDelay;  // round trip network delay
+    long long m_rcvTime = 0;              // receive time of the packet being processed
 
     std::recursive_mutex m_systemsLock;
     std::vector<MultiSyncSystem> m_localSystems;
@@ -342,6 +427,8 @@ private:
     int m_lastMediaHalfSecond;
     int m_lastFrame;
     int m_lastFrameSent;
+    int m_syncFastUntil = 32;  // send sync packets more often until this frame
+    int m_syncStableCount = 0; // sync packets sent since the last discontinuity
 
     float m_remoteOffset;
 
@@ -27,9 +27,11 @@
 #include <utility>
 #include <vector>
 
+#include "HTTPFSEQSource.h"
 #include "MultiSync.h"
 #include "Player.h"
 #include "Plugins.h"
+#include "SequenceStream.h"
 #include "Warnings.h"
 #include "common.h"
 #include "effects.h"
@@ -37,8 +39,10 @@
 #include "settings.h"
 #include "channeloutput/ChannelOutputSetup.h"
 #include "channeloutput/channeloutputthread.h"
+#include "channeloutput/processors/OutputProcessor.h"
 #include "channeltester/ChannelTester.h"
 #include "commands/Commands.h"
+#include "mediaoutput/AudioAnalysis.h"
 #include "mediaoutput/SDLOut.h"
 #include "overlays/PixelOverlay.h"
 #include "playlist/Playlist.h"
@@ -53,6 +57,12 @@ using namespace std::literals::chrono_literals;
 
 #define SEQUENCE_CACHE_FRAMECOUNT 40
 
+// Key of a released bridge range slot, can't collide as len is never
+// more than FPPD_MAX_CHANNELS
+#define BRIDGE_SLOT_TOMBSTONE 0xFFFFFFFFFFFFFFFFULL
+// How long past its expiry a bridge range slot is kept before release
+#define BRIDGE_SLOT_RECLAIM_MS 5000
+
 Sequence* sequence = NULL;
 Sequence::Sequence() :
     m_seqMSDuration(0),
@@ -72,8 +82,25 @@ Sequence::Sequence() :
     m_lastFrameData(nullptr),
     m_dataProcessed(false),
     m_seqFilename(""),
-    m_bridgeData(nullptr) {
+    m_bridgeData(nullptr),
+    m_bridgeSlotCount(0),
+    m_bridgeSlotGeneration(0),
+    m_bridgeLastExpire(0),
+    m_bridgeSlotsFullWarned(false),
+    m_bridgeDirect(false),
+    m_bridgeSwitching(false),
+    m_bridgeWriters(0),
+    m_bridgeExpectedCount(0),
+    m_bridgeStagedExpected(0) {
     memset(m_seqData, 0, sizeof(m_seqData));
+    m_bridgeSlots = new BridgeRangeSlot[FPPD_MAX_BRIDGE_RANGES];
+    for (int x = 0; x < FPPD_MAX_BRIDGE_RANGES; x++) {
+        m_bridgeSlots[x].key = 0;
+        m_bridgeSlots[x].expires = 0;
+        m_bridgeSlots[x].staged = false;
+        m_bridgeSlots[x].expected = false;
+    }
+    m_bridgeSyncCommit = getSettingInt("BridgeSyncCommit");
     for (int x = 0; x < 4; x++) {
         m_seqData[FPPD_OFF_CHANNEL + x] = 0;
         m_seqData[FPPD_WHITE_CHANNEL] = 0xFF;
@@ -106,6 +133,10 @@ Sequence::~Sequence() {
     if (m_bridgeData) {
         free(m_bridgeData);
     }
+    if (m_bridgeStaging) {
+        free(m_bridgeStaging);
+    }
+    delete[] m_bridgeSlots;
 }
 void Sequence::clearCaches() {
     while (!frameCache.empty()) {
@@ -226,11 +257,24 @@ int Sequence::OpenSequenceFile(const std::string& filename, int startFrame, int
     }
 
     size_t bytesRead = 0;
+    FSEQFile* streamFile = nullptr;
+    if (getFPPmode() == REMOTE_MODE) {
+        // waiting for a stream and the HTTP check/prefetch against the
+        // master can take a while, don't hold up the output thread
+        std::string localPath = FPP_DIR_SEQUENCE("/" + filename);
+        CheckForHostSpecificFile(getSetting("HostName"), localPath);
+        SequenceStreamReceiver::INSTANCE.WaitForStream(filename, localPath);
+        streamFile = SequenceStreamReceiver::INSTANCE.OpenStream(filename, localPath);
+        if (!streamFile) {
+            streamFile = HTTPFSEQSource::OpenFromMaster(filename, localPath);
+        }
+    }
     std::unique_lock<std::recursive_mutex> seqLock(m_sequenceLock);
 
     if (m_seqFile) {
         if (m_seqFilename == filename && m_seqStarting) {
             //same filename AND we haven't started yet, we can continue
+            delete streamFile;
             return 1;
         }
     }
@@ -271,10 +315,11 @@ int Sequence::OpenSequenceFile(const std::string& filename, int startFrame, int
     unsigned char tmpData[2048];
     strcpy(tmpFilename, FPP_DIR_SEQUENCE("/" + filename).c_str());
 
-    if (getFPPmode() == REMOTE_MODE)
+    if (getFPPmode() == REMOTE_MODE) {
         CheckForHostSpecificFile(getSetting("HostName").c_str(), tmpFilename);
+    }
 
-    if (!FileExists(tmpFilename)) {
+    if (!streamFile && !FileExists(tmpFilename)) {
         std::string warning = "Sequence file ";
         warning += tmpFilename;
         warning += " does not exist\n";
@@ -305,13 +350,14 @@ int Sequence::OpenSequenceFile(const std::string& filename, int startFrame, int
     }
 
     if (multiSync->isMultiSyncEnabled()) {
+        SequenceStreamSender::INSTANCE.Start(filename, tmpFilename);
         seqLock.unlock();
         multiSync->SendSeqOpenPacket(filename);
         seqLock.lock();
     }
 
     m_seqFile = nullptr;
-    FSEQFile* seqFile = FSEQFile::openFSEQFile(tmpFilename);
+    FSEQFile* seqFile = streamFile ? streamFile : FSEQFile::openFSEQFile(tmpFilename);
     if (seqFile == NULL) {
         LogErr(VB_SEQUENCE, "Error opening sequence file: %s. FSEQFile::openFSEQFile returned NULL\n",
                tmpFilename);
@@ -487,15 +533,27 @@ int Sequence::IsSequenceRunning(const std::string& filename) {
 
 void Sequence::BlankSequenceData(bool clearBridge) {
     LogExcess(VB_SEQUENCE, "BlankSequenceData()\n");
-    for (auto& a : GetOutputRanges()) {
-        memset(&m_seqData[a.first], 0, a.second);
+    if (m_bridgeDirect && !clearBridge) {
+        // the bridge data is being received directly into m_seqData and
+        // nothing else is writing to it so there is nothing to blank
+    } else {
+        for (auto& a : GetOutputRanges()) {
+            memset(&m_seqData[a.first], 0, a.second);
+        }
     }
     if (m_bridgeData && clearBridge) {
         for (auto& a : GetOutputRanges()) {
             memset(&m_bridgeData[a.first], 0, a.second);
         }
-        std::unique_lock<std::mutex> lock(m_bridgeRangesLock);
-        m_bridgeRanges.clear();
+        for (int x = 0; x < FPPD_MAX_BRIDGE_RANGES; x++) {
+            m_bridgeSlots[x].expires = 0;
+            m_bridgeSlots[x].staged = false;
+        }
+        for (int x = 0; x < m_bridgeExpectedStarts.size(); x++) {
+            m_bridgeExpectedStaged[x] = false;
+        }
+        m_bridgeLastExpire = 0;
+        m_bridgeStagedExpected = 0;
     }
 
     m_dataProcessed = false;
@@ -527,6 +585,11 @@ void Sequence::SingleStepSequenceBack(void) {
 void Sequence::ReadSequenceData(bool forceFirstFrame) {
     LogExcess(VB_SEQUENCE, "ReadSequenceData()\n");
     std::unique_lock<std::recursive_mutex> seqLock(m_sequenceLock);
+    if (m_bridgeDirect) {
+        // make sure the bridge data is moved out of m_seqData before a
+        // sequence frame is read over it
+        UpdateBridgePlacement();
+    }
     if (!forceFirstFrame && m_seqStarting) {
         return;
     }
@@ -633,59 +696,14 @@ void Sequence::ProcessSequenceData(int ms) {
             m_lastFrameData->readFrame((uint8_t*)m_seqData, FPPD_MAX_CHANNELS);
     }
 
-    std::unique_lock<std::mutex> bridgesLock(m_bridgeRangesLock);
-    if (m_bridgeData && !m_bridgeRanges.empty()) {
-        // copy the latest bridge data to the sequence data
-        uint64_t nt = GetTimeMS();
-        std::map<uint32_t, uint32_t> rngs;
-        for (auto& a : m_bridgeRanges) {
-            BridgeRangeData& rd = a.second;
-            auto it = rd.expires.begin();
-            uint32_t len = 0;
-            while (it != rd.expires.end()) {
-                if (it->second < nt) {
-                    rd.expires.erase(it);
-                    it = rd.expires.begin();
-                } else {
-                    len = std::max(len, it->first);
-                    ++it;
-                }
-            }
-            if (len > 0) {
-                rngs[rd.startChannel] = len;
-            }
-        }
-        auto it = m_bridgeRanges.begin();
-        while (it != m_bridgeRanges.end()) {
-            if (it->second.expires.empty()) {
-                m_bridgeRanges.erase(it);
-                it = m_bridgeRanges.begin();
-            } else {
-                ++it;
-            }
-        }
-
-        uint32_t curStart = 0xFFFFFFFF;
-        uint32_t nextStart = 0xFFFFFFFF;
-        for (auto& a : rngs) {
-            if (curStart == 0xFFFFFFFF) {
-                curStart = a.first;
-                nextStart = a.first + a.second;
-            } else if (a.first > nextStart) {
-                memcpy(&m_seqData[curStart], &m_bridgeData[curStart], nextStart - curStart);
-                curStart = a.first;
-                nextStart = a.first + a.second;
-            } else if (a.first == nextStart) {
-                nextStart += a.second;
-            } else {
-                nextStart += a.second - (nextStart - a.first);
-            }
-        }
-        if (curStart != 0xFFFFFFFF) {
-            memcpy(&m_seqData[curStart], &m_bridgeData[curStart], nextStart - curStart);
+    if (m_bridgeData && m_bridgeSlotCount) {
+        ReclaimBridgeSlots();
+        UpdateBridgePlacement();
+        if (!m_bridgeDirect) {
+            // copy the latest bridge data to the sequence data
+            CopyBridgeDataToSequence();
         }
     }
-    bridgesLock.unlock();
     PluginManager::INSTANCE.modifySequenceData(ms, (uint8_t*)m_seqData);
 
     if (IsEffectRunning())
@@ -694,6 +712,7 @@ void Sequence::ProcessSequenceData(int ms) {
     if (SDLOutput::IsOverlayingVideo()) {
         SDLOutput::ProcessVideoOverlay(ms);
     }
+    AudioAnalysis::INSTANCE.nextFrame();
     if (PixelOverlayManager::INSTANCE.hasActiveOverlays()) {
         PixelOverlayManager::INSTANCE.doOverlays((uint8_t*)m_seqData);
     }
@@ -765,8 +784,10 @@ void Sequence::CloseIfOpen(const std::string& filename) {
 void Sequence::CloseSequenceFile(void) {
     LogDebug(VB_SEQUENCE, "CloseSequenceFile() %s\n", m_seqFilename.c_str());
 
-    if (multiSync->isMultiSyncEnabled())
+    if (multiSync->isMultiSyncEnabled()) {
         multiSync->SendSeqSyncStopPacket(m_seqFilename);
+        SequenceStreamSender::INSTANCE.Stop();
+    }
 
     std::unique_lock<std::recursive_mutex> seqLock(m_sequenceLock);
 
@@ -805,30 +826,419 @@ void Sequence::CloseSequenceFile(void) {
 }
 
 void Sequence::SetBridgeData(uint8_t* data, int startChannel, int len, uint64_t expireMS) {
+    if (CopyBridgeData(data, startChannel, len)) {
+        UpdateBridgeRange(startChannel, len, expireMS);
+    }
+}
+
+void Sequence::UpdateBridgeRange(uint32_t startChannel, uint32_t len, uint64_t expireMS) {
+    BridgeRangeSlot* slot = GetBridgeSlot(startChannel, len);
+    if (slot) {
+        slot->expires.store(expireMS, std::memory_order_release);
+    }
+    m_bridgeLastExpire = expireMS;
+
+    setDataNotProcessed();
+}
+
+bool Sequence::CopyBridgeData(uint8_t* data, int startChannel, int len) {
+    uint8_t* dest = GetBridgeDataTarget(startChannel, len);
+    if (!dest) {
+        return false;
+    }
+    memcpy(dest, data, len);
+    FinishBridgeData(startChannel, len);
+    return true;
+}
+
+uint8_t* Sequence::GetBridgeDataTarget(uint32_t startChannel, uint32_t len) {
     if (this->IsSequenceRunning()) {
         if (m_warn_if_bridging) {
             WarningHolder::AddWarningTimeout("Received bridging data while sequence is running.", 60);
         }
         if (m_prioritize_sequence_over_bridge) {
-            return;
+            return nullptr;
         }
     }
 
-    if (!m_bridgeData) {
+    std::call_once(m_bridgeDataAlloc, [this]() {
         m_bridgeData = (uint8_t*)calloc(1, FPPD_MAX_CHANNEL_NUM);
+        if (m_bridgeSyncCommit) {
+            m_bridgeStaging = (uint8_t*)calloc(1, FPPD_MAX_CHANNEL_NUM);
+        }
+    });
+    if (!m_bridgeSyncCommit) {
+        ++m_bridgeWriters;
+        while (m_bridgeSwitching) {
+            // the placement is changing, the switch is only a memcpy so
+            // back off and wait for it rather than block
+            --m_bridgeWriters;
+            while (m_bridgeSwitching) {
+                std::this_thread::yield();
+            }
+            ++m_bridgeWriters;
+        }
+        if (m_bridgeDirect) {
+            return (uint8_t*)&m_seqData[startChannel];
+        }
+        return &m_bridgeData[startChannel];
     }
-    memcpy(&m_bridgeData[startChannel], data, len);
 
-    std::unique_lock<std::mutex> lock(m_bridgeRangesLock);
-    auto& a = m_bridgeRanges[startChannel];
-    a.startChannel = startChannel;
-    a.expires[len] = expireMS;
+    BridgeRangeSlot* slot = GetBridgeSlot(startChannel, len);
+    if (!slot) {
+        return nullptr;
+    }
+    if (slot->staged.load(std::memory_order_acquire)) {
+        // new data for a range that hasn't been committed, the sender
+        // has moved on to the next frame without a sync so publish
+        // what we have
+        CommitBridgeData();
+    }
+    return &m_bridgeStaging[startChannel];
+}
+
+void Sequence::FinishBridgeData(uint32_t startChannel, uint32_t len) {
+    if (!m_bridgeSyncCommit) {
+        --m_bridgeWriters;
+        return;
+    }
+    BridgeRangeSlot* slot = GetBridgeSlot(startChannel, len);
+    if (slot) {
+        slot->staged = true;
+    }
+    auto it = std::lower_bound(m_bridgeExpectedStarts.begin(), m_bridgeExpectedStarts.end(), startChannel);
+    if (it != m_bridgeExpectedStarts.end() && *it == startChannel &&
+        !m_bridgeExpectedStaged[it - m_bridgeExpectedStarts.begin()].exchange(true)) {
+        uint32_t exp = m_bridgeExpectedCount;
+        if (++m_bridgeStagedExpected >= exp) {
+            // have data for everything that is configured
+            CommitBridgeData();
+        }
+    }
+}
+
+bool Sequence::CommitBridgeData() {
+    if (!m_bridgeStaging) {
+        return false;
+    }
+    std::unique_lock<std::mutex> lock(m_bridgeCommitLock);
+    uint32_t generation = m_bridgeSlotGeneration;
+    if (generation != m_bridgePlanGeneration) {
+        RebuildBridgePlan(generation);
+    }
+    int count = 0;
+    m_bridgeStagedExpected = 0;
+    for (int x = 0; x < m_bridgeExpectedStarts.size(); x++) {
+        m_bridgeExpectedStaged[x] = false;
+    }
+    for (auto slot : m_bridgePlanSlots) {
+        if (slot->staged.load(std::memory_order_relaxed) && slot->staged.exchange(false)) {
+            uint64_t key = slot->key.load(std::memory_order_relaxed);
+            uint32_t start = key >> 32;
+            memcpy(&m_bridgeData[start], &m_bridgeStaging[start], key & 0xFFFFFFFF);
+            count++;
+        }
+    }
     lock.unlock();
+    if (count) {
+        setDataNotProcessed();
+        ForceChannelOutputNow();
+    }
+    return count != 0;
+}
+
+void Sequence::AddBridgeRanges(const std::vector<std::pair<uint32_t, uint32_t>>& ranges, uint64_t expireMS) {
+    if (ranges.empty()) {
+        return;
+    }
+    for (auto& r : ranges) {
+        BridgeRangeSlot* slot = GetBridgeSlot(r.first, r.second);
+        if (slot) {
+            slot->expires.store(expireMS, std::memory_order_release);
+        }
+    }
+    m_bridgeLastExpire = expireMS;
 
     setDataNotProcessed();
 }
 
+void Sequence::GetBridgeDataSnapshot(uint8_t* dest, uint32_t len) {
+    if (!m_bridgeData) {
+        memset(dest, 0, len);
+        return;
+    }
+    std::unique_lock<std::mutex> lock(m_bridgeCommitLock, std::defer_lock);
+    if (m_bridgeSyncCommit) {
+        lock.lock();
+    }
+    memcpy(dest, m_bridgeDirect ? (uint8_t*)m_seqData : m_bridgeData, len);
+}
+
+uint32_t Sequence::GetBridgeChannelCount() {
+    uint32_t max = 0;
+    for (int x = 0; x < FPPD_MAX_BRIDGE_RANGES; x++) {
+        uint64_t key = m_bridgeSlots[x].key.load(std::memory_order_relaxed);
+        if (key && key != BRIDGE_SLOT_TOMBSTONE) {
+            max = std::max(max, (uint32_t)(key >> 32) + (uint32_t)(key & 0xFFFFFFFF));
+        }
+    }
+    return std::min(max, (uint32_t)FPPD_MAX_CHANNELS);
+}
+
+void Sequence::RegisterBridgeRange(uint32_t startChannel, uint32_t len) {
+    if (len == 0) {
+        return;
+    }
+    BridgeRangeSlot* slot = GetBridgeSlot(startChannel, len);
+    if (slot) {
+        slot->expected = true;
+    }
+    auto it = std::lower_bound(m_bridgeExpectedStarts.begin(), m_bridgeExpectedStarts.end(), startChannel);
+    if (it == m_bridgeExpectedStarts.end() || *it != startChannel) {
+        m_bridgeExpectedStarts.insert(it, startChannel);
+        m_bridgeExpectedStaged.reset(new std::atomic_bool[m_bridgeExpectedStarts.size()]);
+        for (int x = 0; x < m_bridgeExpectedStarts.size(); x++) {
+            m_bridgeExpectedStaged[x] = false;
+        }
+        m_bridgeExpectedCount = m_bridgeExpectedStarts.size();
+        m_bridgeStagedExpected = 0;
+    }
+}
+
+Sequence::BridgeRangeSlot* Sequence::GetBridgeSlot(uint32_t startChannel, uint32_t len) {
+    if (len == 0 || len > FPPD_MAX_CHANNELS) {
+        // nothing to track and the key for channel 0 would be the unused
+        // marker, anything longer can't be valid and could be a tombstone
+        return nullptr;
+    }
+    uint64_t key = ((uint64_t)startChannel << 32) | len;
+    uint32_t idx = (uint32_t)((key * 0x9E3779B97F4A7C15ULL) >> 32);
+    for (int attempt = 0; attempt < 4; attempt++) {
+        // linear probe, the table is sized so that it is normally very sparse
+        BridgeRangeSlot* freeSlot = nullptr;
+        for (int x = 0; x < 256; x++) {
+            BridgeRangeSlot* slot = &m_bridgeSlots[(idx + x) & (FPPD_MAX_BRIDGE_RANGES - 1)];
+            uint64_t k = slot->key.load(std::memory_order_acquire);
+            if (k == key) {
+                return slot;
+            }
+            if (k == BRIDGE_SLOT_TOMBSTONE) {
+                // released, reusable but the range may be further along
+                if (!freeSlot) {
+                    freeSlot = slot;
+                }
+            } else if (k == 0) {
+                if (!freeSlot) {
+                    freeSlot = slot;
+                }
+                break;
+            }
+        }
+        if (!freeSlot) {
+            break;
+        }
+        uint64_t k = freeSlot->key.load(std::memory_order_acquire);
+        if ((k == 0 || k == BRIDGE_SLOT_TOMBSTONE) && freeSlot->key.compare_exchange_strong(k, key)) {
+            ++m_bridgeSlotCount;
+            ++m_bridgeSlotGeneration;
+            return freeSlot;
+        }
+        if (k == key) {
+            // another thread claimed it for the same range
+            return freeSlot;
+        }
+        // lost the slot to a different range, probe again
+    }
+    if (!m_bridgeSlotsFullWarned.exchange(true)) {
+        LogWarn(VB_E131BRIDGE, "Too many distinct bridge ranges, ignoring data for %d-%d\n", startChannel, startChannel + len - 1);
+    }
+    return nullptr;
+}
+
+// Called from the output thread.  Senders that vary their packet lengths
+// (DDP, short ArtNet universes) claim a slot for every start/length they
+// send, release the ones that haven't been updated in a while so the table
+// doesn't fill up.  Registered ranges are kept.
+void Sequence::ReclaimBridgeSlots() {
+    uint64_t nt = GetTimeMS();
+    if (nt < m_bridgeNextReclaim) {
+        return;
+    }
+    m_bridgeNextReclaim = nt + 1000;
+
+    std::unique_lock<std::mutex> lock(m_bridgeCommitLock, std::defer_lock);
+    if (m_bridgeSyncCommit) {
+        // the commit walks the plan slots
+        lock.lock();
+    }
+    int count = 0;
+    for (int x = 0; x < FPPD_MAX_BRIDGE_RANGES; x++) {
+        BridgeRangeSlot* slot = &m_bridgeSlots[x];
+        uint64_t k = slot->key.load(std::memory_order_acquire);
+        if (k == 0 || k == BRIDGE_SLOT_TOMBSTONE || slot->expected.load(std::memory_order_relaxed) ||
+            slot->staged.load(std::memory_order_relaxed) ||
+            (slot->expires.load(std::memory_order_acquire) + BRIDGE_SLOT_RECLAIM_MS) > nt) {
+            continue;
+        }
+        if (slot->key.compare_exchange_strong(k, BRIDGE_SLOT_TOMBSTONE)) {
+            // a writer racing with this will just claim a new slot on its
+            // next packet
+            slot->expires.store(0, std::memory_order_release);
+            --m_bridgeSlotCount;
+            count++;
+        }
+    }
+    if (count) {
+        ++m_bridgeSlotGeneration;
+        m_bridgeSlotsFullWarned = false;
+        LogDebug(VB_E131BRIDGE, "Released %d stale bridge ranges\n", count);
+    }
+}
+
+void Sequence::RebuildBridgePlan(uint32_t generation) {
+    m_bridgePlanSlots.clear();
+    for (int x = 0; x < FPPD_MAX_BRIDGE_RANGES; x++) {
+        uint64_t key = m_bridgeSlots[x].key.load(std::memory_order_acquire);
+        if (key && key != BRIDGE_SLOT_TOMBSTONE) {
+            m_bridgePlanSlots.push_back(&m_bridgeSlots[x]);
+        }
+    }
+    std::sort(m_bridgePlanSlots.begin(), m_bridgePlanSlots.end(), [](BridgeRangeSlot* a, BridgeRangeSlot* b) {
+        return a->key.load() < b->key.load();
+    });
+
+    m_bridgePlanCopies.clear();
+    uint32_t curStart = 0xFFFFFFFF;
+    uint32_t nextStart = 0xFFFFFFFF;
+    for (auto slot : m_bridgePlanSlots) {
+        uint64_t key = slot->key.load();
+        uint32_t start = key >> 32;
+        uint32_t len = key & 0xFFFFFFFF;
+        if (curStart == 0xFFFFFFFF) {
+            curStart = start;
+            nextStart = start + len;
+        } else if (start > nextStart) {
+            m_bridgePlanCopies.emplace_back(curStart, nextStart - curStart);
+            curStart = start;
+            nextStart = start + len;
+        } else {
+            nextStart = std::max(nextStart, start + len);
+        }
+    }
+    if (curStart != 0xFFFFFFFF) {
+        m_bridgePlanCopies.emplace_back(curStart, nextStart - curStart);
+    }
+    m_bridgePlanGeneration = generation;
+    LogDebug(VB_E131BRIDGE, "Bridge copy plan: %d ranges merged into %d copies\n",
+             (int)m_bridgePlanSlots.size(), (int)m_bridgePlanCopies.size());
+}
+
+bool Sequence::CanPlaceBridgeDataDirect() {
+    if (m_bridgeSyncCommit || m_seqFile || m_lastFrameData) {
+        return false;
+    }
+    if (IsEffectRunning() || SDLOutput::IsOverlayingVideo() ||
+        PixelOverlayManager::INSTANCE.hasActiveOverlays() ||
+        ChannelTester::INSTANCE.Testing() ||
+        PluginManager::INSTANCE.hasPlugins() ||
+        outputProcessors.hasActiveProcessors()) {
+        // something else modifies m_seqData each frame
+        return false;
+    }
+    // expired ranges need to be blanked which the normal path handles
+    uint64_t nt = GetTimeMS();
+    for (auto slot : m_bridgePlanSlots) {
+        if (slot->expires.load(std::memory_order_acquire) < nt) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void Sequence::UpdateBridgePlacement() {
+    if (m_bridgeSyncCommit) {
+        // never direct, and the plan is rebuilt under m_bridgeCommitLock
+        return;
+    }
+    uint32_t generation = m_bridgeSlotGeneration;
+    if (generation != m_bridgePlanGeneration) {
+        RebuildBridgePlan(generation);
+    }
+    bool direct = CanPlaceBridgeDataDirect();
+    if (direct == m_bridgeDirect) {
+        return;
+    }
+    // hold off new writers and wait for any still writing to the
+    // old location before moving the data
+    m_bridgeSwitching = true;
+    while (m_bridgeWriters) {
+        std::this_thread::yield();
+    }
+    if (direct) {
+        CopyBridgeDataToSequence();
+    } else {
+        for (auto& c : m_bridgePlanCopies) {
+            memcpy(&m_bridgeData[c.first], &m_seqData[c.first], c.second);
+        }
+    }
+    m_bridgeDirect = direct;
+    m_bridgeSwitching = false;
+    LogDebug(VB_E131BRIDGE, "Bridge data now received %s\n", direct ? "directly into the sequence data" : "into the bridge buffer");
+}
+
+void Sequence::CopyBridgeDataToSequence() {
+    std::unique_lock<std::mutex> lock(m_bridgeCommitLock, std::defer_lock);
+    if (m_bridgeSyncCommit) {
+        // don't copy a frame that is in the middle of being committed, this
+        // also keeps the plan from changing under CommitBridgeData
+        lock.lock();
+    }
+    uint32_t generation = m_bridgeSlotGeneration;
+    if (generation != m_bridgePlanGeneration) {
+        RebuildBridgePlan(generation);
+    }
+
+    uint64_t nt = GetTimeMS();
+    bool allCurrent = true;
+    for (auto slot : m_bridgePlanSlots) {
+        if (slot->expires.load(std::memory_order_acquire) < nt) {
+            allCurrent = false;
+            break;
+        }
+    }
+    if (allCurrent) {
+        for (auto& c : m_bridgePlanCopies) {
+            memcpy(&m_seqData[c.first], &m_bridgeData[c.first], c.second);
+        }
+        return;
+    }
+
+    // some ranges have expired, merge just the current ones
+    uint32_t curStart = 0xFFFFFFFF;
+    uint32_t nextStart = 0xFFFFFFFF;
+    for (auto slot : m_bridgePlanSlots) {
+        if (slot->expires.load(std::memory_order_acquire) < nt) {
+            continue;
+        }
+        uint64_t key = slot->key.load(std::memory_order_relaxed);
+        uint32_t start = key >> 32;
+        uint32_t len = key & 0xFFFFFFFF;
+        if (curStart == 0xFFFFFFFF) {
+            curStart = start;
+            nextStart = start + len;
+        } else if (start > nextStart) {
+            memcpy(&m_seqData[curStart], &m_bridgeData[curStart], nextStart - curStart);
+            curStart = start;
+            nextStart = start + len;
+        } else {
+            nextStart = std::max(nextStart, start + len);
+        }
+    }
+    if (curStart != 0xFFFFFFFF) {
+        memcpy(&m_seqData[curStart], &m_bridgeData[curStart], nextStart - curStart);
+    }
+}
+
 bool Sequence::hasBridgeData() {
-    std::unique_lock<std::mutex> lock(m_bridgeRangesLock);
-    return !m_bridgeRanges.empty();
+    return m_bridgeLastExpire >= GetTimeMS();
 }
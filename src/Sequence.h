@@ -18,6 +18,7 @@
 #include <condition_variable>
 #include <list>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <thread>
 #include <vector>
@@ -33,6 +34,10 @@
 #define FPPD_WHITE_CHANNEL (FPPD_MAX_CHANNELS + 4)
 #define FPPD_MAX_CHANNEL_NUM (FPPD_WHITE_CHANNEL + 4)
 
+// Maximum number of distinct bridge ranges (start/length pairs) tracked,
+// must be a power of 2
+#define FPPD_MAX_BRIDGE_RANGES 16384
+
 class Sequence {
 public:
     Sequence();
@@ -69,6 +74,35 @@ public:
     void BlankSequenceData(bool clearBridge = false);
 
     void SetBridgeData(uint8_t* data, int startChannel, int len, uint64_t expireMS);
+    void UpdateBridgeRange(uint32_t startChannel, uint32_t len, uint64_t expireMS);
+
+    // Batched version of SetBridgeData for the bridge ingest threads. The
+    // data is copied as each packet arrives, the ranges are then marked
+    // as updated for the whole batch
+    bool CopyBridgeData(uint8_t* data, int startChannel, int len);
+    void AddBridgeRanges(const std::vector<std::pair<uint32_t, uint32_t>>& ranges, uint64_t expireMS);
+
+    // For receivers that place data directly (DDP scatter receive).  Get
+    // the location to write len channels at startChannel, nullptr if the
+    // data should be dropped, then call FinishBridgeData once written.
+    // FinishBridgeData must be called for every non-null target, even if
+    // nothing was written, as a placement switch waits on it.
+    uint8_t* GetBridgeDataTarget(uint32_t startChannel, uint32_t len);
+    void FinishBridgeData(uint32_t startChannel, uint32_t len);
+
+    // Reserve the slot for a known input range (configured universes) so
+    // the copy plan is built before any data arrives
+    void RegisterBridgeRange(uint32_t startChannel, uint32_t len);
+
+    // In sync commit mode bridge data is staged until a sync packet (or a
+    // full set of the registered ranges) arrives and then published to the
+    // output as a complete frame.  Returns true if anything was published.
+    bool CommitBridgeData();
+    bool IsBridgeSyncCommit() const { return m_bridgeSyncCommit; }
+
+    // Copy of the current bridge data for recording, len channels from 0
+    void GetBridgeDataSnapshot(uint8_t* dest, uint32_t len);
+    uint32_t GetBridgeChannelCount();
 
 private:
     void ProcessVariableHeaders();
@@ -76,17 +110,63 @@ private:
     bool m_prioritize_sequence_over_bridge;
     bool m_warn_if_bridging = false;
 
-    class BridgeRangeData {
+    // Bridge ranges are kept in a fixed, open addressed table so that
+    // receiving data never locks or allocates.  A slot is claimed the first
+    // time a start/length is seen.  Expired slots are skipped when copying
+    // and released by the output thread once they have been stale for a
+    // while, leaving a tombstone so probe chains stay intact.
+    class BridgeRangeSlot {
     public:
-        BridgeRangeData() :
-            startChannel(0) {}
-
-        uint32_t startChannel;
-        // map of len -> ms when it expires, in MOST cases, this will be a single len (like 512 for e1.31)
-        std::map<uint32_t, uint64_t> expires;
+        std::atomic<uint64_t> key;     // (startChannel << 32) | len, 0 if never used, BRIDGE_SLOT_TOMBSTONE if released
+        std::atomic<uint64_t> expires; // ms when the data expires
+        std::atomic_bool staged;       // new data waiting to be committed
+        std::atomic_bool expected;     // registered (configured) range, never released
     };
-    std::map<uint64_t, BridgeRangeData> m_bridgeRanges;
-    std::mutex m_bridgeRangesLock;
+    BridgeRangeSlot* m_bridgeSlots;
+    std::atomic<uint32_t> m_bridgeSlotCount;
+    std::atomic<uint32_t> m_bridgeSlotGeneration; // bumped on every claim and release
+    std::atomic<uint64_t> m_bridgeLastExpire;
+    std::atomic_bool m_bridgeSlotsFullWarned;
+    uint64_t m_bridgeNextReclaim = 0;
+    BridgeRangeSlot* GetBridgeSlot(uint32_t startChannel, uint32_t len);
+    void ReclaimBridgeSlots();
+
+    // Slots sorted by start channel and the merged copies to make when
+    // every slot is current.  Only rebuilt when the slot generation
+    // changes, in sync commit mode only while holding m_bridgeCommitLock.
+    uint32_t m_bridgePlanGeneration = 0;
+    std::vector<BridgeRangeSlot*> m_bridgePlanSlots;
+    std::vector<std::pair<uint32_t, uint32_t>> m_bridgePlanCopies;
+    void RebuildBridgePlan(uint32_t generation);
+    void CopyBridgeDataToSequence();
+
+    // When nothing but bridge data is being output (no sequence, overlays,
+    // effects, plugins or output processors), incoming data is written
+    // straight into m_seqData instead of m_bridgeData to avoid copying
+    // every frame.  Checked at the start of each frame.  Writers count
+    // themselves in m_bridgeWriters from GetBridgeDataTarget until
+    // FinishBridgeData, a switch sets m_bridgeSwitching so no new writers
+    // start and waits for the count to drain before moving the data.
+    std::atomic_bool m_bridgeDirect;
+    std::atomic_bool m_bridgeSwitching;
+    std::atomic<int> m_bridgeWriters;
+    bool CanPlaceBridgeDataDirect();
+    void UpdateBridgePlacement();
+
+    std::once_flag m_bridgeDataAlloc;
+
+    bool m_bridgeSyncCommit = false;
+    uint8_t* m_bridgeStaging = nullptr;
+    std::mutex m_bridgeCommitLock;
+    std::atomic<uint32_t> m_bridgeExpectedCount;
+    std::atomic<uint32_t> m_bridgeStagedExpected;
+    // Start channels of the registered ranges, sorted, with a flag for each
+    // set once data starting there has been staged.  Matched by start only
+    // as senders may send less than the configured size (short ArtNet
+    // universes).  Only changed by RegisterBridgeRange before any data is
+    // received.
+    std::vector<uint32_t> m_bridgeExpectedStarts;
+    std::unique_ptr<std::atomic_bool[]> m_bridgeExpectedStaged;
     uint8_t* m_bridgeData;
 
     FSEQFile* m_seqFile;
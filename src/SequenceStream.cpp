@@ -0,0 +1,843 @@
+/*
+ * This file is part of the Falcon Player (FPP) and is Copyright (C)
+ * 2013-2022 by the Falcon Player Developers.
+ *
+ * The Falcon Player (FPP) is free software, and is covered under
+ * multiple Open Source licenses.  Please see the included 'LICENSES'
+ * file for descriptions of what files are covered by each license.
+ *
+ * This source file is covered under the LGPL v2.1 as described in the
+ * included LICENSE.LGPL file.
+ */
+
+#include "fpp-pch.h"
+
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <zstd.h>
+
+#include "MultiSync.h"
+#include "Sequence.h"
+#include "common.h"
+#include "log.h"
+#include "settings.h"
+#include "fseq/FSEQFile.h"
+
+#include "SequenceStream.h"
+
+// How far ahead of the master's playback position frames are sent
+#define SEQ_STREAM_LEAD_FRAMES 20
+#define SEQ_STREAM_KEYFRAME_INTERVAL 100
+#define SEQ_STREAM_TARGET_REFRESH_MS 2000
+
+// Decoded frames kept on the remote, limited by SEQ_STREAM_RING_MAX_BYTES
+#define SEQ_STREAM_RING_FRAMES 128
+#define SEQ_STREAM_RING_MIN_FRAMES 16
+#define SEQ_STREAM_RING_MAX_BYTES (32 * 1024 * 1024)
+
+// How long a remote waits for the master's stream info when it does
+// not have the sequence at all
+#define SEQ_STREAM_OPEN_WAIT_MS 500
+// How long info from a source that isn't (yet) the sync master is held
+#define SEQ_STREAM_HELD_INFO_MS 2000
+#define SEQ_STREAM_KEYREQ_INTERVAL_MS 100
+
+SequenceStreamSender SequenceStreamSender::INSTANCE;
+SequenceStreamReceiver SequenceStreamReceiver::INSTANCE;
+
+static void InitStreamHeader(SeqStreamPkt* pkt, uint8_t type, uint32_t streamId) {
+    memset(pkt, 0, sizeof(SeqStreamPkt));
+    pkt->magic[0] = 'F';
+    pkt->magic[1] = 'P';
+    pkt->magic[2] = 'P';
+    pkt->magic[3] = 'S';
+    pkt->pktType = type;
+    pkt->streamId = streamId;
+}
+
+// Parse a MultiSync channel range string ("0-511,1024-2047") into
+// (start, count) pairs
+static std::vector<std::pair<uint32_t, uint32_t>> ParseRanges(const std::string& str, uint32_t channelCount) {
+    std::vector<std::pair<uint32_t, uint32_t>> ranges;
+    for (auto& r : split(str, ',')) {
+        size_t dash = r.find('-');
+        if (dash == std::string::npos) {
+            continue;
+        }
+        uint32_t start = std::strtoul(r.c_str(), nullptr, 10);
+        uint32_t end = std::strtoul(r.c_str() + dash + 1, nullptr, 10);
+        if (end < start || start >= channelCount) {
+            continue;
+        }
+        if (end >= channelCount) {
+            end = channelCount - 1;
+        }
+        ranges.push_back(std::pair<uint32_t, uint32_t>(start, end - start + 1));
+    }
+    return ranges;
+}
+
+/*
+ * FSEQFile that reads frames from the stream receive buffer
+ */
+class StreamFSEQFile : public FSEQFile {
+public:
+    class StreamFrameData : public FSEQFile::FrameData {
+    public:
+        StreamFrameData(uint32_t f, const std::string& fn) :
+            FrameData(f),
+            filename(fn) {}
+        virtual ~StreamFrameData() {}
+
+        virtual bool readFrame(uint8_t* data, uint32_t maxChannels) override {
+            return SequenceStreamReceiver::INSTANCE.ReadFrame(filename, frame, data, maxChannels);
+        }
+
+        std::string filename;
+    };
+
+    StreamFSEQFile(const std::string& fn, uint32_t numFrames, int stepTime, uint32_t channelCount, uint64_t uniqueId) :
+        FSEQFile("-memory-"),
+        m_streamFilename(fn) {
+        m_seqNumFrames = numFrames;
+        m_seqStepTime = stepTime;
+        m_seqChannelCount = channelCount;
+        m_uniqueId = uniqueId;
+        m_seqVersionMajor = 2;
+        m_seqVersionMinor = 0;
+    }
+    virtual ~StreamFSEQFile() {}
+
+    virtual FrameData* getFrame(uint32_t frame) override {
+        return new StreamFrameData(frame, m_streamFilename);
+    }
+
+    virtual void writeHeader() override {}
+    virtual void addFrame(uint32_t frame, const uint8_t* data) override {}
+    virtual void finalize() override {}
+    virtual uint32_t getMaxChannel() const override { return m_seqChannelCount; }
+
+private:
+    std::string m_streamFilename;
+};
+
+/*
+ * Master side
+ */
+SequenceStreamSender::SequenceStreamSender() :
+    m_running(false),
+    m_thread(nullptr),
+    m_sock(-1),
+    m_file(nullptr),
+    m_streamId(time(nullptr)),
+    m_lastTargetUpdate(0),
+    m_nextFrame(0),
+    m_cctx(nullptr) {
+}
+SequenceStreamSender::~SequenceStreamSender() {
+    Stop();
+    if (m_sock >= 0) {
+        close(m_sock);
+    }
+    if (m_cctx) {
+        ZSTD_freeCCtx((ZSTD_CCtx*)m_cctx);
+    }
+}
+
+void SequenceStreamSender::Start(const std::string& filename, const std::string& path) {
+    Stop();
+
+    if (!getSettingInt("MultiSyncStreamSequences")) {
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(m_lock);
+    if (m_sock < 0) {
+        m_sock = socket(AF_INET, SOCK_DGRAM, 0);
+        if (m_sock < 0) {
+            LogErr(VB_SYNC, "Error opening sequence stream socket: %s\n", strerror(errno));
+            return;
+        }
+        // remotes that are missing the sequence ask for the stream info
+        // on the well known port
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        addr.sin_port = htons(SEQ_STREAM_PORT);
+        if (bind(m_sock, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+            LogWarn(VB_SYNC, "Error binding sequence stream socket, remotes will not be able to request the stream: %s\n", strerror(errno));
+        }
+        int bufSize = 1024 * 1024;
+        setsockopt(m_sock, SOL_SOCKET, SO_SNDBUF, &bufSize, sizeof(bufSize));
+        fcntl(m_sock, F_SETFL, fcntl(m_sock, F_GETFL, 0) | O_NONBLOCK);
+    }
+    if (!m_cctx) {
+        m_cctx = ZSTD_createCCtx();
+    }
+
+    m_file = FSEQFile::openFSEQFile(path);
+    if (!m_file) {
+        LogWarn(VB_SYNC, "Could not open %s to stream to remotes\n", path.c_str());
+        return;
+    }
+    std::vector<std::pair<uint32_t, uint32_t>> all;
+    all.push_back(std::pair<uint32_t, uint32_t>(0, m_file->getChannelCount()));
+    m_file->prepareRead(all, 0);
+    m_frameBuffer.resize(m_file->getChannelCount());
+
+    m_filename = filename;
+    m_streamId++;
+    m_nextFrame = 0;
+    m_targets.clear();
+
+    // let the remotes know about the stream before the open packet is sent
+    // so they can decide whether to use it
+    UpdateTargets();
+
+    LogDebug(VB_SYNC, "Streaming %s to %d remote(s)\n", filename.c_str(), (int)m_targets.size());
+
+    m_running = true;
+    m_thread = new std::thread(&SequenceStreamSender::StreamThread, this);
+}
+
+void SequenceStreamSender::Stop() {
+    m_running = false;
+    if (m_thread) {
+        m_thread->join();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+
+    std::unique_lock<std::mutex> lock(m_lock);
+    if (m_file) {
+        delete m_file;
+        m_file = nullptr;
+    }
+    m_targets.clear();
+    m_filename = "";
+}
+
+void SequenceStreamSender::UpdateTargets() {
+    m_lastTargetUpdate = GetTimeMS();
+
+    Json::Value systems = multiSync->GetSystems(false, false)["systems"];
+    std::vector<Target> targets;
+    for (int i = 0; i < systems.size(); i++) {
+        Json::Value& sys = systems[i];
+        if (sys["local"].asInt() || sys["fppMode"].asInt() != REMOTE_MODE) {
+            continue;
+        }
+        std::string address = sys["address"].asString();
+        auto ranges = ParseRanges(sys["channelRanges"].asString(), m_file->getChannelCount());
+        if (ranges.empty()) {
+            continue;
+        }
+        int maxRanges = (SEQ_STREAM_CHUNK_SIZE - sizeof(SeqStreamInfo) - m_filename.size() - 1) / 8;
+        if (ranges.size() > maxRanges) {
+            // too many to describe, send everything between the first and last
+            uint32_t start = ranges.front().first;
+            uint32_t end = ranges.back().first + ranges.back().second;
+            ranges.clear();
+            ranges.push_back(std::pair<uint32_t, uint32_t>(start, end - start));
+        }
+
+        Target t;
+        bool existing = false;
+        for (auto& old : m_targets) {
+            if (old.address == address) {
+                t = old;
+                existing = true;
+                break;
+            }
+        }
+        if (!existing || t.ranges != ranges) {
+            memset(&t.addr, 0, sizeof(t.addr));
+            t.addr.sin_family = AF_INET;
+            t.addr.sin_port = htons(SEQ_STREAM_PORT);
+            t.addr.sin_addr.s_addr = inet_addr(address.c_str());
+            t.address = address;
+            t.ranges = ranges;
+            t.sliceSize = 0;
+            for (auto& r : ranges) {
+                t.sliceSize += r.second;
+            }
+            t.lastSlice.clear();
+            t.lastFrame = -1;
+            t.needKeyframe = true;
+            t.infoSent = false;
+        }
+        // announce the stream once, remotes that join mid-sequence without
+        // the file ask for it with an INFOREQ
+        if (!t.infoSent) {
+            SendInfo(t);
+            t.infoSent = true;
+        }
+        targets.push_back(t);
+    }
+    m_targets.swap(targets);
+}
+
+void SequenceStreamSender::ProcessRequests() {
+    SeqStreamPkt pkt;
+    struct sockaddr_in from;
+    socklen_t fromLen = sizeof(from);
+    while (recvfrom(m_sock, &pkt, sizeof(pkt), 0, (struct sockaddr*)&from, &fromLen) == sizeof(pkt)) {
+        fromLen = sizeof(from);
+        if (memcmp(pkt.magic, "FPPS", 4)) {
+            continue;
+        }
+        if (pkt.pktType == SEQ_STREAM_PKT_INFOREQ) {
+            // the remote doesn't know the current stream id yet
+            for (auto& t : m_targets) {
+                if (t.addr.sin_addr.s_addr == from.sin_addr.s_addr) {
+                    LogDebug(VB_SYNC, "Stream info requested by %s\n", t.address.c_str());
+                    SendInfo(t);
+                }
+            }
+            continue;
+        }
+        if (pkt.pktType != SEQ_STREAM_PKT_KEYREQ || pkt.streamId != m_streamId) {
+            continue;
+        }
+        for (auto& t : m_targets) {
+            if (t.addr.sin_addr.s_addr == from.sin_addr.s_addr) {
+                LogExcess(VB_SYNC, "Keyframe requested by %s\n", t.address.c_str());
+                if (!t.active) {
+                    LogDebug(VB_SYNC, "%s subscribed to sequence stream %s\n", t.address.c_str(), m_filename.c_str());
+                }
+                t.active = true;
+                t.needKeyframe = true;
+                t.lastFrame = -1;
+                // back up so the remote gets the frames it is missing
+                // from the current position on
+                m_nextFrame = 0;
+            }
+        }
+    }
+}
+
+void SequenceStreamSender::SendInfo(Target& t) {
+    uint8_t buf[SEQ_STREAM_CHUNK_SIZE + sizeof(SeqStreamPkt)];
+    SeqStreamPkt* pkt = (SeqStreamPkt*)buf;
+    InitStreamHeader(pkt, SEQ_STREAM_PKT_INFO, m_streamId);
+    pkt->seqNum = t.seqNum++;
+
+    SeqStreamInfo* info = (SeqStreamInfo*)(buf + sizeof(SeqStreamPkt));
+    info->numFrames = m_file->getNumFrames();
+    info->channelCount = m_file->getChannelCount();
+    info->uniqueId = m_file->getUniqueId();
+    info->stepTime = m_file->getStepTime();
+
+    info->rangeCount = t.ranges.size();
+    uint32_t* r = (uint32_t*)(buf + sizeof(SeqStreamPkt) + sizeof(SeqStreamInfo));
+    for (auto& range : t.ranges) {
+        *r++ = range.first;
+        *r++ = range.second;
+    }
+    char* fn = (char*)r;
+    strcpy(fn, m_filename.c_str());
+    int len = (fn - (char*)buf) + m_filename.size() + 1;
+
+    sendto(m_sock, buf, len, 0, (struct sockaddr*)&t.addr, sizeof(t.addr));
+}
+
+void SequenceStreamSender::SendFrame(Target& t, uint32_t frame, const uint8_t* data) {
+    bool keyframe = t.needKeyframe || (frame != (t.lastFrame + 1)) || ((frame % SEQ_STREAM_KEYFRAME_INTERVAL) == 0);
+
+    m_sliceBuffer.resize(t.sliceSize);
+    uint8_t* slice = &m_sliceBuffer[0];
+    for (auto& r : t.ranges) {
+        memcpy(slice, data + r.first, r.second);
+        slice += r.second;
+    }
+
+    const uint8_t* src = &m_sliceBuffer[0];
+    if (!keyframe) {
+        m_deltaBuffer.resize(t.sliceSize);
+        for (uint32_t x = 0; x < t.sliceSize; x++) {
+            m_deltaBuffer[x] = m_sliceBuffer[x] ^ t.lastSlice[x];
+        }
+        src = &m_deltaBuffer[0];
+    }
+    t.lastSlice.swap(m_sliceBuffer);
+
+    m_compressBuffer.resize(ZSTD_compressBound(t.sliceSize));
+    size_t clen = ZSTD_compressCCtx((ZSTD_CCtx*)m_cctx, &m_compressBuffer[0], m_compressBuffer.size(),
+                                    src, t.sliceSize, 1);
+    if (ZSTD_isError(clen)) {
+        LogWarn(VB_SYNC, "Error compressing frame %d for %s: %s\n", frame, t.address.c_str(), ZSTD_getErrorName(clen));
+        t.needKeyframe = true;
+        return;
+    }
+
+    if (keyframe) {
+        SendInfo(t);
+    }
+
+    uint8_t buf[SEQ_STREAM_CHUNK_SIZE + sizeof(SeqStreamPkt)];
+    SeqStreamPkt* pkt = (SeqStreamPkt*)buf;
+    InitStreamHeader(pkt, SEQ_STREAM_PKT_DATA, m_streamId);
+    pkt->flags = keyframe ? SEQ_STREAM_FLAG_KEYFRAME : 0;
+    pkt->chunkCount = (clen + SEQ_STREAM_CHUNK_SIZE - 1) / SEQ_STREAM_CHUNK_SIZE;
+    pkt->frame = frame;
+    pkt->dataLen = t.sliceSize;
+
+    for (int c = 0; c < pkt->chunkCount; c++) {
+        size_t off = c * SEQ_STREAM_CHUNK_SIZE;
+        size_t len = std::min((size_t)SEQ_STREAM_CHUNK_SIZE, clen - off);
+        pkt->chunk = c;
+        pkt->seqNum = t.seqNum++;
+        memcpy(buf + sizeof(SeqStreamPkt), &m_compressBuffer[off], len);
+        sendto(m_sock, buf, sizeof(SeqStreamPkt) + len, 0, (struct sockaddr*)&t.addr, sizeof(t.addr));
+    }
+
+    t.lastFrame = frame;
+    t.needKeyframe = false;
+}
+
+void SequenceStreamSender::StreamThread() {
+    SetThreadName("FPP-SeqStream");
+
+    while (m_running) {
+        std::unique_lock<std::mutex> lock(m_lock);
+        int stepTime = m_file->getStepTime();
+        if (GetTimeMS() - m_lastTargetUpdate > SEQ_STREAM_TARGET_REFRESH_MS) {
+            UpdateTargets();
+        }
+        ProcessRequests();
+
+        uint32_t cur = sequence->m_seqMSElapsed / stepTime;
+        if (m_nextFrame < cur || m_nextFrame > (cur + SEQ_STREAM_LEAD_FRAMES + 1)) {
+            // new subscriber or the master jumped to a new position
+            m_nextFrame = cur;
+        }
+        uint32_t end = std::min(cur + SEQ_STREAM_LEAD_FRAMES, m_file->getNumFrames());
+        while (m_nextFrame < end && m_running) {
+            bool needed = false;
+            for (auto& t : m_targets) {
+                needed |= t.active && ((int)m_nextFrame > t.lastFrame);
+            }
+            if (needed) {
+                FSEQFile::FrameData* fd = m_file->getFrame(m_nextFrame);
+                if (fd) {
+                    fd->readFrame(&m_frameBuffer[0], m_frameBuffer.size());
+                    delete fd;
+                }
+                for (auto& t : m_targets) {
+                    if (t.active && ((int)m_nextFrame > t.lastFrame)) {
+                        SendFrame(t, m_nextFrame, &m_frameBuffer[0]);
+                    }
+                }
+            }
+            m_nextFrame++;
+        }
+        lock.unlock();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(std::max(stepTime / 2, 1)));
+    }
+}
+
+/*
+ * Remote side
+ */
+SequenceStreamReceiver::SequenceStreamReceiver() :
+    m_running(false),
+    m_thread(nullptr),
+    m_sock(-1),
+    m_dctx(nullptr),
+    m_streamId(0),
+    m_numFrames(0),
+    m_channelCount(0),
+    m_uniqueId(0),
+    m_stepTime(50),
+    m_sliceSize(0),
+    m_lastPacketTime(0),
+    m_syncMaster(0),
+    m_heldInfoTime(0),
+    m_lastSeqNum(0),
+    m_pendingFrame(0),
+    m_pendingFlags(0),
+    m_pendingLen(0),
+    m_pendingCompressedLen(0),
+    m_pendingCount(0),
+    m_pendingReceived(0),
+    m_ringSize(0),
+    m_lastDecodedFrame(-1),
+    m_lastKeyframeRequest(0),
+    m_packets(0),
+    m_packetsLost(0),
+    m_framesDecoded(0),
+    m_framesDropped(0),
+    m_framesMissed(0) {
+    memset(&m_masterAddr, 0, sizeof(m_masterAddr));
+    memset(&m_heldInfoFrom, 0, sizeof(m_heldInfoFrom));
+}
+SequenceStreamReceiver::~SequenceStreamReceiver() {
+    Shutdown();
+}
+
+void SequenceStreamReceiver::Init() {
+    m_sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (m_sock < 0) {
+        LogErr(VB_SYNC, "Error opening sequence stream socket: %s\n", strerror(errno));
+        return;
+    }
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(SEQ_STREAM_PORT);
+    if (bind(m_sock, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        LogErr(VB_SYNC, "Error binding sequence stream socket: %s\n", strerror(errno));
+        close(m_sock);
+        m_sock = -1;
+        return;
+    }
+    int bufSize = 2 * 1024 * 1024;
+    setsockopt(m_sock, SOL_SOCKET, SO_RCVBUF, &bufSize, sizeof(bufSize));
+    struct timeval tv;
+    tv.tv_sec = 0;
+    tv.tv_usec = 250000;
+    setsockopt(m_sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    m_dctx = ZSTD_createDCtx();
+    m_running = true;
+    m_thread = new std::thread(&SequenceStreamReceiver::ReceiveThread, this);
+}
+
+void SequenceStreamReceiver::Shutdown() {
+    m_running = false;
+    if (m_thread) {
+        m_thread->join();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+    if (m_sock >= 0) {
+        close(m_sock);
+        m_sock = -1;
+    }
+    if (m_dctx) {
+        ZSTD_freeDCtx((ZSTD_DCtx*)m_dctx);
+        m_dctx = nullptr;
+    }
+}
+
+void SequenceStreamReceiver::ReceiveThread() {
+    SetThreadName("FPP-SeqStreamRx");
+
+    uint8_t buf[SEQ_STREAM_CHUNK_SIZE + sizeof(SeqStreamPkt) + 100];
+    struct sockaddr_in from;
+    while (m_running) {
+        socklen_t fromLen = sizeof(from);
+        int len = recvfrom(m_sock, buf, sizeof(buf), 0, (struct sockaddr*)&from, &fromLen);
+        if (len < (int)sizeof(SeqStreamPkt)) {
+            continue;
+        }
+        SeqStreamPkt* pkt = (SeqStreamPkt*)buf;
+        if (memcmp(pkt->magic, "FPPS", 4)) {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_lock);
+        m_packets++;
+        if (pkt->streamId == m_streamId && pkt->seqNum > (m_lastSeqNum + 1)) {
+            m_packetsLost += pkt->seqNum - m_lastSeqNum - 1;
+        }
+        m_lastSeqNum = pkt->seqNum;
+        m_lastPacketTime = GetTimeMS();
+
+        if (pkt->pktType == SEQ_STREAM_PKT_INFO) {
+            ProcessInfo(pkt, len, from);
+        } else if (pkt->pktType == SEQ_STREAM_PKT_DATA) {
+            ProcessData(pkt, len, from);
+        }
+    }
+}
+
+void SequenceStreamReceiver::SetSyncMaster(const std::string& address) {
+    in_addr_t addr = inet_addr(address.c_str());
+    std::unique_lock<std::mutex> lock(m_lock);
+    if (addr == m_syncMaster) {
+        return;
+    }
+    m_syncMaster = addr;
+    if (!m_heldInfo.empty() && m_heldInfoFrom.sin_addr.s_addr == addr &&
+        (GetTimeMS() - m_heldInfoTime) < SEQ_STREAM_HELD_INFO_MS) {
+        std::vector<uint8_t> info;
+        info.swap(m_heldInfo);
+        struct sockaddr_in from = m_heldInfoFrom;
+        ProcessInfo((SeqStreamPkt*)&info[0], info.size(), from);
+    }
+    m_heldInfo.clear();
+}
+
+void SequenceStreamReceiver::ProcessInfo(SeqStreamPkt* pkt, int len, struct sockaddr_in& from) {
+    if (len < (int)(sizeof(SeqStreamPkt) + sizeof(SeqStreamInfo) + 1)) {
+        return;
+    }
+    SeqStreamInfo* info = (SeqStreamInfo*)((uint8_t*)pkt + sizeof(SeqStreamPkt));
+    int rangeLen = info->rangeCount * 8;
+    int fnOffset = sizeof(SeqStreamPkt) + sizeof(SeqStreamInfo) + rangeLen;
+    if (fnOffset >= len || ((char*)pkt)[len - 1] != 0 || info->stepTime == 0) {
+        return;
+    }
+    if (m_syncMaster == 0 || from.sin_addr.s_addr != m_syncMaster) {
+        m_heldInfo.assign((uint8_t*)pkt, (uint8_t*)pkt + len);
+        m_heldInfoFrom = from;
+        m_heldInfoTime = GetTimeMS();
+        return;
+    }
+    m_masterAddr = from;
+    if (pkt->streamId == m_streamId) {
+        return;
+    }
+
+    if (info->channelCount == 0 || info->channelCount > FPPD_MAX_CHANNELS) {
+        LogWarn(VB_SYNC, "Ignoring sequence stream with %u channels\n", info->channelCount);
+        return;
+    }
+    std::vector<std::pair<uint32_t, uint32_t>> ranges;
+    uint64_t sliceSize = 0;
+    uint32_t* r = (uint32_t*)((uint8_t*)info + sizeof(SeqStreamInfo));
+    for (int x = 0; x < info->rangeCount; x++, r += 2) {
+        if (r[1] == 0 || ((uint64_t)r[0] + r[1]) > info->channelCount) {
+            LogWarn(VB_SYNC, "Ignoring sequence stream with invalid channel range %u-%u\n", r[0], r[0] + r[1] - 1);
+            return;
+        }
+        ranges.push_back(std::pair<uint32_t, uint32_t>(r[0], r[1]));
+        sliceSize += r[1];
+    }
+    if (sliceSize == 0 || sliceSize > FPPD_MAX_CHANNELS) {
+        return;
+    }
+    uint32_t ringSize = std::min((uint64_t)SEQ_STREAM_RING_FRAMES, SEQ_STREAM_RING_MAX_BYTES / sliceSize);
+    if (ringSize < SEQ_STREAM_RING_MIN_FRAMES) {
+        LogWarn(VB_SYNC, "Ignoring sequence stream, %u channels per frame is too large to buffer\n", (uint32_t)sliceSize);
+        return;
+    }
+
+    m_streamId = pkt->streamId;
+    m_filename = (char*)pkt + fnOffset;
+    m_numFrames = info->numFrames;
+    m_channelCount = info->channelCount;
+    m_uniqueId = info->uniqueId;
+    m_stepTime = info->stepTime;
+    m_ranges.swap(ranges);
+    m_sliceSize = sliceSize;
+
+    m_ringSize = ringSize;
+    m_ring.resize(m_ringSize * m_sliceSize);
+    m_ringFrames.assign(m_ringSize, -1);
+    m_decodeBuffer.resize(m_sliceSize);
+    m_lastDecodedFrame = -1;
+    m_pendingCount = 0;
+    m_lastSeqNum = pkt->seqNum;
+
+    LogDebug(VB_SYNC, "Master is streaming %s, %d channels in %d range(s)\n",
+             m_filename.c_str(), m_sliceSize, (int)m_ranges.size());
+    m_infoSignal.notify_all();
+}
+
+void SequenceStreamReceiver::ProcessData(SeqStreamPkt* pkt, int len, struct sockaddr_in& from) {
+    int dataLen = len - sizeof(SeqStreamPkt);
+    if (pkt->streamId != m_streamId || pkt->dataLen != m_sliceSize || pkt->chunk >= pkt->chunkCount ||
+        dataLen > SEQ_STREAM_CHUNK_SIZE || from.sin_addr.s_addr != m_masterAddr.sin_addr.s_addr) {
+        return;
+    }
+
+    if (m_pendingCount == 0 || pkt->frame != m_pendingFrame || pkt->chunkCount != m_pendingCount ||
+        pkt->flags != m_pendingFlags || pkt->dataLen != m_pendingLen) {
+        // a resend of the same frame number with a different layout (ex: a
+        // keyframe answering a KEYREQ) restarts the reassembly as well
+        if (m_pendingCount) {
+            // never received all of the previous frame
+            m_framesDropped++;
+        }
+        m_pendingFrame = pkt->frame;
+        m_pendingFlags = pkt->flags;
+        m_pendingLen = pkt->dataLen;
+        m_pendingCount = pkt->chunkCount;
+        m_pendingReceived = 0;
+        m_pendingCompressedLen = 0;
+        m_pendingChunks.assign(m_pendingCount, false);
+        m_pendingData.resize(m_pendingCount * SEQ_STREAM_CHUNK_SIZE);
+    }
+    if (pkt->chunk >= m_pendingCount || m_pendingChunks[pkt->chunk]) {
+        return;
+    }
+
+    memcpy(&m_pendingData[pkt->chunk * SEQ_STREAM_CHUNK_SIZE], (uint8_t*)pkt + sizeof(SeqStreamPkt), dataLen);
+    m_pendingChunks[pkt->chunk] = true;
+    m_pendingReceived++;
+    if (pkt->chunk == (m_pendingCount - 1)) {
+        m_pendingCompressedLen = pkt->chunk * SEQ_STREAM_CHUNK_SIZE + dataLen;
+    }
+
+    if (m_pendingReceived == m_pendingCount) {
+        CompleteFrame(from);
+        m_pendingCount = 0;
+    }
+}
+
+void SequenceStreamReceiver::CompleteFrame(struct sockaddr_in& from) {
+    size_t len = ZSTD_decompressDCtx((ZSTD_DCtx*)m_dctx, &m_decodeBuffer[0], m_sliceSize,
+                                     &m_pendingData[0], m_pendingCompressedLen);
+    if (ZSTD_isError(len) || len != m_sliceSize) {
+        m_framesDropped++;
+        RequestKeyframe(from);
+        return;
+    }
+
+    uint8_t* slot = &m_ring[(m_pendingFrame % m_ringSize) * m_sliceSize];
+    if (m_pendingFlags & SEQ_STREAM_FLAG_KEYFRAME) {
+        memcpy(slot, &m_decodeBuffer[0], m_sliceSize);
+    } else {
+        int64_t prevFrame = (int64_t)m_pendingFrame - 1;
+        int prevIdx = prevFrame % m_ringSize;
+        if (prevFrame < 0 || m_ringFrames[prevIdx] != prevFrame) {
+            // can't apply the delta without the previous frame
+            m_framesDropped++;
+            RequestKeyframe(from);
+            return;
+        }
+        const uint8_t* prev = &m_ring[prevIdx * m_sliceSize];
+        for (uint32_t x = 0; x < m_sliceSize; x++) {
+            slot[x] = prev[x] ^ m_decodeBuffer[x];
+        }
+    }
+    m_ringFrames[m_pendingFrame % m_ringSize] = m_pendingFrame;
+    m_lastDecodedFrame = m_pendingFrame;
+    m_framesDecoded++;
+}
+
+void SequenceStreamReceiver::RequestKeyframe(struct sockaddr_in& to) {
+    uint64_t now = GetTimeMS();
+    if ((now - m_lastKeyframeRequest) < SEQ_STREAM_KEYREQ_INTERVAL_MS) {
+        return;
+    }
+    m_lastKeyframeRequest = now;
+
+    SeqStreamPkt pkt;
+    InitStreamHeader(&pkt, SEQ_STREAM_PKT_KEYREQ, m_streamId);
+    pkt.frame = m_lastDecodedFrame < 0 ? 0 : m_lastDecodedFrame;
+    sendto(m_sock, &pkt, sizeof(pkt), 0, (struct sockaddr*)&to, sizeof(to));
+}
+
+void SequenceStreamReceiver::WaitForStream(const std::string& filename, const std::string& localPath) {
+    if (m_sock < 0 || FileExists(localPath)) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(m_lock);
+    if (m_filename == filename) {
+        return;
+    }
+    if (m_syncMaster) {
+        // joined mid-sequence or missed the announcement
+        struct sockaddr_in to;
+        memset(&to, 0, sizeof(to));
+        to.sin_family = AF_INET;
+        to.sin_port = htons(SEQ_STREAM_PORT);
+        to.sin_addr.s_addr = m_syncMaster;
+        SeqStreamPkt pkt;
+        InitStreamHeader(&pkt, SEQ_STREAM_PKT_INFOREQ, m_streamId);
+        sendto(m_sock, &pkt, sizeof(pkt), 0, (struct sockaddr*)&to, sizeof(to));
+    }
+    // the stream info is normally sent just before the open packet, give
+    // it a moment to arrive
+    m_infoSignal.wait_for(lock, std::chrono::milliseconds(SEQ_STREAM_OPEN_WAIT_MS),
+                          [this, &filename]() { return m_filename == filename; });
+}
+
+FSEQFile* SequenceStreamReceiver::OpenStream(const std::string& filename, const std::string& localPath) {
+    if (m_sock < 0) {
+        return nullptr;
+    }
+
+    bool haveLocal = FileExists(localPath);
+    std::unique_lock<std::mutex> lock(m_lock);
+    if (m_filename != filename) {
+        return nullptr;
+    }
+
+    if (haveLocal) {
+        FSEQFile* f = FSEQFile::openFSEQFile(localPath);
+        if (f) {
+            // V1 files have no id, assume those are current
+            bool current = (f->getNumFrames() == m_numFrames) &&
+                           (f->getUniqueId() == 0 || f->getUniqueId() == m_uniqueId);
+            delete f;
+            if (current) {
+                return nullptr;
+            }
+            LogInfo(VB_SYNC, "Local copy of %s differs from the master's\n", filename.c_str());
+        }
+    }
+
+    LogInfo(VB_SYNC, "Playing %s streamed from the master\n", filename.c_str());
+
+    // subscribe to the stream
+    m_lastKeyframeRequest = 0;
+    RequestKeyframe(m_masterAddr);
+
+    return new StreamFSEQFile(filename, m_numFrames, m_stepTime, m_channelCount, m_uniqueId);
+}
+
+void SequenceStreamReceiver::CopySlice(const uint8_t* slice, uint8_t* data, uint32_t maxChannels) {
+    for (auto& r : m_ranges) {
+        if (r.first < maxChannels) {
+            memcpy(data + r.first, slice, std::min(r.second, maxChannels - r.first));
+        }
+        slice += r.second;
+    }
+}
+
+bool SequenceStreamReceiver::ReadFrame(const std::string& filename, uint32_t frame, uint8_t* data, uint32_t maxChannels) {
+    std::unique_lock<std::mutex> lock(m_lock);
+    if (filename != m_filename || m_ringSize == 0) {
+        return false;
+    }
+
+    int idx = frame % m_ringSize;
+    if (m_ringFrames[idx] == frame) {
+        CopySlice(&m_ring[idx * m_sliceSize], data, maxChannels);
+        return true;
+    }
+
+    // hold the most recent frame before this one
+    m_framesMissed++;
+    int best = -1;
+    for (int x = 0; x < m_ringSize; x++) {
+        if (m_ringFrames[x] >= 0 && m_ringFrames[x] < frame &&
+            (best < 0 || m_ringFrames[x] > m_ringFrames[best])) {
+            best = x;
+        }
+    }
+    if (best >= 0) {
+        CopySlice(&m_ring[best * m_sliceSize], data, maxChannels);
+    }
+    if (m_lastDecodedFrame < (int64_t)frame && m_masterAddr.sin_family == AF_INET) {
+        // behind, possibly lost the subscription
+        RequestKeyframe(m_masterAddr);
+    }
+    return false;
+}
+
+void SequenceStreamReceiver::GetStats(Json::Value& stats) {
+    std::unique_lock<std::mutex> lock(m_lock);
+    if (m_filename.empty()) {
+        return;
+    }
+    stats["filename"] = m_filename;
+    stats["channels"] = m_sliceSize;
+    stats["packets"] = m_packets;
+    stats["packetsLost"] = m_packetsLost;
+    stats["framesDecoded"] = m_framesDecoded;
+    stats["framesDropped"] = m_framesDropped;
+    stats["framesMissed"] = m_framesMissed;
+}
@@ -0,0 +1,207 @@
+#pragma once
+/*
+ * This file is part of the Falcon Player (FPP) and is Copyright (C)
+ * 2013-2022 by the Falcon Player Developers.
+ *
+ * The Falcon Player (FPP) is free software, and is covered under
+ * multiple Open Source licenses.  Please see the included 'LICENSES'
+ * file for descriptions of what files are covered by each license.
+ *
+ * This source file is covered under the LGPL v2.1 as described in the
+ * included LICENSE.LGPL file.
+ */
+
+#include <netinet/in.h>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class FSEQFile;
+
+#define SEQ_STREAM_PORT 32323
+
+#define SEQ_STREAM_PKT_INFO 0
+#define SEQ_STREAM_PKT_DATA 1
+#define SEQ_STREAM_PKT_KEYREQ 2
+#define SEQ_STREAM_PKT_INFOREQ 3
+
+#define SEQ_STREAM_FLAG_KEYFRAME 0x01
+
+// Max payload bytes carried in a single data packet
+#define SEQ_STREAM_CHUNK_SIZE 1400
+
+typedef struct __attribute__((packed)) {
+    char magic[4];       // 'FPPS'
+    uint8_t pktType;     // Stream Packet Type
+    uint8_t flags;       // SEQ_STREAM_FLAG_*
+    uint16_t chunk;      // Index of this chunk within the frame
+    uint16_t chunkCount; // Number of chunks making up the frame
+    uint32_t streamId;   // Changes every time the master opens a sequence
+    uint32_t seqNum;     // Per destination packet counter for loss detection
+    uint32_t frame;      // Frame number (DATA)
+    uint32_t dataLen;    // Uncompressed slice size (DATA)
+} SeqStreamPkt;
+
+// Follows the SeqStreamPkt header in SEQ_STREAM_PKT_INFO packets, then
+// rangeCount pairs of uint32_t (start, count) and the null terminated
+// sequence filename
+typedef struct __attribute__((packed)) {
+    uint32_t numFrames;
+    uint32_t channelCount;
+    uint64_t uniqueId;
+    uint8_t stepTime;
+    uint16_t rangeCount;
+} SeqStreamInfo;
+
+// Streams the channel data of the running sequence to the remotes that do
+// not have a (current) copy of it.  Each remote only receives the channel
+// ranges it reported in its MultiSync ping.  Frames are XOR'd against the
+// previous frame sent to that remote and zstd compressed, with periodic
+// keyframes so a remote can recover from packet loss.
+class SequenceStreamSender {
+public:
+    static SequenceStreamSender INSTANCE;
+
+    void Start(const std::string& filename, const std::string& path);
+    void Stop();
+
+private:
+    class Target {
+    public:
+        struct sockaddr_in addr;
+        std::string address;
+        std::vector<std::pair<uint32_t, uint32_t>> ranges;
+        std::vector<uint8_t> lastSlice;
+        uint32_t sliceSize = 0;
+        uint32_t seqNum = 0;
+        int lastFrame = -1;
+        bool needKeyframe = true;
+        bool infoSent = false; // announced the current stream/ranges
+        bool active = false;   // remote has asked for the stream
+    };
+
+    SequenceStreamSender();
+    ~SequenceStreamSender();
+
+    void StreamThread();
+    void UpdateTargets();
+    void ProcessRequests();
+    void SendInfo(Target& t);
+    void SendFrame(Target& t, uint32_t frame, const uint8_t* data);
+
+    std::mutex m_lock;
+    std::atomic_bool m_running;
+    std::thread* m_thread;
+    int m_sock;
+
+    FSEQFile* m_file;
+    std::string m_filename;
+    uint32_t m_streamId;
+    std::vector<Target> m_targets;
+    uint64_t m_lastTargetUpdate;
+    uint32_t m_nextFrame;
+
+    std::vector<uint8_t> m_frameBuffer;
+    std::vector<uint8_t> m_sliceBuffer;
+    std::vector<uint8_t> m_deltaBuffer;
+    std::vector<uint8_t> m_compressBuffer;
+    void* m_cctx;
+};
+
+// Receives a stream from the master and provides the frames to the
+// Sequence via an FSEQFile that reads from the receive buffer
+class SequenceStreamReceiver {
+public:
+    static SequenceStreamReceiver INSTANCE;
+
+    void Init();
+    void Shutdown();
+
+    // Called by MultiSync when the sync master changes, stream info is
+    // only accepted from the master
+    void SetSyncMaster(const std::string& address);
+
+    // If localPath is missing, ask the master for its stream info and wait
+    // briefly for it to arrive.  Normally the info for filename was already
+    // sent just before the sync open packet.  Must be called before taking
+    // the sequence lock.
+    void WaitForStream(const std::string& filename, const std::string& localPath);
+
+    // Returns an FSEQFile reading from the stream if the master is
+    // streaming filename and localPath is missing or not the same sequence
+    FSEQFile* OpenStream(const std::string& filename, const std::string& localPath);
+
+    // Copies the slice for the frame into the channel data.  If the frame
+    // has not arrived, the most recent earlier frame is used and false
+    // is returned.
+    bool ReadFrame(const std::string& filename, uint32_t frame, uint8_t* data, uint32_t maxChannels);
+
+    void GetStats(Json::Value& stats);
+
+private:
+    SequenceStreamReceiver();
+    ~SequenceStreamReceiver();
+
+    void ReceiveThread();
+    void ProcessInfo(SeqStreamPkt* pkt, int len, struct sockaddr_in& from);
+    void ProcessData(SeqStreamPkt* pkt, int len, struct sockaddr_in& from);
+    void CompleteFrame(struct sockaddr_in& from);
+    void RequestKeyframe(struct sockaddr_in& from);
+    void CopySlice(const uint8_t* slice, uint8_t* data, uint32_t maxChannels);
+
+    std::mutex m_lock;
+    std::condition_variable m_infoSignal;
+    std::atomic_bool m_running;
+    std::thread* m_thread;
+    int m_sock;
+    void* m_dctx;
+
+    // Current stream
+    uint32_t m_streamId;
+    std::string m_filename;
+    uint32_t m_numFrames;
+    uint32_t m_channelCount;
+    uint64_t m_uniqueId;
+    int m_stepTime;
+    std::vector<std::pair<uint32_t, uint32_t>> m_ranges;
+    uint32_t m_sliceSize;
+    struct sockaddr_in m_masterAddr;
+    uint64_t m_lastPacketTime;
+
+    // Stream info is only accepted from the sync master.  The last info
+    // from anyone else is held in case it is from a master we have not
+    // received a sync packet from yet.
+    in_addr_t m_syncMaster;
+    std::vector<uint8_t> m_heldInfo;
+    struct sockaddr_in m_heldInfoFrom;
+    uint64_t m_heldInfoTime;
+    uint32_t m_lastSeqNum;
+
+    // Frame currently being reassembled from its chunks
+    uint32_t m_pendingFrame;
+    uint8_t m_pendingFlags;
+    uint32_t m_pendingLen;
+    uint32_t m_pendingCompressedLen;
+    uint16_t m_pendingCount;
+    uint16_t m_pendingReceived;
+    std::vector<bool> m_pendingChunks;
+    std::vector<uint8_t> m_pendingData;
+
+    // Decoded frame slices, indexed by frame % m_ringSize
+    uint32_t m_ringSize;
+    std::vector<uint8_t> m_ring;
+    std::vector<int64_t> m_ringFrames;
+    int64_t m_lastDecodedFrame;
+    std::vector<uint8_t> m_decodeBuffer;
+    uint64_t m_lastKeyframeRequest;
+
+    uint32_t m_packets;
+    uint32_t m_packetsLost;
+    uint32_t m_framesDecoded;
+    uint32_t m_framesDropped;
+    uint32_t m_framesMissed;
+};
@@ -86,6 +86,7 @@ const std::string& ArtNetOutputData::GetOutputTypeString() const {
 ArtNetOutputData::ArtNetOutputData(const Json::Value& config) :
     UDPOutputData(config),
     sequenceNumber(1),
+    sendSync(true),
     universeCount(1) {
     memset((char*)&anAddress, 0, sizeof(sockaddr_in));
     anAddress.sin_family = AF_INET;
@@ -104,6 +105,9 @@ ArtNetOutputData::ArtNetOutputData(const Json::Value& config) :
     if (universeCount < 1) {
         universeCount = 1;
     }
+    if (config.isMember("sync")) {
+        sendSync = config["sync"].asInt() ? true : false;
+    }
 
     switch (type) {
     case ARTNET_TYPE_BROADCAST: // Multicast
@@ -172,8 +176,6 @@ void ArtNetOutputData::PrepareData(unsigned char* channelData, UDPOutputMessages
 
         unsigned char* cur = channelData + startChannel - 1;
         int start = 0;
-        bool anySkipped = false;
-        bool allSkipped = true;
 
         std::vector<struct mmsghdr>& msgs = messages[ARTNET_DEST_PORT];
         for (int x = 0; x < universeCount; x++) {
@@ -189,9 +191,6 @@ void ArtNetOutputData::PrepareData(unsigned char* channelData, UDPOutputMessages
 
                 anHeaders[x][ARTNET_SEQUENCE_INDEX] = sequenceNumber;
                 anIovecs[x * 2 + 1].iov_base = (void*)cur;
-                allSkipped = false;
-            } else {
-                anySkipped = true;
             }
             cur += channelCount;
             start += channelCount;
@@ -200,17 +199,24 @@ void ArtNetOutputData::PrepareData(unsigned char* channelData, UDPOutputMessages
         if (sequenceNumber == 0) {
             sequenceNumber++;
         }
-        if (anySkipped) {
-            skippedFrames++;
-        }
-        if (!allSkipped) {
-            SaveFrame(&channelData[startChannel - 1], start);
-        }
     }
 }
 void ArtNetOutputData::PostPrepareData(unsigned char* channelData, UDPOutputMessages& msgs) {
-    if (valid && active) {
-        for (auto msg : msgs[ARTNET_DEST_PORT]) {
+    if (valid && active && sendSync) {
+        // The ArtSync goes out after the data for all outputs has been sent
+        // so controllers latch a complete frame.  It must still come from
+        // the ArtNet port so it gets its own handle to the ArtNet socket.
+        if (msgs.GetSocket(LATE_ARTNET_MESSAGES_KEY) == -1) {
+            int artnetSocket = msgs.GetSocket(ARTNET_DEST_PORT);
+            int syncSocket = artnetSocket == -1 ? -1 : dup(artnetSocket);
+            if (syncSocket == -1) {
+                LogErr(VB_CHANNELOUT, "Could not get a socket on the ArtNet port for ArtSync, disabling ArtSync\n");
+                sendSync = false;
+                return;
+            }
+            msgs.ForceSocket(LATE_ARTNET_MESSAGES_KEY, syncSocket);
+        }
+        for (auto msg : msgs[LATE_ARTNET_MESSAGES_KEY]) {
             if (msg.msg_hdr.msg_iov == &ArtNetSyncIovecs) {
                 // already added, skip
                 return;
@@ -225,7 +231,7 @@ void ArtNetOutputData::PostPrepareData(unsigned char* channelData, UDPOutputMess
         msg.msg_hdr.msg_iov = &ArtNetSyncIovecs;
         msg.msg_hdr.msg_iovlen = 1;
         msg.msg_len = ARTNET_SYNC_PACKET_LENGTH;
-        msgs[ARTNET_DEST_PORT].push_back(msg);
+        msgs[LATE_ARTNET_MESSAGES_KEY].push_back(msg);
     }
 }
 
@@ -235,7 +241,7 @@ void ArtNetOutputData::GetRequiredChannelRange(int& min, int& max) {
 }
 
 void ArtNetOutputData::DumpConfig() {
-    LogDebug(VB_CHANNELOUT, "ArtNet Universe: %s   %d:%d:%d:%d:%d:%d  %s\n",
+    LogDebug(VB_CHANNELOUT, "ArtNet Universe: %s   %d:%d:%d:%d:%d:%d  %s  Sync: %d\n",
              description.c_str(),
              active,
              universe,
@@ -243,5 +249,6 @@ void ArtNetOutputData::DumpConfig() {
              startChannel,
              channelCount,
              type,
-             ipAddress.c_str());
+             ipAddress.c_str(),
+             sendSync);
 }
@@ -38,6 +38,7 @@ public:
     int universeCount;
     int priority;
     char sequenceNumber;
+    bool sendSync;
 
     sockaddr_in anAddress;
 
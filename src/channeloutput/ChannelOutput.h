@@ -48,6 +48,10 @@ public:
     virtual void OverlayTestData(unsigned char* channelData, int cycleNum, float percentOfCycle, int testType, const Json::Value& config) {}
     virtual bool SupportsTesting() const { return false; }
 
+    // Outputs can report runtime statistics (send timing, packet counts, etc...)
+    // which are exposed via the fppd/outputStats API
+    virtual void GetStats(Json::Value& stats) {}
+
 protected:
     virtual void DumpConfig(void);
     virtual void ConvertToCSV(Json::Value config, char* configStr);
@@ -385,6 +385,21 @@ std::set<std::string> GetOutputTypes() {
     }
     return ret;
 }
+void GetChannelOutputStats(Json::Value& result) {
+    result["outputs"] = Json::arrayValue;
+    for (auto& inst : channelOutputs) {
+        if (inst.output) {
+            Json::Value stats;
+            inst.output->GetStats(stats);
+            if (!stats.empty()) {
+                stats["type"] = inst.output->GetOutputType();
+                stats["startChannel"] = inst.startChannel;
+                stats["channelCount"] = inst.channelCount;
+                result["outputs"].append(stats);
+            }
+        }
+    }
+}
 int PrepareChannelData(char* channelData) {
     outputProcessors.ProcessData((unsigned char*)channelData);
     for (auto& inst : channelOutputs) {
@@ -54,6 +54,7 @@ int PrepareChannelData(char* channelData);
 int SendChannelData(const char* channelData);
 void OverlayOutputTestData(std::set<std::string> types, unsigned char* channelData, int cycleCnt, float percentOfCycle, int testType, const Json::Value& extraConfig);
 std::set<std::string> GetOutputTypes();
+void GetChannelOutputStats(Json::Value& result);
 void CloseChannelOutputs(void);
 void SetChannelOutputFrameNumber(int frameNumber);
 void ResetChannelOutputFrameNumber(void);
@@ -71,12 +71,22 @@
  *     55 00 00 00 00 01 20 08 88 (288 pixel wide display)
  *     55 00 00 00 00 00 80 08 88 (128 pixel wide display)
  *
+ *   TX Ring:
+ *      When "txRing" is enabled in the config on Linux, the packets are
+ *      built directly in a PACKET_MMAP (TPACKET_V3) transmit ring shared
+ *      with the kernel.  PrepData writes the pixel rows straight into the
+ *      ring slots and SendData queues the whole frame with a single send()
+ *      call instead of copying every packet through sendmmsg().  The ring
+ *      holds at least two frames worth of packets so the next frame can
+ *      be prepared while the previous one is still being transmitted.
+ *
  */
 #include "fpp-pch.h"
 
 #ifndef PLATFORM_OSX
 #include <linux/if_packet.h>
 #include <netinet/ether.h>
+#include <sys/mman.h>
 #else
 #include <net/bpf.h>
 #endif
@@ -135,7 +145,17 @@ ColorLight5a75Output::ColorLight5a75Output(unsigned int startChannel, unsigned i
     m_matrix(NULL),
     m_panelMatrix(NULL),
     m_slowCount(0),
-    m_flippedLayout(0) {
+    m_flippedLayout(0),
+    m_packetsPerRow(0),
+    m_useTxRing(false),
+    m_txRing(nullptr),
+    m_txRingSize(0),
+    m_txFrameSize(0),
+    m_txFrameCount(0),
+    m_txHead(0),
+    m_txSkipFrame(false),
+    m_txDroppedFrames(0),
+    m_txLastDropWarning(0) {
     LogDebug(VB_CHANNELOUT, "ColorLight5a75Output::ColorLight5a75Output(%u, %u)\n",
              startChannel, channelCount);
 }
@@ -153,6 +173,8 @@ ColorLight5a75Output::~ColorLight5a75Output() {
             i++; // first 4 are header+data, only headers for the rest
     }
 
+    CloseTxRing();
+
     if (m_fd >= 0)
         close(m_fd);
 
@@ -289,6 +311,7 @@ int ColorLight5a75Output::Init(Json::Value config) {
         m_ifName = "eth1";
 
     m_rowSize = m_longestChain * m_panelWidth * 3;
+    m_packetsPerRow = ((m_rowSize - 1) / CL5A75_MAX_CHANNELS_PER_PACKET) + 1;
 
 #ifndef PLATFORM_OSX
 
@@ -376,9 +399,10 @@ int ColorLight5a75Output::Init(Json::Value config) {
     ioctl(m_fd, BIOCSHDRCMPLT, &yes);
 #endif
 
-    int packetCount = 2 + (m_rows * (((int)(m_rowSize - 1) / CL5A75_MAX_CHANNELS_PER_PACKET) + 1));
+    int packetCount = 2 + (m_rows * m_packetsPerRow);
     m_msgs.resize(packetCount);
     m_iovecs.resize(packetCount * 2);
+    m_packetData.resize(packetCount);
 
     unsigned int p = 0;
     unsigned char* header = nullptr;
@@ -461,6 +485,7 @@ int ColorLight5a75Output::Init(Json::Value config) {
             m_iovecs[p * 2].iov_len = hSize;
             m_iovecs[p * 2 + 1].iov_base = rowPtr + offset;
             m_iovecs[p * 2 + 1].iov_len = bytesInPacket;
+            m_packetData[p] = (unsigned char*)rowPtr + offset;
 
             offset += bytesInPacket;
             part++;
@@ -477,6 +502,16 @@ int ColorLight5a75Output::Init(Json::Value config) {
         msg.msg_hdr.msg_iovlen = 2;
         m_msgs[m] = msg;
     }
+
+#ifndef PLATFORM_OSX
+    if (config.isMember("txRing") && config["txRing"].asBool()) {
+        m_useTxRing = SetupTxRing();
+        if (!m_useTxRing) {
+            LogWarn(VB_CHANNELOUT, "ColorLight: Unable to setup TX ring on %s, falling back to sendmmsg()\n", m_ifName.c_str());
+        }
+    }
+#endif
+
     if (PixelOverlayManager::INSTANCE.isAutoCreatePixelOverlayModels()) {
         std::string dd = "LED Panels";
         if (config.isMember("description")) {
@@ -502,6 +537,8 @@ int ColorLight5a75Output::Init(Json::Value config) {
 int ColorLight5a75Output::Close(void) {
     LogDebug(VB_CHANNELOUT, "ColorLight5a75Output::Close()\n");
 
+    CloseTxRing();
+
     return ChannelOutput::Close();
 }
 
@@ -532,15 +569,14 @@ void ColorLight5a75Output::OverlayTestData(unsigned char* channelData, int cycle
 void ColorLight5a75Output::PrepData(unsigned char* channelData) {
     m_matrix->OverlaySubMatrices(channelData);
 
-    unsigned char* r = NULL;
-    unsigned char* g = NULL;
-    unsigned char* b = NULL;
-    unsigned char* s = NULL;
     unsigned char* dst = NULL;
     int pw3 = m_panelWidth * 3;
 
     channelData += m_startChannel; // FIXME, this function gets offset 0
 
+    if (m_useTxRing)
+        PrepTxRingFrames();
+
     for (int output = 0; output < m_outputs; output++) {
         int panelsOnOutput = m_panelMatrix->m_outputPanels[output].size();
 
@@ -552,17 +588,28 @@ void ColorLight5a75Output::PrepData(unsigned char* channelData) {
                 chain = m_panelMatrix->m_panels[panel].chain;
 
             for (int y = 0; y < m_panelHeight; y++) {
-                int px = chain * m_panelWidth;
                 int yw = y * m_panelWidth * 3;
 
-                dst = (unsigned char*)(m_outputFrame + (((((output * m_panelHeight) + y) * m_panelWidth * m_longestChain) + px) * 3));
+                // Rows may be split across multiple packets, so locate the
+                // packet and offset this panel's segment of the row starts in
+                int rowOffset = chain * pw3;
+                int packet = 2 + (((output * m_panelHeight) + y) * m_packetsPerRow) + (rowOffset / CL5A75_MAX_CHANNELS_PER_PACKET);
+                int packetOffset = rowOffset % CL5A75_MAX_CHANNELS_PER_PACKET;
+                int left = CL5A75_MAX_CHANNELS_PER_PACKET - packetOffset;
+
+                dst = m_packetData[packet] + packetOffset;
 
                 for (int x = 0; x < pw3; x += 3) {
+                    if (!left) {
+                        dst = m_packetData[++packet];
+                        left = CL5A75_MAX_CHANNELS_PER_PACKET;
+                    }
+
                     *(dst++) = m_gammaCurve[channelData[m_panelMatrix->m_panels[panel].pixelMap[yw + x]]];
                     *(dst++) = m_gammaCurve[channelData[m_panelMatrix->m_panels[panel].pixelMap[yw + x + 1]]];
                     *(dst++) = m_gammaCurve[channelData[m_panelMatrix->m_panels[panel].pixelMap[yw + x + 2]]];
 
-                    px++;
+                    left -= 3;
                 }
             }
         }
@@ -595,6 +642,9 @@ int ColorLight5a75Output::sendMessages(struct mmsghdr* msgs, int msgCount) {
 int ColorLight5a75Output::SendData(unsigned char* channelData) {
     LogExcess(VB_CHANNELOUT, "ColorLight5a75Output::SendData(%p)\n", channelData);
 
+    if (m_useTxRing)
+        return SendTxRing();
+
     long long startTime = GetTimeMS();
     struct mmsghdr* msgs = &m_msgs[0];
     int msgCount = m_msgs.size();
@@ -645,6 +695,200 @@ int ColorLight5a75Output::SendData(unsigned char* channelData) {
     return m_channelCount;
 }
 
+#ifndef PLATFORM_OSX
+#define CL5A75_TX_DATA_OFFSET (TPACKET3_HDRLEN - sizeof(struct sockaddr_ll))
+#endif
+
+/*
+ * Map a PACKET_MMAP TX ring onto the raw socket with room for two full
+ * frames of packets.
+ */
+bool ColorLight5a75Output::SetupTxRing(void) {
+#ifdef PLATFORM_OSX
+    return false;
+#else
+    int version = TPACKET_V3;
+    if (setsockopt(m_fd, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) < 0) {
+        LogWarn(VB_CHANNELOUT, "ColorLight: Unable to set TPACKET_V3: %s\n", strerror(errno));
+        return false;
+    }
+
+    m_txFrameSize = TPACKET_ALIGN(CL5A75_TX_DATA_OFFSET + CL5A75_BUFFER_SIZE);
+
+    unsigned int blockSize = getpagesize();
+    while (blockSize < m_txFrameSize)
+        blockSize *= 2;
+
+    unsigned int framesPerBlock = blockSize / m_txFrameSize;
+    unsigned int blockCount = ((m_msgs.size() * 2) + framesPerBlock - 1) / framesPerBlock;
+
+    struct tpacket_req3 req;
+    memset(&req, 0, sizeof(req));
+    req.tp_block_size = blockSize;
+    req.tp_block_nr = blockCount;
+    req.tp_frame_size = m_txFrameSize;
+    req.tp_frame_nr = blockCount * framesPerBlock;
+
+    if (setsockopt(m_fd, SOL_PACKET, PACKET_TX_RING, &req, sizeof(req)) < 0) {
+        LogWarn(VB_CHANNELOUT, "ColorLight: Unable to create PACKET_TX_RING: %s\n", strerror(errno));
+        return false;
+    }
+
+    m_txRingSize = (size_t)blockSize * blockCount;
+    m_txRing = (unsigned char*)mmap(NULL, m_txRingSize, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    if (m_txRing == MAP_FAILED) {
+        LogWarn(VB_CHANNELOUT, "ColorLight: Unable to mmap TX ring: %s\n", strerror(errno));
+        m_txRing = nullptr;
+        m_txRingSize = 0;
+        return false;
+    }
+
+    m_txFrameCount = req.tp_frame_nr;
+    m_txHead = 0;
+
+    LogDebug(VB_CHANNELOUT, "ColorLight: Using %u frame TX ring for %d packets per frame\n",
+             m_txFrameCount, (int)m_msgs.size());
+
+    return true;
+#endif
+}
+
+void ColorLight5a75Output::CloseTxRing(void) {
+#ifndef PLATFORM_OSX
+    if (m_txRing) {
+        munmap(m_txRing, m_txRingSize);
+        m_txRing = nullptr;
+        m_txRingSize = 0;
+    }
+#endif
+    m_useTxRing = false;
+}
+
+/*
+ * Claim the next set of ring slots for this frame, fill in the static
+ * packet headers and point m_packetData at the slot payloads so PrepData
+ * renders the rows directly into the ring.  If the kernel still owns any
+ * of the slots after 22ms the frame is dropped, it is rendered into
+ * m_outputFrame instead and SendTxRing doesn't queue anything.
+ */
+void ColorLight5a75Output::PrepTxRingFrames(void) {
+#ifndef PLATFORM_OSX
+    int packetCount = m_msgs.size();
+    long long startTime = GetTimeMS();
+
+    m_txSkipFrame = false;
+    for (int p = 0; p < packetCount; p++) {
+        struct tpacket3_hdr* hdr = (struct tpacket3_hdr*)(m_txRing + (size_t)((m_txHead + p) % m_txFrameCount) * m_txFrameSize);
+
+        // The kernel may still be transmitting the previous frame from
+        // this slot if the interface has fallen behind
+        while (__atomic_load_n(&hdr->tp_status, __ATOMIC_ACQUIRE) & (TP_STATUS_SEND_REQUEST | TP_STATUS_SENDING)) {
+            if ((GetTimeMS() - startTime) >= 22) {
+                m_txSkipFrame = true;
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+        if (m_txSkipFrame) {
+            break;
+        }
+    }
+    if (m_txSkipFrame) {
+        for (int p = 0; p < packetCount; p++) {
+            m_packetData[p] = (unsigned char*)m_iovecs[p * 2 + 1].iov_base;
+        }
+        m_txDroppedFrames++;
+        long long now = GetTimeMS();
+        if ((now - m_txLastDropWarning) > 10000) {
+            m_txLastDropWarning = now;
+            LogWarn(VB_CHANNELOUT, "ColorLight TX ring still busy after 22ms, dropping frame (%llu dropped so far)\n",
+                    m_txDroppedFrames);
+        }
+        return;
+    }
+
+    for (int p = 0; p < packetCount; p++) {
+        unsigned char* slot = m_txRing + (size_t)((m_txHead + p) % m_txFrameCount) * m_txFrameSize;
+        struct tpacket3_hdr* hdr = (struct tpacket3_hdr*)slot;
+
+        unsigned char* data = slot + CL5A75_TX_DATA_OFFSET;
+        struct iovec* iov = &m_iovecs[p * 2];
+
+        memcpy(data, iov[0].iov_base, iov[0].iov_len);
+
+        // Only the two init packets have static payloads, the rest
+        // are filled in with pixel data by PrepData.  The slot still
+        // holds whatever packet last used it, so clear the parts of the
+        // rows that no panel writes to.
+        if (p < 2)
+            memcpy(data + iov[0].iov_len, iov[1].iov_base, iov[1].iov_len);
+        else
+            memset(data + iov[0].iov_len, 0, iov[1].iov_len);
+
+        hdr->tp_next_offset = 0;
+        hdr->tp_len = iov[0].iov_len + iov[1].iov_len;
+        hdr->tp_snaplen = hdr->tp_len;
+
+        m_packetData[p] = data + iov[0].iov_len;
+    }
+#endif
+}
+
+/*
+ * Hand the prepared ring slots to the kernel and kick them out with a
+ * single send() call.
+ */
+int ColorLight5a75Output::SendTxRing(void) {
+#ifndef PLATFORM_OSX
+    if (m_txSkipFrame) {
+        // nothing was queued for this frame, just give the kernel another
+        // chance at whatever is still pending
+        send(m_fd, NULL, 0, MSG_DONTWAIT);
+        return m_channelCount;
+    }
+
+    int packetCount = m_msgs.size();
+    long long startTime = GetTimeMS();
+
+    for (int p = 0; p < packetCount; p++) {
+        struct tpacket3_hdr* hdr = (struct tpacket3_hdr*)(m_txRing + (size_t)((m_txHead + p) % m_txFrameCount) * m_txFrameSize);
+        __atomic_store_n(&hdr->tp_status, TP_STATUS_SEND_REQUEST, __ATOMIC_RELEASE);
+    }
+
+    struct tpacket3_hdr* last = (struct tpacket3_hdr*)(m_txRing + (size_t)((m_txHead + packetCount - 1) % m_txFrameCount) * m_txFrameSize);
+    m_txHead = (m_txHead + packetCount) % m_txFrameCount;
+
+    // Frames the kernel could not queue stay in TP_STATUS_SEND_REQUEST
+    // and are picked up again by the next send() call
+    int errCount = 0;
+    bool done = false;
+    while (!done) {
+        errno = 0;
+        if (send(m_fd, NULL, 0, MSG_DONTWAIT) < 0 && errno != EAGAIN && errno != ENOBUFS) {
+            done = true;
+        } else if (__atomic_load_n(&last->tp_status, __ATOMIC_ACQUIRE) != TP_STATUS_SEND_REQUEST) {
+            m_slowCount = 0;
+            return m_channelCount;
+        } else if ((GetTimeMS() - startTime) < 22) {
+            errCount++;
+            std::this_thread::sleep_for(std::chrono::microseconds(500));
+        } else {
+            done = true;
+        }
+    }
+
+    int tti = (int)(GetTimeMS() - startTime);
+    LogWarn(VB_CHANNELOUT, "send() failed for ColorLight TX ring (Socket: %d   packets: %d   time: %dms) with error: %d   %s, errorcount: %d\n",
+            m_fd, packetCount, tti, errno, strerror(errno), errCount);
+    m_slowCount++;
+    if (m_slowCount > 3) {
+        LogWarn(VB_CHANNELOUT, "Repeated frames taking more than 20ms to send to ColorLight");
+        WarningHolder::AddWarningTimeout("Repeated frames taking more than 20ms to send to ColorLight", 30);
+    }
+#endif
+    return m_channelCount;
+}
+
 /*
  *
  */
@@ -660,6 +904,10 @@ void ColorLight5a75Output::DumpConfig(void) {
     LogDebug(VB_CHANNELOUT, "    Longest Chain  : %d\n", m_longestChain);
     LogDebug(VB_CHANNELOUT, "    Inverted Data  : %d\n", m_invertedData);
     LogDebug(VB_CHANNELOUT, "    Interface      : %s\n", m_ifName.c_str());
+    LogDebug(VB_CHANNELOUT, "    TX Ring        : %s\n", m_useTxRing ? "Yes" : "No");
+    if (m_useTxRing) {
+        LogDebug(VB_CHANNELOUT, "    TX Ring Frames : %u x %u bytes\n", m_txFrameCount, m_txFrameSize);
+    }
 
     ChannelOutput::DumpConfig();
 }
@@ -56,6 +56,11 @@ private:
     void SetHostMACs(void* data);
     int sendMessages(struct mmsghdr* msgs, int cnt);
 
+    bool SetupTxRing(void);
+    void CloseTxRing(void);
+    void PrepTxRingFrames(void);
+    int SendTxRing(void);
+
     int m_width;
     int m_height;
     std::string m_layout;
@@ -86,6 +91,22 @@ private:
     std::vector<struct mmsghdr> m_msgs;
     std::vector<struct iovec> m_iovecs;
 
+    // Pixel data destination for each packet, either in m_outputFrame
+    // or in the current slot of the TX ring
+    std::vector<unsigned char*> m_packetData;
+    int m_packetsPerRow;
+
+    // PACKET_MMAP TX ring
+    bool m_useTxRing;
+    unsigned char* m_txRing;
+    size_t m_txRingSize;
+    unsigned int m_txFrameSize;
+    unsigned int m_txFrameCount;
+    unsigned int m_txHead;
+    bool m_txSkipFrame; // slots were still busy, the frame is not sent
+    unsigned long long m_txDroppedFrames;
+    long long m_txLastDropWarning;
+
     struct ifreq m_if_idx;
     struct ifreq m_if_mac;
     struct ether_header* m_eh;
@@ -88,6 +88,7 @@
 #include <errno.h>
 #include <netdb.h>
 #include <signal.h>
+#include <unistd.h>
 
 #include "../Warnings.h"
 #include "../log.h"
@@ -109,20 +110,49 @@
 #define DDP_ID_CONFIG 250
 #define DDP_ID_STATUS 251
 
-//1440 channels per packet
+//1440 channels per packet on a standard 1500 byte MTU network
 #define DDP_CHANNELS_PER_PACKET 1440
 
-#define DDP_PACKET_LEN (DDP_HEADER_LEN + DDP_CHANNELS_PER_PACKET)
+// IP + UDP header overhead
+#define DDP_IP_UDP_OVERHEAD 28
+#define DDP_MAX_MTU 9000
 
 static const std::string DDPTYPE = "DDP";
 
+// All the DDP outputs, by destination, in the order they were configured
+static std::map<in_addr_t, std::list<DDPOutputData*>> DDP_DESTINATIONS;
+
+static int getInterfaceMTU(const sockaddr_in& addr) {
+    int mtu = 0;
+#ifdef IP_MTU
+    // a connected UDP socket reports the MTU of the route to the destination
+    int s = socket(AF_INET, SOCK_DGRAM, 0);
+    if (s >= 0) {
+        if (connect(s, (const struct sockaddr*)&addr, sizeof(addr)) == 0) {
+            socklen_t len = sizeof(mtu);
+            if (getsockopt(s, IPPROTO_IP, IP_MTU, &mtu, &len) != 0) {
+                mtu = 0;
+            }
+        }
+        close(s);
+    }
+#endif
+    return mtu;
+}
+
 const std::string& DDPOutputData::GetOutputTypeString() const {
     return DDPTYPE;
 }
 
 DDPOutputData::DDPOutputData(const Json::Value& config) :
     UDPOutputData(config),
-    sequenceNumber(1) {
+    sequenceNumber(1),
+    pktCount(0),
+    mtu(0),
+    channelsPerPacket(DDP_CHANNELS_PER_PACKET),
+    coalesce(true),
+    layoutDone(false),
+    runChannelCount(channelCount) {
     memset((char*)&ddpAddress, 0, sizeof(sockaddr_in));
     ddpAddress.sin_family = AF_INET;
     ddpAddress.sin_port = htons(DDP_PORT);
@@ -132,19 +162,80 @@ DDPOutputData::DDPOutputData(const Json::Value& config) :
         WarningHolder::AddWarning("Could not resolve host name " + ipAddress + " - disabling output");
         active = false;
     }
+    // active is changed at runtime if the controller stops responding
+    enabled = active;
+    if (config.isMember("coalesce")) {
+        coalesce = config["coalesce"].asInt() ? true : false;
+    }
+    if (config.isMember("mtu")) {
+        // Larger (jumbo) packets are only used if configured as the controller
+        // needs to support them, but never exceed the interface MTU
+        mtu = config["mtu"].asInt();
+        if (mtu > DDP_MAX_MTU) {
+            mtu = DDP_MAX_MTU;
+        }
+        if (mtu > 0 && valid) {
+            int ifMtu = getInterfaceMTU(ddpAddress);
+            if (ifMtu > 0 && ifMtu < mtu) {
+                LogInfo(VB_CHANNELOUT, "DDP: Limiting MTU for %s to interface MTU of %d\n", ipAddress.c_str(), ifMtu);
+                mtu = ifMtu;
+            }
+        }
+        if (mtu > 0) {
+            // keep whole RGB pixels in each packet
+            channelsPerPacket = (mtu - DDP_IP_UDP_OVERHEAD - DDP_HEADER_LEN) / 3 * 3;
+            if (channelsPerPacket < 3) {
+                channelsPerPacket = DDP_CHANNELS_PER_PACKET;
+            }
+        }
+    }
 
-    pktCount = channelCount / DDP_CHANNELS_PER_PACKET;
-    if (channelCount % DDP_CHANNELS_PER_PACKET) {
+    ddpOffset = startChannel - 1;
+    if (type == 5) {
+        ddpOffset = 0;
+    }
+    BuildPackets();
+    if (valid) {
+        DDP_DESTINATIONS[ddpAddress.sin_addr.s_addr].push_back(this);
+    }
+}
+DDPOutputData::~DDPOutputData() {
+    auto it = DDP_DESTINATIONS.find(ddpAddress.sin_addr.s_addr);
+    if (it != DDP_DESTINATIONS.end()) {
+        it->second.remove(this);
+        for (auto o : it->second) {
+            o->layoutDone = false;
+        }
+        if (it->second.empty()) {
+            DDP_DESTINATIONS.erase(it);
+        }
+    }
+    FreePackets();
+}
+
+void DDPOutputData::FreePackets() {
+    for (int x = 0; x < pktCount; x++) {
+        free(ddpBuffers[x]);
+    }
+    free(ddpBuffers);
+    free(ddpIovecs);
+    ddpBuffers = nullptr;
+    ddpIovecs = nullptr;
+    pktCount = 0;
+}
+
+void DDPOutputData::BuildPackets() {
+    FreePackets();
+
+    pktCount = runChannelCount / channelsPerPacket;
+    if (runChannelCount % channelsPerPacket) {
         pktCount++;
     }
 
     ddpIovecs = (struct iovec*)calloc(pktCount * 2, sizeof(struct iovec));
     ddpBuffers = (unsigned char**)calloc(pktCount, sizeof(unsigned char*));
 
-    int chan = startChannel - 1;
-    if (type == 5) {
-        chan = 0;
-    }
+    int chan = ddpOffset;
     for (int x = 0; x < pktCount; x++) {
         ddpBuffers[x] = (unsigned char*)calloc(1, DDP_HEADER_LEN);
 
@@ -158,12 +249,12 @@ DDPOutputData::DDPOutputData(const Json::Value& config) :
         ddpBuffers[x][0] = DDP_FLAGS1_VER1;
         ddpBuffers[x][2] = 0;
         ddpBuffers[x][3] = DDP_ID_DISPLAY;
-        int pktSize = DDP_CHANNELS_PER_PACKET;
+        int pktSize = channelsPerPacket;
         if (x == (pktCount - 1)) {
             ddpBuffers[x][0] = DDP_FLAGS1_VER1 | DDP_FLAGS1_PUSH;
             //last packet
-            if (channelCount % DDP_CHANNELS_PER_PACKET) {
-                pktSize = channelCount % DDP_CHANNELS_PER_PACKET;
+            if (runChannelCount % channelsPerPacket) {
+                pktSize = runChannelCount % channelsPerPacket;
             }
         }
         ddpIovecs[x * 2 + 1].iov_len = pktSize;
@@ -181,23 +272,56 @@ DDPOutputData::DDPOutputData(const Json::Value& config) :
         chan += pktSize;
     }
 }
-DDPOutputData::~DDPOutputData() {
-    for (int x = 0; x < pktCount; x++) {
-        free(ddpBuffers[x]);
+
+void DDPOutputData::LayoutDestination(in_addr_t addr) {
+    std::list<DDPOutputData*>& outputs = DDP_DESTINATIONS[addr];
+    DDPOutputData* leader = nullptr;
+    DDPOutputData* prev = nullptr;
+    for (auto o : outputs) {
+        o->layoutDone = true;
+        o->runChannelCount = o->channelCount;
+
+        // an output continues the previous run if both the source channels
+        // and the DDP offsets follow on directly
+        if (leader && o->coalesce && leader->coalesce && o->enabled && leader->enabled &&
+            o->channelsPerPacket == leader->channelsPerPacket &&
+            o->deDuplicate == leader->deDuplicate &&
+            o->startChannel == (prev->startChannel + prev->channelCount) &&
+            o->ddpOffset == (prev->ddpOffset + prev->channelCount)) {
+            o->coalescedInto = leader;
+            leader->runChannelCount += o->channelCount;
+            LogDebug(VB_CHANNELOUT, "DDP: Output %s (%d-%d) sent with output starting at %d\n",
+                     o->ipAddress.c_str(), o->startChannel, o->startChannel + o->channelCount - 1,
+                     leader->startChannel);
+        } else {
+            leader = o;
+            leader->coalescedInto = nullptr;
+        }
+        prev = o;
     }
-    free(ddpBuffers);
-    free(ddpIovecs);
+    for (auto o : outputs) {
+        if (!o->coalescedInto) {
+            o->BuildPackets();
+        }
+    }
+}
+
+void DDPOutputData::GetRequiredChannelRange(int& min, int& max) {
+    min = startChannel - 1;
+    max = startChannel + std::max(channelCount, runChannelCount) - 1;
 }
 
 void DDPOutputData::PrepareData(unsigned char* channelData, UDPOutputMessages& msgs) {
-    if (valid && active) {
+    if (!layoutDone) {
+        LayoutDestination(ddpAddress.sin_addr.s_addr);
+    }
+    if (valid && active && !coalescedInto) {
         int start = 0;
         struct mmsghdr msg;
         memset(&msg, 0, sizeof(msg));
 
         msg.msg_hdr.msg_name = &ddpAddress;
         msg.msg_hdr.msg_namelen = sizeof(sockaddr_in);
-        bool anySkipped = false;
         bool allSkipped = true;
         for (int p = 0; p < pktCount; p++) {
             bool nto = NeedToOutputFrame(channelData, startChannel - 1, start, ddpIovecs[p * 2 + 1].iov_len);
@@ -224,27 +348,48 @@ void DDPOutputData::PrepareData(unsigned char* channelData, UDPOutputMessages& m
                 // set the pointer to the channelData for the universe
                 ddpIovecs[p * 2 + 1].iov_base = (void*)(&channelData[startChannel - 1 + start]);
                 allSkipped = false;
-            } else {
-                anySkipped = true;
             }
             start += ddpIovecs[p * 2 + 1].iov_len;
         }
-        if (anySkipped) {
-            skippedFrames++;
-        } else {
-            skippedFrames = 0;
+    }
+}
+
+void DDPOutputData::PostPrepareData(unsigned char* channelData, UDPOutputMessages& msgs) {
+    // only the first active output for the controller needs to do this
+    for (auto o : DDP_DESTINATIONS[ddpAddress.sin_addr.s_addr]) {
+        if (o->valid && o->active) {
+            if (o != this) {
+                return;
+            }
+            break;
         }
-        if (!allSkipped) {
-            SaveFrame(&channelData[startChannel - 1], start);
+    }
+    // Each run ends with a PUSH, but the controller should only display
+    // once per frame so only the last DDP packet to it keeps the flag
+    std::vector<struct mmsghdr>& m = msgs[ddpAddress.sin_addr.s_addr];
+    bool last = true;
+    for (int x = m.size() - 1; x >= 0; x--) {
+        const sockaddr_in* addr = (const sockaddr_in*)m[x].msg_hdr.msg_name;
+        if (addr && addr->sin_port == ddpAddress.sin_port && m[x].msg_hdr.msg_iovlen == 2 && m[x].msg_hdr.msg_iov[0].iov_len == DDP_HEADER_LEN) {
+            unsigned char* header = (unsigned char*)m[x].msg_hdr.msg_iov[0].iov_base;
+            if (last) {
+                header[0] |= DDP_FLAGS1_PUSH;
+                last = false;
+            } else {
+                header[0] &= ~DDP_FLAGS1_PUSH;
+            }
         }
     }
 }
+
 void DDPOutputData::DumpConfig() {
-    LogDebug(VB_CHANNELOUT, "DDP: %s   %d:%d:%d:%d  %s\n",
+    LogDebug(VB_CHANNELOUT, "DDP: %s   %d:%d:%d:%d  %s  MTU: %d  Channels/Packet: %d\n",
              description.c_str(),
              active,
              startChannel,
              channelCount,
              type,
-             ipAddress.c_str());
+             ipAddress.c_str(),
+             mtu,
+             channelsPerPacket);
 }
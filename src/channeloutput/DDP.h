@@ -26,8 +26,11 @@ public:
 
     virtual bool IsPingable() override { return true; }
     virtual void PrepareData(unsigned char* channelData, UDPOutputMessages& msgs) override;
+    virtual void PostPrepareData(unsigned char* channelData, UDPOutputMessages& msgs) override;
     virtual void DumpConfig() override;
 
+    virtual void GetRequiredChannelRange(int& min, int& max) override;
+
     virtual const std::string& GetOutputTypeString() const override;
 
     char sequenceNumber;
@@ -35,6 +38,22 @@ public:
     sockaddr_in ddpAddress;
     int pktCount;
 
+    int mtu;
+    int channelsPerPacket;
+    int ddpOffset;
+
+    // Outputs to the same controller with contiguous channel ranges are
+    // sent as a single run by the first output of the run
+    bool coalesce;
+    bool enabled;
+    bool layoutDone;
+    DDPOutputData* coalescedInto = nullptr;
+    int runChannelCount;
+
+    void BuildPackets();
+    void FreePackets();
+    static void LayoutDestination(in_addr_t addr);
+
     struct iovec* ddpIovecs = nullptr;
     unsigned char** ddpBuffers = nullptr;
 };
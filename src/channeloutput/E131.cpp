@@ -51,13 +51,19 @@ const unsigned char E131header[] = {
 
 static const std::string E131TYPE = "e1.31";
 
+// Sequence numbers for sync packets are per sync universe, not per output,
+// as multiple outputs may share a sync universe
+static std::map<int, unsigned char> e131SyncSequences;
+
 const std::string& E131OutputData::GetOutputTypeString() const {
     return E131TYPE;
 }
 
 E131OutputData::E131OutputData(const Json::Value& config) :
     UDPOutputData(config),
-    universeCount(1) {
+    universeCount(1),
+    syncUniverse(0),
+    dataQueued(false) {
     sockaddr_in e131Address;
     memset((char*)&e131Address, 0, sizeof(sockaddr_in));
     e131Address.sin_family = AF_INET;
@@ -71,6 +77,12 @@ E131OutputData::E131OutputData(const Json::Value& config) :
     if (universeCount < 1) {
         universeCount = 1;
     }
+    if (config.isMember("syncUniverse")) {
+        syncUniverse = config["syncUniverse"].asInt();
+        if (syncUniverse < 0 || syncUniverse > 63999) {
+            syncUniverse = 0;
+        }
+    }
     switch (type) {
     case 0: // Multicast
         ipAddress = "";
@@ -118,6 +130,8 @@ E131OutputData::E131OutputData(const Json::Value& config) :
 
         int uni = universe + x;
         e131Buffer[E131_PRIORITY_INDEX] = priority;
+        e131Buffer[E131_SYNC_ADDRESS_INDEX] = (char)(syncUniverse / 256);
+        e131Buffer[E131_SYNC_ADDRESS_INDEX + 1] = (char)(syncUniverse % 256);
         e131Buffer[E131_UNIVERSE_INDEX] = (char)(uni / 256);
         e131Buffer[E131_UNIVERSE_INDEX + 1] = (char)(uni % 256);
 
@@ -150,6 +164,28 @@ E131OutputData::E131OutputData(const Json::Value& config) :
         e131Iovecs[x * 2 + 1].iov_base = nullptr;
         e131Iovecs[x * 2 + 1].iov_len = channelCount;
     }
+
+    // Synchronization packet, sent to the sync universe's multicast
+    // address or to the controller for unicast outputs
+    syncAddress = e131Addresses[0];
+    if (type == E131_TYPE_MULTICAST) {
+        char sAddress[32];
+        snprintf(sAddress, sizeof(sAddress), "239.255.%d.%d", syncUniverse / 256, syncUniverse % 256);
+        syncAddress.sin_addr.s_addr = inet_addr(sAddress);
+    }
+    memset(syncPacket, 0, E131_SYNC_PACKET_LENGTH);
+    // Root layer preamble and CID are the same as the data packets
+    memcpy(syncPacket, E131header, 38);
+    syncPacket[E131_RLP_COUNT_INDEX] = 0x70;
+    syncPacket[E131_RLP_COUNT_INDEX + 1] = E131_SYNC_PACKET_LENGTH - 16;
+    syncPacket[E131_VECTOR_INDEX] = VECTOR_ROOT_E131_EXTENDED;
+    syncPacket[E131_FRAMING_COUNT_INDEX] = 0x70;
+    syncPacket[E131_FRAMING_COUNT_INDEX + 1] = E131_SYNC_PACKET_LENGTH - 38;
+    syncPacket[E131_EXTENDED_PACKET_TYPE_INDEX] = VECTOR_E131_EXTENDED_SYNCHRONIZATION;
+    syncPacket[E131_SYNC_UNIVERSE_INDEX] = (char)(syncUniverse / 256);
+    syncPacket[E131_SYNC_UNIVERSE_INDEX + 1] = (char)(syncUniverse % 256);
+    syncIovec.iov_base = syncPacket;
+    syncIovec.iov_len = E131_SYNC_PACKET_LENGTH;
 }
 
 E131OutputData::~E131OutputData() {
@@ -163,11 +199,10 @@ bool E131OutputData::IsPingable() {
 }
 
 void E131OutputData::PrepareData(unsigned char* channelData, UDPOutputMessages& msgs) {
+    dataQueued = false;
     if (valid && active) {
         unsigned char* cur = channelData + startChannel - 1;
         int start = 0;
-        bool anySkipped = false;
-        bool allSkipped = true;
         for (int x = 0; x < universeCount; x++) {
             if (NeedToOutputFrame(channelData, startChannel - 1, start, channelCount)) {
                 struct mmsghdr msg;
@@ -186,22 +221,42 @@ void E131OutputData::PrepareData(unsigned char* channelData, UDPOutputMessages&
 
                 ++e131Headers[x][E131_SEQUENCE_INDEX];
                 e131Iovecs[x * 2 + 1].iov_base = (void*)cur;
-                allSkipped = false;
-            } else {
-                anySkipped = true;
+                dataQueued = true;
             }
             cur += channelCount;
             start += channelCount;
         }
-        if (anySkipped) {
-            skippedFrames++;
-        } else {
-            skippedFrames = 0;
-        }
-        if (!allSkipped) {
-            SaveFrame(&channelData[startChannel - 1], start);
+    }
+}
+
+void E131OutputData::PostPrepareData(unsigned char* channelData, UDPOutputMessages& msgs) {
+    if (!valid || !active || !syncUniverse || !dataQueued) {
+        return;
+    }
+    // Sync packets go out after all the data for the frame has been sent.
+    // Outputs sharing a sync universe and destination only need one.
+    std::vector<struct mmsghdr>& late = msgs[LATE_MULTICAST_MESSAGES_KEY];
+    for (auto& m : late) {
+        if (m.msg_hdr.msg_iovlen == 1 && m.msg_hdr.msg_iov->iov_len == E131_SYNC_PACKET_LENGTH) {
+            const sockaddr_in* addr = (const sockaddr_in*)m.msg_hdr.msg_name;
+            const unsigned char* pkt = (const unsigned char*)m.msg_hdr.msg_iov->iov_base;
+            if (addr->sin_addr.s_addr == syncAddress.sin_addr.s_addr &&
+                pkt[E131_SYNC_UNIVERSE_INDEX] == syncPacket[E131_SYNC_UNIVERSE_INDEX] &&
+                pkt[E131_SYNC_UNIVERSE_INDEX + 1] == syncPacket[E131_SYNC_UNIVERSE_INDEX + 1]) {
+                return;
+            }
         }
     }
+    syncPacket[E131_SYNC_SEQUENCE_INDEX] = e131SyncSequences[syncUniverse]++;
+
+    struct mmsghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_hdr.msg_name = &syncAddress;
+    msg.msg_hdr.msg_namelen = sizeof(sockaddr_in);
+    msg.msg_hdr.msg_iov = &syncIovec;
+    msg.msg_hdr.msg_iovlen = 1;
+    msg.msg_len = E131_SYNC_PACKET_LENGTH;
+    late.push_back(msg);
 }
 
 void E131OutputData::GetRequiredChannelRange(int& min, int& max) {
@@ -210,7 +265,7 @@ void E131OutputData::GetRequiredChannelRange(int& min, int& max) {
 }
 
 void E131OutputData::DumpConfig() {
-    LogDebug(VB_CHANNELOUT, "E1.31 Universe: %s   %d:%d:%d:%d:%d:%d  %s\n",
+    LogDebug(VB_CHANNELOUT, "E1.31 Universe: %s   %d:%d:%d:%d:%d:%d  %s  Sync: %d\n",
              description.c_str(),
              active,
              universe,
@@ -218,5 +273,6 @@ void E131OutputData::DumpConfig() {
              channelCount,
              type,
              universeCount,
-             ipAddress.c_str());
+             ipAddress.c_str(),
+             syncUniverse);
 }
@@ -26,6 +26,7 @@ public:
     virtual bool IsPingable() override;
 
     virtual void PrepareData(unsigned char* channelData, UDPOutputMessages& msgs) override;
+    virtual void PostPrepareData(unsigned char* channelData, UDPOutputMessages& msgs) override;
 
     virtual void DumpConfig() override;
     virtual void GetRequiredChannelRange(int& min, int& max) override;
@@ -39,4 +40,11 @@ public:
     std::vector<sockaddr_in> e131Addresses;
     std::vector<struct iovec> e131Iovecs;
     std::vector<unsigned char*> e131Headers;
+
+    // E1.31 universe synchronization, 0 == disabled
+    int syncUniverse;
+    bool dataQueued;
+    sockaddr_in syncAddress;
+    struct iovec syncIovec;
+    unsigned char syncPacket[E131_SYNC_PACKET_LENGTH];
 };
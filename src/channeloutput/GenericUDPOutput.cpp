@@ -167,10 +167,6 @@ public:
             } else {
                 msgs[udpAddress.sin_addr.s_addr].push_back(msg);
             }
-            SaveFrame(&channelData[startChannel - 1], channelCount);
-            skippedFrames = 0;
-        } else {
-            skippedFrames++;
         }
     }
 
@@ -14,9 +14,11 @@
 
 #include <arpa/inet.h>
 #include <netinet/in.h>
+#include <netinet/udp.h>
 #include <sys/socket.h>
 #include <ifaddrs.h>
 #include <netdb.h>
+#include <pthread.h>
 #include <unistd.h>
 
 #include <curl/curl.h>
@@ -29,6 +31,8 @@
 #include "../settings.h"
 
 #include "UDPOutput.h"
+#include "UDPPacer.h"
+#include "channeloutputthread.h"
 #include "ping.h"
 
 #include "NetworkMonitor.h"
@@ -43,6 +47,11 @@
 
 constexpr int UDP_PING_TIMEOUT = 250;
 
+// Limits for merging packets into a single UDP_SEGMENT send.  Older kernels
+// only allow 64 segments and the datagram itself must fit in 64K
+constexpr int UDP_GSO_MAX_SEGMENTS = 64;
+constexpr int UDP_GSO_MAX_SIZE = 65000;
+
 class UDPPlugin : public FPPPlugins::Plugin, public FPPPlugins::ChannelOutputPlugin {
 public:
     UDPPlugin() :
@@ -75,9 +84,34 @@ public:
         }
     }
 
+    void RecordSend(int packets, int sent, long long sendTimeUS) {
+        lastSendTime = sendTimeUS;
+        if (sendTimeUS > maxSendTime) {
+            maxSendTime = sendTimeUS;
+        }
+        totalSendTime += sendTimeUS;
+        ++sendCount;
+        packetCount += sent;
+        if (sent != packets) {
+            ++failedSendCount;
+        }
+    }
+
     std::vector<int> sockets;
     int errCount;
     int curSocket;
+
+    // per destination send statistics, times in microseconds
+    std::atomic<long long> lastSendTime = 0;
+    std::atomic<long long> maxSendTime = 0;
+    std::atomic<long long> totalSendTime = 0;
+    std::atomic<unsigned long long> sendCount = 0;
+    std::atomic<unsigned long long> packetCount = 0;
+    std::atomic<unsigned long long> failedSendCount = 0;
+    // packets that didn't fit in the frame with pacingMaxPPS, the next
+    // frame starts at pacingOffset so the same ones aren't always dropped
+    std::atomic<unsigned long long> pacingDroppedCount = 0;
+    int pacingOffset = 0;
 };
 
 UDPOutputMessages::UDPOutputMessages() {
@@ -129,8 +163,11 @@ UDPOutputData::UDPOutputData(const Json::Value& config) :
     type(0),
     monitor(true),
     failCount(0),
-    lastData(nullptr),
-    skippedFrames(0) {
+    keepAliveInterval(250),
+    lastKeepAlive(0),
+    keepAliveFrame(false),
+    lastDataSize(0),
+    lastData(nullptr) {
     if (config.isMember("description")) {
         description = config["description"].asString();
     }
@@ -153,6 +190,9 @@ UDPOutputData::UDPOutputData(const Json::Value& config) :
     if (config.isMember("deDuplicate")) {
         deDuplicate = config["deDuplicate"].asInt() ? true : false;
     }
+    if (config.isMember("deDuplicateKeepAlive")) {
+        keepAliveInterval = config["deDuplicateKeepAlive"].asInt();
+    }
 }
 UDPOutputData::~UDPOutputData() {
     if (lastData) {
@@ -187,66 +227,61 @@ in_addr_t UDPOutputData::toInetAddr(const std::string& ipAddress, bool& valid) {
     return inet_addr(ipAddress.c_str());
 }
 
-void UDPOutputData::SaveFrame(unsigned char* channelData, int len) {
-    if (deDuplicate) {
-        if (lastData == nullptr) {
-            lastData = (unsigned char*)calloc(1, len);
+bool UDPOutputData::NeedToOutputFrame(unsigned char* channelData, int startChannel, int savedIdx, int count) {
+    if (!deDuplicate) {
+        return true;
+    }
+    if (savedIdx == 0) {
+        // first block of the frame, see if everything needs to be
+        // resent so controllers that time out on no data stay lit
+        long long now = GetTimeMS();
+        keepAliveFrame = (now - lastKeepAlive) >= keepAliveInterval;
+        if (keepAliveFrame) {
+            lastKeepAlive = now;
         }
-        /*
-        printf("Saving: %d   %2X%2X%2X %2X%2X%2X %2X%2X%2X %2X%2X%2X\n", len,
-               channelData[0], channelData[1], channelData[2], channelData[3], channelData[4], channelData[5],
-               channelData[6], channelData[7], channelData[8], channelData[9], channelData[10], channelData[11]);
-         */
-        memcpy(lastData, channelData, len);
     }
-}
+    if (lastData == nullptr) {
+        int mi, mx;
+        GetRequiredChannelRange(mi, mx);
+        lastDataSize = mx - mi + 1;
+        lastData = (unsigned char*)calloc(1, lastDataSize);
+        keepAliveFrame = true;
+    }
+    if ((savedIdx + count) > lastDataSize) {
+        return true;
+    }
 
-bool UDPOutputData::NeedToOutputFrame(unsigned char* channelData, int startChannel, int savedIdx, int count) {
-    if (deDuplicate && skippedFrames < 10) {
-        if (lastData == nullptr) {
-            return true;
-        }
-        for (int x = 0; x < count; x++) {
-            if (channelData[x + savedIdx + startChannel] != lastData[x + savedIdx]) {
-                /*
-                printf("ND: %d   %2X%2X%2X %2X%2X%2X %2X%2X%2X %2X%2X%2X\n", x,
-                       lastData[0], lastData[1], lastData[2], lastData[3], lastData[4], lastData[5],
-                       lastData[6], lastData[7], lastData[8], lastData[9], lastData[10], lastData[11]);
-                printf("%d %d    %2X%2X%2X %2X%2X%2X %2X%2X%2X %2X%2X%2X\n", start, startChannel, x,
-                       channelData[start + startChannel + 0], channelData[start + startChannel + 1], channelData[start + startChannel + 2],
-                       channelData[start + startChannel + 3], channelData[start + startChannel + 4], channelData[start + startChannel + 5],
-                       channelData[start + startChannel + 6], channelData[start + startChannel + 7], channelData[start + startChannel + 8],
-                       channelData[start + startChannel + 9], channelData[start + startChannel + 10], channelData[start + startChannel + 11]);
-                 printf("New data %d  %d  %d      %X %X\n", x, startChannel, savedIdx, channelData[x + savedIdx + startChannel], lastData[x + savedIdx]);
-                 */
-                return true;
-            }
-        }
-        return false;
+    unsigned char* cur = channelData + startChannel + savedIdx;
+    unsigned char* last = lastData + savedIdx;
+    // memcmp is vectorized in libc so is far faster than a byte loop,
+    // and only blocks that actually changed need to be copied
+    if (memcmp(cur, last, count) != 0) {
+        memcpy(last, cur, count);
+        return true;
     }
-    return true;
+    return keepAliveFrame;
 }
 
 UDPOutput::UDPOutput(unsigned int startChannel, unsigned int channelCount) :
     networkCallbackId(0),
-    doneWorkCount(0),
+    workGeneration(0),
+    pendingWork(0),
     numWorkThreads(0),
-    runWorkThreads(true),
-    useThreadedOutput(true) {
+    runWorkThreads(false),
+    useThreadedOutput(true),
+    useGSO(false),
+    pacingPercent(0),
+    pacingMaxPPS(0) {
     INSTANCE = this;
 }
 UDPOutput::~UDPOutput() {
-    runWorkThreads = false;
-    workSignal.notify_all();
+    StopWorkThreads();
 
     INSTANCE = nullptr;
     NetworkMonitor::INSTANCE.removeCallback(networkCallbackId);
     for (auto a : outputs) {
         delete a;
     }
-    while (numWorkThreads) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(1));
-    }
 }
 
 int UDPOutput::Init(Json::Value config) {
@@ -288,6 +323,30 @@ int UDPOutput::Init(Json::Value config) {
     if (config.isMember("threaded")) {
         useThreadedOutput = config["threaded"].asInt() ? true : false;
     }
+    numWorkThreads = std::thread::hardware_concurrency();
+    if (config.isMember("threadCount") && config["threadCount"].asInt() > 0) {
+        numWorkThreads = config["threadCount"].asInt();
+    }
+    if (numWorkThreads < 1) {
+        numWorkThreads = 1;
+    }
+    if (config.isMember("pacing")) {
+        pacingPercent = std::clamp(config["pacing"].asInt(), 0, 90);
+    }
+    if (config.isMember("pacingMaxPPS")) {
+        pacingMaxPPS = std::max(config["pacingMaxPPS"].asInt(), 0);
+    }
+#ifdef UDP_SEGMENT
+    if (config.isMember("gso")) {
+        useGSO = config["gso"].asInt() ? true : false;
+    }
+    if (useGSO && pacingPercent) {
+        // a GSO message goes out as one burst of up to UDP_GSO_MAX_SEGMENTS
+        // packets, pacing (and the pps cap) has to work per packet
+        LogInfo(VB_CHANNELOUT, "UDP output pacing is enabled, not using GSO\n");
+        useGSO = false;
+    }
+#endif
     if (config.isMember("interface")) {
         outInterface = config["interface"].asString();
     }
@@ -392,10 +451,14 @@ int UDPOutput::Init(Json::Value config) {
         CurlManager::INSTANCE.processCurls();
         ++sleepCount;
     }
+    if (useThreadedOutput) {
+        StartWorkThreads();
+    }
     return ChannelOutput::Init(config);
 }
 int UDPOutput::Close() {
     NetworkMonitor::INSTANCE.removeCallback(networkCallbackId);
+    StopWorkThreads();
     messages.clearMessages();
     messages.clearSockets();
     return ChannelOutput::Close();
@@ -403,6 +466,9 @@ int UDPOutput::Close() {
 void UDPOutput::PrepData(unsigned char* channelData) {
     if (enabled) {
         std::unique_lock<std::mutex> lk(socketMutex);
+        // a previous frame may have timed out waiting on the work threads,
+        // make sure they are done with the messages before we clear them
+        WaitForWorkThreads();
         messages.clearMessages();
         for (auto a : outputs) {
             if (a->valid && a->active) {
@@ -415,7 +481,107 @@ void UDPOutput::PrepData(unsigned char* channelData) {
                 a->PostPrepareData(channelData, messages);
             }
         }
+        if (useGSO) {
+            for (auto& msgs : messages.messages) {
+                if (msgs.first < FIRST_LATE_MESSAGES_KEY && msgs.second.size() > 1) {
+                    CoalesceGSOMessages(msgs.first, msgs.second);
+                }
+            }
+        }
+    }
+}
+
+static inline size_t messageLength(const struct mmsghdr& msg) {
+    size_t len = 0;
+    for (int x = 0; x < msg.msg_hdr.msg_iovlen; x++) {
+        len += msg.msg_hdr.msg_iov[x].iov_len;
     }
+    return len;
+}
+static inline bool sameDestination(const struct mmsghdr& a, const struct mmsghdr& b) {
+    if (a.msg_hdr.msg_name == b.msg_hdr.msg_name) {
+        return true;
+    }
+    if (a.msg_hdr.msg_name == nullptr || b.msg_hdr.msg_name == nullptr || a.msg_hdr.msg_namelen != b.msg_hdr.msg_namelen) {
+        return false;
+    }
+    const struct sockaddr_in* aa = (const struct sockaddr_in*)a.msg_hdr.msg_name;
+    const struct sockaddr_in* ba = (const struct sockaddr_in*)b.msg_hdr.msg_name;
+    return aa->sin_addr.s_addr == ba->sin_addr.s_addr && aa->sin_port == ba->sin_port;
+}
+
+/*
+ * Merge runs of equal sized packets going to the same address/port into a
+ * single message with a UDP_SEGMENT control message.  The kernel then
+ * builds one large skb and splits it back into the individual packets
+ * (in the NIC if it supports UDP segmentation offload) instead of running
+ * the full UDP/IP stack for every universe.  The last packet of a run may
+ * be shorter, which covers the final DDP packet of an output.
+ */
+void UDPOutput::CoalesceGSOMessages(unsigned int key, std::vector<struct mmsghdr>& msgs) {
+#ifdef UDP_SEGMENT
+    UDPOutputMessages::GSOBuffers& buffers = messages.gsoBuffers[key];
+    int iovCount = 0;
+    for (auto& m : msgs) {
+        iovCount += m.msg_hdr.msg_iovlen;
+    }
+    const size_t cmsgSpace = CMSG_SPACE(sizeof(uint16_t));
+    // size everything up front, pointers into these are handed to the kernel
+    buffers.iovecs.resize(iovCount);
+    buffers.control.assign(cmsgSpace * msgs.size(), 0);
+
+    std::vector<struct mmsghdr> merged;
+    merged.reserve(msgs.size());
+    int iovPos = 0;
+    int ctrlPos = 0;
+    int i = 0;
+    while (i < msgs.size()) {
+        size_t segSize = messageLength(msgs[i]);
+        size_t total = segSize;
+        int j = i + 1;
+        while (j < msgs.size() && (j - i) < UDP_GSO_MAX_SEGMENTS && sameDestination(msgs[i], msgs[j])) {
+            size_t len = messageLength(msgs[j]);
+            if (len > segSize || (total + len) > UDP_GSO_MAX_SIZE) {
+                break;
+            }
+            total += len;
+            ++j;
+            if (len < segSize) {
+                // only the last segment can be short
+                break;
+            }
+        }
+        if ((j - i) == 1) {
+            merged.push_back(msgs[i]);
+            ++i;
+            continue;
+        }
+
+        struct mmsghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_hdr.msg_name = msgs[i].msg_hdr.msg_name;
+        msg.msg_hdr.msg_namelen = msgs[i].msg_hdr.msg_namelen;
+        msg.msg_hdr.msg_iov = &buffers.iovecs[iovPos];
+        for (int x = i; x < j; x++) {
+            for (int v = 0; v < msgs[x].msg_hdr.msg_iovlen; v++) {
+                buffers.iovecs[iovPos++] = msgs[x].msg_hdr.msg_iov[v];
+                ++msg.msg_hdr.msg_iovlen;
+            }
+        }
+        msg.msg_hdr.msg_control = &buffers.control[ctrlPos * cmsgSpace];
+        msg.msg_hdr.msg_controllen = cmsgSpace;
+        struct cmsghdr* cm = CMSG_FIRSTHDR(&msg.msg_hdr);
+        cm->cmsg_level = SOL_UDP;
+        cm->cmsg_type = UDP_SEGMENT;
+        cm->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+        *((uint16_t*)CMSG_DATA(cm)) = segSize;
+        ++ctrlPos;
+        msg.msg_len = total;
+        merged.push_back(msg);
+        i = j;
+    }
+    msgs.swap(merged);
+#endif
 }
 void UDPOutput::GetRequiredChannelRanges(const std::function<void(int, int)>& addRange) {
     if (enabled) {
@@ -433,10 +599,36 @@ void UDPOutput::addOutput(UDPOutputData* out) {
     outputs.push_back(out);
 }
 
-int UDPOutput::SendMessages(unsigned int socketKey, SendSocketInfo* socketInfo, std::vector<struct mmsghdr>& sendmsgs) {
+#ifdef UDP_SEGMENT
+// Undo CoalesceGSOMessages for one message, the segments are split back
+// out along the original packet's iovecs
+static void splitGSOMessage(const struct mmsghdr& msg, std::vector<struct mmsghdr>& out) {
+    if (!msg.msg_hdr.msg_control) {
+        out.push_back(msg);
+        return;
+    }
+    size_t segSize = *((uint16_t*)CMSG_DATA(CMSG_FIRSTHDR(&msg.msg_hdr)));
+    struct mmsghdr m;
+    memset(&m, 0, sizeof(m));
+    m.msg_hdr.msg_name = msg.msg_hdr.msg_name;
+    m.msg_hdr.msg_namelen = msg.msg_hdr.msg_namelen;
+    m.msg_hdr.msg_iov = msg.msg_hdr.msg_iov;
+    size_t len = 0;
+    for (int v = 0; v < msg.msg_hdr.msg_iovlen; v++) {
+        ++m.msg_hdr.msg_iovlen;
+        len += msg.msg_hdr.msg_iov[v].iov_len;
+        if (len >= segSize || v == (msg.msg_hdr.msg_iovlen - 1)) {
+            out.push_back(m);
+            m.msg_hdr.msg_iov = &msg.msg_hdr.msg_iov[v + 1];
+            m.msg_hdr.msg_iovlen = 0;
+            len = 0;
+        }
+    }
+}
+#endif
+
+int UDPOutput::SendMessages(unsigned int socketKey, SendSocketInfo* socketInfo, struct mmsghdr* msgs, int msgCount) {
     errno = 0;
-    struct mmsghdr* msgs = &sendmsgs[0];
-    int msgCount = sendmsgs.size();
     if (msgCount == 0) {
         return 0;
     }
@@ -463,6 +655,29 @@ int UDPOutput::SendMessages(unsigned int socketKey, SendSocketInfo* socketInfo,
                errno,
                strerror(errno));
 
+#ifdef UDP_SEGMENT
+        if (useGSO && (errno == EIO || errno == EINVAL) && msgs[outputCount].msg_hdr.msg_control) {
+            // kernel or interface cannot do UDP segmentation (usually no
+            // checksum offload), go back to sending individual packets
+            LogWarn(VB_CHANNELOUT, "UDP GSO send failed, disabling GSO for UDP output: %s\n", strerror(errno));
+            WarningHolder::AddWarningTimeout("UDP GSO not supported by interface " + outInterface + ", disabled", 60);
+            useGSO = false;
+
+            // send the rest of this frame as individual packets
+            std::vector<struct mmsghdr> single;
+            std::vector<int> owners;
+            for (int m = outputCount; m < msgCount; m++) {
+                splitGSOMessage(msgs[m], single);
+                owners.resize(single.size(), m);
+            }
+            int sent = SendMessages(socketKey, socketInfo, &single[0], single.size());
+            if (sent == (int)single.size()) {
+                return msgCount;
+            }
+            // everything before the message the first unsent packet came from went out
+            return owners[sent];
+        }
+#endif
         int newSock = sendSocket;
         if (errno == EAGAIN || errno == EWOULDBLOCK) {
             if (socketKey != BROADCAST_MESSAGES_KEY) {
@@ -492,46 +707,204 @@ int UDPOutput::SendMessages(unsigned int socketKey, SendSocketInfo* socketInfo,
     return outputCount;
 }
 
-static void DoWorkThread(UDPOutput* output) {
-    SetThreadName("FPP-UDPWork");
-    output->BackgroundOutputWork();
+static void DoWorkThread(UDPOutput* output, int shard) {
+    SetThreadName("FPP-UDPWork-" + std::to_string(shard));
+    output->BackgroundOutputWork(shard);
+}
+
+void UDPOutput::StartWorkThreads() {
+    if (!workThreads.empty()) {
+        return;
+    }
+    runWorkThreads = true;
+    workShards.resize(numWorkThreads);
+    int cpus = std::thread::hardware_concurrency();
+    for (int x = 0; x < numWorkThreads; x++) {
+        workThreads.emplace_back(DoWorkThread, this, x);
+#ifndef PLATFORM_OSX
+        if (cpus > 1) {
+            // keep the senders off of CPU 0 which tends to be busy with
+            // interrupt handling and the main fppd threads
+            cpu_set_t cpuset;
+            CPU_ZERO(&cpuset);
+            CPU_SET(1 + (x % (cpus - 1)), &cpuset);
+            pthread_setaffinity_np(workThreads.back().native_handle(), sizeof(cpuset), &cpuset);
+        }
+#endif
+    }
+    LogDebug(VB_CHANNELOUT, "Started %d UDP output threads\n", numWorkThreads);
+}
+
+void UDPOutput::StopWorkThreads() {
+    std::unique_lock<std::mutex> lock(workMutex);
+    runWorkThreads = false;
+    lock.unlock();
+    workSignal.notify_all();
+    for (auto& t : workThreads) {
+        t.join();
+    }
+    workThreads.clear();
+    // GetStats reads the shard assignments under socketMutex
+    std::unique_lock<std::mutex> slock(socketMutex);
+    workShards.clear();
+    workShardKeys.clear();
+    pendingWork = 0;
+}
+
+void UDPOutput::WaitForWorkThreads() {
+    std::unique_lock<std::mutex> lock(workMutex);
+    doneSignal.wait(lock, [this] { return pendingWork == 0; });
+}
+
+int UDPOutput::GetWorkShard(unsigned int key) {
+    // Keys are assigned to threads round robin as they are first seen and
+    // stay with that thread so a socket is only ever used by one thread
+    auto it = workShardKeys.find(key);
+    if (it != workShardKeys.end()) {
+        return it->second;
+    }
+    int shard = workShardKeys.size() % numWorkThreads;
+    workShardKeys[key] = shard;
+    return shard;
+}
+
+void UDPOutput::RecordWorkItemSend(WorkItem& i, int outputCount, long long diff, int dropped) {
+    int expected = (int)i.msgs.size() - dropped;
+    i.socketInfo->RecordSend(expected, outputCount, diff);
+    if ((outputCount != expected) || (diff > 100000)) {
+        i.socketInfo->errCount++;
+
+        // failed to send all messages or it took more than 100ms to send them
+        LogErr(VB_CHANNELOUT, "sendmmsg() failed for UDP output (key: %X   output count: %d/%d   time: %u ms    errCount: %d) with error: %d   %s\n",
+               i.id,
+               outputCount, expected, (unsigned int)(diff / 1000), i.socketInfo->errCount,
+               errno,
+               strerror(errno));
+    } else {
+        i.socketInfo->errCount = 0;
+    }
 }
 
-void UDPOutput::BackgroundOutputWork() {
+void UDPOutput::SendWorkItems(std::vector<WorkItem>& items) {
+    if (pacingPercent) {
+        SendPacedWorkItems(items);
+        return;
+    }
     std::chrono::high_resolution_clock clock;
-    while (runWorkThreads) {
-        std::unique_lock<std::mutex> lock(workMutex);
-        if (workQueue.empty()) {
-            workSignal.wait(lock);
-        }
-        if (!workQueue.empty()) {
-            WorkItem i = workQueue.front();
-            workQueue.pop_front();
-            lock.unlock();
-
-            auto t1 = clock.now();
-            int outputCount = SendMessages(i.id, i.socketInfo, i.msgs);
-            auto t2 = clock.now();
-
-            long diff = std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count();
-            if ((outputCount != i.msgs.size()) || (diff > 100)) {
-                i.socketInfo->errCount++;
-
-                // failed to send all messages or it took more than 100ms to send them
-                LogErr(VB_CHANNELOUT, "sendmmsg() failed for UDP output (key: %X   output count: %d/%d   time: %u ms    errCount: %d) with error: %d   %s\n",
-                       i.id,
-                       outputCount, i.msgs.size(), diff, i.socketInfo->errCount,
-                       errno,
-                       strerror(errno));
-            } else {
-                i.socketInfo->errCount = 0;
-            }
+    for (auto& i : items) {
+        auto t1 = clock.now();
+        int outputCount = SendMessages(i.id, i.socketInfo, &i.msgs[0], i.msgs.size());
+        auto t2 = clock.now();
+        RecordWorkItemSend(i, outputCount, std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count());
+    }
+}
 
-            doneWorkCount++;
+/*
+ * Simple timer wheel: the pacing window is split into 1ms slots and each
+ * destination gets an equal share of its packets in every slot, limited by
+ * pacingMaxPPS if set (see UDPPacer).  The rate cap wins over the window so
+ * a capped destination may take longer than the window to finish, but
+ * never longer than the frame.  Whatever doesn't fit is dropped and the
+ * next frame starts with those packets.
+ */
+void UDPOutput::SendPacedWorkItems(std::vector<WorkItem>& items) {
+    constexpr int SLOT_US = 1000;
+    float rate = GetChannelOutputRefreshRate();
+    if (rate <= 0) {
+        rate = 20;
+    }
+    int frameUS = (int)(1000000.0f / rate);
+    int windowUS = frameUS * pacingPercent / 100;
+    int slots = std::max(windowUS / SLOT_US, 1);
+    int maxSlots = std::max(frameUS / SLOT_US, slots);
+
+    std::vector<int> positions(items.size(), 0);
+    std::vector<int> sent(items.size(), 0);
+    std::vector<long long> sendTimes(items.size(), 0);
+    std::vector<UDPPacer> pacers;
+    pacers.reserve(items.size());
+    for (auto& i : items) {
+        pacers.emplace_back(i.msgs.size(), slots, pacingMaxPPS, SLOT_US);
+        if (i.socketInfo->pacingOffset >= i.msgs.size()) {
+            i.socketInfo->pacingOffset = 0;
         }
     }
 
-    --numWorkThreads;
+    std::chrono::high_resolution_clock clock;
+    auto start = clock.now();
+    bool remaining = true;
+    for (int slot = 0; remaining && slot < maxSlots; slot++) {
+        std::this_thread::sleep_until(start + std::chrono::microseconds(slot * SLOT_US));
+        remaining = false;
+        for (int x = 0; x < items.size(); x++) {
+            WorkItem& i = items[x];
+            int size = i.msgs.size();
+            int left = size - positions[x];
+            if (left <= 0) {
+                continue;
+            }
+            int count = std::min(pacers[x].next(), left);
+            while (count > 0) {
+                // wraps around to the start if a previous frame was cut short
+                int idx = (i.socketInfo->pacingOffset + positions[x]) % size;
+                int c = std::min(count, size - idx);
+                auto t1 = clock.now();
+                sent[x] += SendMessages(i.id, i.socketInfo, &i.msgs[idx], c);
+                auto t2 = clock.now();
+                sendTimes[x] += std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count();
+                positions[x] += c;
+                count -= c;
+            }
+            if (positions[x] < size) {
+                remaining = true;
+            }
+        }
+    }
+    int totalDropped = 0;
+    for (int x = 0; x < items.size(); x++) {
+        WorkItem& i = items[x];
+        int dropped = (int)i.msgs.size() - positions[x];
+        if (dropped) {
+            i.socketInfo->pacingDroppedCount += dropped;
+            i.socketInfo->pacingOffset = (i.socketInfo->pacingOffset + positions[x]) % i.msgs.size();
+            totalDropped += dropped;
+        } else {
+            i.socketInfo->pacingOffset = 0;
+        }
+        RecordWorkItemSend(i, sent[x], sendTimes[x], dropped);
+    }
+    if (totalDropped) {
+        long long now = GetTimeMS();
+        long long last = lastPacingWarning;
+        if ((now - last) > 10000 && lastPacingWarning.compare_exchange_strong(last, now)) {
+            LogWarn(VB_CHANNELOUT, "UDP output pacing: %d packets did not fit in the %dms frame at %d packets/sec and were dropped\n",
+                    totalDropped, frameUS / 1000, pacingMaxPPS);
+        }
+    }
+}
+
+void UDPOutput::BackgroundOutputWork(int shard) {
+    unsigned int generation = 0;
+    std::unique_lock<std::mutex> lock(workMutex);
+    while (runWorkThreads) {
+        workSignal.wait(lock, [this, &generation] { return !runWorkThreads || workGeneration != generation; });
+        if (!runWorkThreads) {
+            break;
+        }
+        generation = workGeneration;
+        std::vector<WorkItem>& items = workShards[shard];
+        if (items.empty()) {
+            continue;
+        }
+        lock.unlock();
+
+        SendWorkItems(items);
+
+        lock.lock();
+        if (--pendingWork == 0) {
+            doneSignal.notify_all();
+        }
+    }
 }
 
 int UDPOutput::SendData(unsigned char* channelData) {
@@ -540,44 +913,46 @@ int UDPOutput::SendData(unsigned char* channelData) {
         return 0;
     }
     std::chrono::high_resolution_clock clock;
-    if (useThreadedOutput) {
-        doneWorkCount = 0;
-        int total = 0;
-        auto t1 = clock.now();
+    if (useThreadedOutput && !workThreads.empty()) {
+        std::unique_lock<std::mutex> lock(workMutex);
+        doneSignal.wait(lock, [this] { return pendingWork == 0; });
+        for (auto& shard : workShards) {
+            shard.clear();
+        }
         for (auto& msgs : messages.messages) {
-            if (!msgs.second.empty() && msgs.first < LATE_MULTICAST_MESSAGES_KEY) {
+            if (!msgs.second.empty() && msgs.first < FIRST_LATE_MESSAGES_KEY) {
                 SendSocketInfo* socketInfo = findOrCreateSocket(msgs.first, 5);
-
-                std::unique_lock<std::mutex> lock(workMutex);
-                workQueue.push_back(WorkItem(msgs.first, socketInfo, msgs.second));
-                lock.unlock();
-                workSignal.notify_one();
-                ++total;
+                workShards[GetWorkShard(msgs.first)].push_back(WorkItem(msgs.first, socketInfo, msgs.second));
             }
         }
-        std::unique_lock<std::mutex> lock(workMutex);
-        while (numWorkThreads < workQueue.size()) {
-            std::thread(DoWorkThread, this).detach();
-            numWorkThreads++;
-        }
-        if (workQueue.size()) {
-            workSignal.notify_all();
+        pendingWork = 0;
+        for (auto& shard : workShards) {
+            if (!shard.empty()) {
+                ++pendingWork;
+            }
         }
+        ++workGeneration;
         lock.unlock();
-        auto t2 = clock.now();
-        while (doneWorkCount != total && std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count() < 50) {
-            std::this_thread::sleep_for(std::chrono::microseconds(250));
-            t2 = clock.now();
+        workSignal.notify_all();
+
+        int timeout = 50;
+        if (pacingPercent) {
+            // give the paced sends time to finish
+            timeout += 1000 / std::max((int)GetChannelOutputRefreshRate(), 1);
         }
-        if (doneWorkCount == total) {
+        lock.lock();
+        bool done = doneSignal.wait_for(lock, std::chrono::milliseconds(timeout), [this] { return pendingWork == 0; });
+        lock.unlock();
+        if (done) {
             // now output the LATE/Broadcast packets (likely sync packets)
             for (auto& msgs : messages.messages) {
                 if (!msgs.second.empty()) {
                     SendSocketInfo* socketInfo = findOrCreateSocket(msgs.first, 5);
-                    if (msgs.first >= LATE_MULTICAST_MESSAGES_KEY) {
-                        t1 = clock.now();
-                        int outputCount = SendMessages(msgs.first, socketInfo, msgs.second);
-                        t2 = clock.now();
+                    if (msgs.first >= FIRST_LATE_MESSAGES_KEY) {
+                        auto t1 = clock.now();
+                        int outputCount = SendMessages(msgs.first, socketInfo, &msgs.second[0], msgs.second.size());
+                        auto t2 = clock.now();
+                        socketInfo->RecordSend(msgs.second.size(), outputCount, std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count());
                         long diff = std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count();
                         if ((outputCount != msgs.second.size()) || (diff > 100)) {
                             socketInfo->errCount++;
@@ -602,29 +977,38 @@ int UDPOutput::SendData(unsigned char* channelData) {
         }
         return 1;
     }
+    std::vector<WorkItem> items;
+    for (auto& msgs : messages.messages) {
+        if (!msgs.second.empty() && msgs.first < FIRST_LATE_MESSAGES_KEY) {
+            items.push_back(WorkItem(msgs.first, findOrCreateSocket(msgs.first, 5), msgs.second));
+        }
+    }
+    SendWorkItems(items);
     for (auto& msgs : messages.messages) {
         if (!msgs.second.empty()) {
             SendSocketInfo* socketInfo = findOrCreateSocket(msgs.first, 5);
-            auto t1 = clock.now();
-            int outputCount = SendMessages(msgs.first, socketInfo, msgs.second);
-            auto t2 = clock.now();
-            long diff = std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count();
-            if ((outputCount != msgs.second.size()) || (diff > 100)) {
-                socketInfo->errCount++;
-
-                // failed to send all messages or it took more than 100ms to send them
-                LogErr(VB_CHANNELOUT, "sendmmsg() failed for UDP output (key: %X   output count: %d/%d   time: %u ms    errCount: %d) with error: %d   %s\n",
-                       msgs.first,
-                       outputCount, msgs.second.size(), diff, socketInfo->errCount,
-                       errno,
-                       strerror(errno));
-
-                if (socketInfo->errCount >= 3) {
-                    // we'll ping the controllers and rebuild the valid message list, this could take time
-                    PingControllers(false);
+            if (msgs.first >= FIRST_LATE_MESSAGES_KEY) {
+                auto t1 = clock.now();
+                int outputCount = SendMessages(msgs.first, socketInfo, &msgs.second[0], msgs.second.size());
+                auto t2 = clock.now();
+                socketInfo->RecordSend(msgs.second.size(), outputCount, std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count());
+                long diff = std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count();
+                if ((outputCount != msgs.second.size()) || (diff > 100)) {
+                    socketInfo->errCount++;
+
+                    // failed to send all messages or it took more than 100ms to send them
+                    LogErr(VB_CHANNELOUT, "sendmmsg() failed for UDP output (key: %X   output count: %d/%d   time: %u ms    errCount: %d) with error: %d   %s\n",
+                           msgs.first,
+                           outputCount, msgs.second.size(), diff, socketInfo->errCount,
+                           errno,
+                           strerror(errno));
+                } else {
                     socketInfo->errCount = 0;
                 }
-            } else {
+            }
+            if (socketInfo->errCount >= 3) {
+                // we'll ping the controllers and rebuild the valid message list, this could take time
+                PingControllers(false);
                 socketInfo->errCount = 0;
             }
         }
@@ -694,6 +1078,8 @@ void UDPOutput::PingControllers(bool failedOnly) {
 }
 void UDPOutput::DumpConfig() {
     ChannelOutput::DumpConfig();
+    LogDebug(VB_CHANNELOUT, "    Threaded: %d   Threads: %d\n", useThreadedOutput, numWorkThreads);
+    LogDebug(VB_CHANNELOUT, "    GSO: %d   Pacing: %d%%   Max PPS: %d\n", (int)useGSO, pacingPercent, pacingMaxPPS);
     for (auto u : outputs) {
         u->DumpConfig();
     }
@@ -701,6 +1087,7 @@ void UDPOutput::DumpConfig() {
 
 void UDPOutput::CloseNetwork() {
     std::unique_lock<std::mutex> lk(socketMutex);
+    WaitForWorkThreads();
     messages.clearSockets();
     lk.unlock();
     PingControllers(false);
@@ -793,6 +1180,51 @@ bool UDPOutput::InitNetwork() {
     return true;
 }
 
+void UDPOutput::GetStats(Json::Value& stats) {
+    std::unique_lock<std::mutex> lk(socketMutex);
+    stats["threaded"] = useThreadedOutput;
+    stats["threadCount"] = numWorkThreads;
+    stats["pacing"] = pacingPercent;
+    Json::Value dests = Json::arrayValue;
+    for (auto& si : messages.sendSockets) {
+        SendSocketInfo* info = si.second;
+        if (info == nullptr || info->sendCount == 0) {
+            continue;
+        }
+        Json::Value d;
+        d["key"] = si.first;
+        if (si.first == MULTICAST_MESSAGES_KEY) {
+            d["destination"] = "multicast";
+        } else if (si.first == LATE_ARTNET_MESSAGES_KEY) {
+            d["destination"] = "ArtNet sync";
+        } else if (si.first == LATE_MULTICAST_MESSAGES_KEY) {
+            d["destination"] = "late multicast";
+        } else if (si.first == BROADCAST_MESSAGES_KEY) {
+            d["destination"] = "broadcast";
+        } else {
+            struct in_addr addr;
+            addr.s_addr = si.first;
+            d["destination"] = inet_ntoa(addr);
+        }
+        auto wsk = workShardKeys.find(si.first);
+        if (wsk != workShardKeys.end()) {
+            d["thread"] = wsk->second;
+        }
+        unsigned long long cnt = info->sendCount;
+        d["sends"] = (Json::UInt64)cnt;
+        d["packets"] = (Json::UInt64)info->packetCount.load();
+        d["failedSends"] = (Json::UInt64)info->failedSendCount.load();
+        if (info->pacingDroppedCount) {
+            d["pacingDropped"] = (Json::UInt64)info->pacingDroppedCount.load();
+        }
+        d["lastSendTimeUS"] = (Json::Int64)info->lastSendTime.load();
+        d["maxSendTimeUS"] = (Json::Int64)info->maxSendTime.load();
+        d["avgSendTimeUS"] = (Json::Int64)(info->totalSendTime / cnt);
+        dests.append(d);
+    }
+    stats["destinations"] = dests;
+}
+
 void UDPOutput::StartingOutput() {
     for (auto a : outputs) {
         if (a->valid && a->active) {
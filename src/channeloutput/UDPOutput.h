@@ -29,9 +29,14 @@ typedef void CURLM;
 
 #define MULTICAST_MESSAGES_KEY 0x00000001
 #define ANY_MESSAGES_KEY 0x00000002
+#define LATE_ARTNET_MESSAGES_KEY 0xFFFFFFFD
 #define LATE_MULTICAST_MESSAGES_KEY 0xFFFFFFFE
 #define BROADCAST_MESSAGES_KEY 0xFFFFFFFF
 
+// Messages with keys at or above this are sent after all the data for
+// the frame has been handed to the kernel (sync packets, etc...)
+#define FIRST_LATE_MESSAGES_KEY LATE_ARTNET_MESSAGES_KEY
+
 class SendSocketInfo;
 
 class UDPOutputMessages {
@@ -49,6 +54,15 @@ private:
     std::map<unsigned int, std::vector<struct mmsghdr>> messages;
     std::map<unsigned int, SendSocketInfo*> sendSockets;
 
+    // backing storage for messages that have been merged into a single
+    // UDP_SEGMENT (GSO) send
+    class GSOBuffers {
+    public:
+        std::vector<struct iovec> iovecs;
+        std::vector<unsigned char> control;
+    };
+    std::map<unsigned int, GSOBuffers> gsoBuffers;
+
     void clearMessages();
     void clearSockets();
 
@@ -94,10 +108,15 @@ public:
     void operator=(UDPOutputData const& x) = delete;
 
 protected:
-    void SaveFrame(unsigned char* channelData, int len);
+    // Returns true if the count channels at savedIdx have changed since they
+    // were last sent (or are due for a keepalive) and records them as sent.
+    // Must be called in channel order starting with savedIdx 0 each frame.
     bool NeedToOutputFrame(unsigned char* channelData, int startChannel, int savedIdx, int count);
     bool deDuplicate = false;
-    int skippedFrames;
+    int keepAliveInterval;
+    long long lastKeepAlive;
+    bool keepAliveFrame;
+    int lastDataSize;
     unsigned char* lastData;
 };
 
@@ -106,6 +125,10 @@ public:
     UDPOutput(unsigned int startChannel, unsigned int channelCount);
     virtual ~UDPOutput();
 
+    virtual std::string GetOutputType() const override {
+        return "UDP";
+    }
+
     virtual int Init(Json::Value config) override;
     virtual int Close(void) override;
 
@@ -122,13 +145,15 @@ public:
 
     static UDPOutput* INSTANCE;
 
-    void BackgroundOutputWork();
+    void BackgroundOutputWork(int shard);
 
     virtual void StartingOutput() override;
     virtual void StoppingOutput() override;
 
+    virtual void GetStats(Json::Value& stats) override;
+
 private:
-    int SendMessages(unsigned int key, SendSocketInfo* socketInfo, std::vector<struct mmsghdr>& sendmsgs);
+    int SendMessages(unsigned int key, SendSocketInfo* socketInfo, struct mmsghdr* msgs, int msgCount);
     struct sockaddr_in localAddress;
     std::string outInterface;
     bool interfaceUp;
@@ -137,6 +162,9 @@ private:
     SendSocketInfo* findOrCreateSocket(unsigned int key, int sc = 1);
     void CloseNetwork();
 
+    void CoalesceGSOMessages(unsigned int key, std::vector<struct mmsghdr>& msgs);
+    std::atomic_bool useGSO;
+
     std::mutex socketMutex;
     UDPOutputMessages messages;
     bool enabled;
@@ -159,11 +187,33 @@ private:
         std::vector<struct mmsghdr>& msgs;
     };
 
+    void StartWorkThreads();
+    void StopWorkThreads();
+    void WaitForWorkThreads();
+    int GetWorkShard(unsigned int key);
+
+    // Each work thread owns a shard of the destination keys (and their
+    // sockets).  SendData fills the shards, bumps workGeneration to wake
+    // the threads and then waits on doneSignal until pendingWork drops to 0
+    void SendWorkItems(std::vector<WorkItem>& items);
+    void SendPacedWorkItems(std::vector<WorkItem>& items);
+    void RecordWorkItemSend(WorkItem& item, int outputCount, long long sendTimeUS, int dropped = 0);
+
+    // Pacing spreads each destination's packets across pacingPercent of
+    // the frame interval instead of sending them in one burst
+    int pacingPercent;
+    int pacingMaxPPS;
+    std::atomic<long long> lastPacingWarning = 0;
+
     std::mutex workMutex;
     std::condition_variable workSignal;
-    std::list<WorkItem> workQueue;
-    std::atomic_int doneWorkCount;
-    std::atomic_int numWorkThreads;
-    volatile bool runWorkThreads;
+    std::condition_variable doneSignal;
+    std::vector<std::vector<WorkItem>> workShards;
+    std::vector<std::thread> workThreads;
+    std::map<unsigned int, int> workShardKeys;
+    unsigned int workGeneration;
+    int pendingWork;
+    int numWorkThreads;
+    bool runWorkThreads;
     bool useThreadedOutput;
 };
@@ -0,0 +1,50 @@
+#pragma once
+/*
+ * This file is part of the Falcon Player (FPP) and is Copyright (C)
+ * 2013-2022 by the Falcon Player Developers.
+ *
+ * The Falcon Player (FPP) is free software, and is covered under
+ * multiple Open Source licenses.  Please see the included 'LICENSES'
+ * file for descriptions of what files are covered by each license.
+ *
+ * This source file is covered under the LGPL v2.1 as described in the
+ * included LICENSE.LGPL file.
+ */
+
+#include <algorithm>
+#include <cstdint>
+
+// Decides how many of a destination's packets go out in each slot of the
+// UDP output pacing window.  Packets are spread evenly over the slots and,
+// if maxPPS is set, limited by a credit in packets * 1000000 that every
+// slot tops up by maxPPS * slotUS.  Carrying the fraction keeps rates that
+// are not a multiple of the slot rate (1000pps for 1ms slots) accurate.
+class UDPPacer {
+public:
+    UDPPacer(int packets, int slots, int maxPPS, int slotUS) :
+        perSlot((packets + slots - 1) / std::max(slots, 1)),
+        creditPerSlot((int64_t)maxPPS * slotUS) {
+        // the first slot gets its share, and at least one packet, right away
+        credit = maxPPS ? std::max(creditPerSlot, PACKET_CREDIT) : 0;
+    }
+
+    // number of packets that can be sent in the next slot
+    int next() {
+        if (!creditPerSlot) {
+            return perSlot;
+        }
+        int count = std::min((int64_t)perSlot, credit / PACKET_CREDIT);
+        credit -= count * PACKET_CREDIT;
+        // unused credit doesn't carry over past a packet so a slow start
+        // doesn't turn into a burst later on
+        credit = std::min(credit + creditPerSlot, creditPerSlot + PACKET_CREDIT);
+        return count;
+    }
+
+private:
+    static constexpr int64_t PACKET_CREDIT = 1000000;
+
+    int perSlot;
+    int64_t creditPerSlot;
+    int64_t credit;
+};
@@ -11,6 +11,10 @@
  * included LICENSE.GPL file.
  */
 
+#include <atomic>
+#include <cstring>
+#include <string>
+
 #define E131_TYPE_MULTICAST 0
 #define E131_TYPE_UNICAST 1
 #define ARTNET_TYPE_BROADCAST 2
@@ -19,15 +23,36 @@
 
 class UniverseEntry {
 public:
+    UniverseEntry() {}
+    UniverseEntry(const UniverseEntry& u) { *this = u; }
+    UniverseEntry& operator=(const UniverseEntry& u) {
+        active = u.active;
+        universe = u.universe;
+        size = u.size;
+        startAddress = u.startAddress;
+        type = u.type;
+        memcpy(unicastAddress, u.unicastAddress, sizeof(unicastAddress));
+        bytesReceived = u.bytesReceived.load();
+        packetsReceived = u.packetsReceived.load();
+        errorPackets = u.errorPackets.load();
+        lastSequenceNumber = u.lastSequenceNumber;
+        priority = u.priority;
+        dmxDevice = u.dmxDevice;
+        lastTimestamp = u.lastTimestamp;
+        lastIndex = u.lastIndex;
+        return *this;
+    }
+
     uint32_t active = 0;
     uint32_t universe = -1;
     uint32_t size = 512;
     uint32_t startAddress = 0;
     uint32_t type = 0;
     char unicastAddress[16];
-    uint32_t bytesReceived = 0;
-    uint32_t packetsReceived = 0;
-    uint32_t errorPackets = 0;
+    // updated from the bridge ingest threads
+    std::atomic<uint32_t> bytesReceived = 0;
+    std::atomic<uint32_t> packetsReceived = 0;
+    std::atomic<uint32_t> errorPackets = 0;
     uint32_t lastSequenceNumber = 0;
     uint32_t priority = 0;
 
@@ -22,6 +22,7 @@
 #include <pthread.h>
 #include <thread>
 
+#include "../MasterClock.h"
 #include "../MultiSync.h"
 #include "../Sequence.h"
 #include "../channeltester/ChannelTester.h"
@@ -46,6 +47,9 @@ int MasterFramesPlayed = -1;
 volatile int OutputFrames = 1;
 float mediaOffset = 0.0;
 
+// longest time (ms) to wait for a bridge sync commit before refreshing
+#define BRIDGE_SYNC_MAX_WAIT 250
+
 /* local variables */
 pthread_t ChannelOutputThreadID;
 volatile int RunThread = 0;
@@ -59,6 +63,10 @@ std::mutex outputThreadStatusLock;
 std::condition_variable outputThreadCond;
 std::condition_variable outputThreadSatusCond;
 
+// master frame clock follower
+std::mutex masterClockLock;
+MasterClockPLL masterClock;
+
 /* prototypes for functions below */
 void CalculateNewChannelOutputDelayForFrame(int expectedFramesSent);
 
@@ -108,6 +116,19 @@ static inline bool forceOutput() {
 /*
  * Main loop in channel output thread
  */
+// Only bridge data in sync commit mode is being output
+static inline bool bridgeSyncDriven() {
+    return sequence->IsBridgeSyncCommit() &&
+           sequence->hasBridgeData() &&
+           !sequence->IsSequenceRunning() &&
+           !IsEffectRunning() &&
+           !PixelOverlayManager::INSTANCE.hasActiveOverlays() &&
+           !SDLOutput::IsOverlayingVideo() &&
+           !ChannelTester::INSTANCE.Testing() &&
+           !alwaysTransmit &&
+           !outputForced;
+}
+
 void* RunChannelOutputThread(void* data) {
     SetThreadName("FPP-ChannelOut");
 
@@ -261,6 +282,20 @@ void* RunChannelOutputThread(void* data) {
         doForceOutput = false;
         // Calculate how long we need to nanosleep()
         long dt = (LightDelay - (GetTime() - startTime)) * 1000;
+        long long masterFrameTime = (getFPPmode() == REMOTE_MODE && sequence->IsSequenceRunning()) ? GetMasterFrameTime(channelOutputFrame) : 0;
+        if (masterFrameTime) {
+            // output the next frame when the master does
+            dt = std::clamp(masterFrameTime - GetTime(), 0LL, 2LL * SequenceLightDelay) * 1000;
+        } else if (bridgeSyncDriven()) {
+            // output is driven by the bridge data commits which will
+            // wake us, just make sure we still refresh occasionally
+            if (sequence->isDataProcessed()) {
+                dt = std::max(dt, (long)BRIDGE_SYNC_MAX_WAIT * 1000000);
+            } else {
+                // committed while we were busy
+                dt = 0;
+            }
+        }
         if (RunThread && dt > 0) {
             if (outputThreadCond.wait_for(lock, std::chrono::nanoseconds(dt)) == std::cv_status::no_timeout) {
                 LogDebug(VB_CHANNELOUT, "Forced output\n");
@@ -395,6 +430,9 @@ void StopForcingChannelOutput(void) {
  */
 void ResetMasterPosition(void) {
     MasterFramesPlayed = -1;
+
+    std::unique_lock<std::mutex> lock(masterClockLock);
+    masterClock.reset();
 }
 
 /*
@@ -405,6 +443,35 @@ void UpdateMasterPosition(int frameNumber) {
     CalculateNewChannelOutputDelayForFrame(frameNumber);
 }
 
+/*
+ * Follow the master's frame clock, sampleTime is the local time the
+ * master was at masterSeconds.  See MasterClockPLL.
+ */
+void UpdateMasterTimeline(long long sampleTime, float masterSeconds) {
+    long long position = (long long)(masterSeconds * 1000000.0f);
+
+    std::unique_lock<std::mutex> lock(masterClockLock);
+    long long err = 0;
+    if (!masterClock.update(sampleTime, position, err)) {
+        if (err) {
+            LogDebug(VB_SYNC, "Master position jumped by %lldus, resetting timeline\n", err);
+        }
+        return;
+    }
+    LogExcess(VB_SYNC, "Master timeline error: %lldus   rate: %.6f\n", err, masterClock.getRate());
+}
+
+/*
+ * Local time the master outputs the given frame, 0 if not known yet
+ */
+long long GetMasterFrameTime(int frame) {
+    std::unique_lock<std::mutex> lock(masterClockLock);
+    if (!masterClock.isValid()) {
+        return 0;
+    }
+    return masterClock.getLocalTime((long long)frame * SequenceLightDelay);
+}
+
 /*
  * Calculate the new sync offset based on the current position reported
  * by the media player.
@@ -463,6 +530,11 @@ void CalculateNewChannelOutputDelayForFrame(int expectedFramesSent) {
         }
     }
     int DefaultLightDelay = sequence->IsSequenceRunning() ? SequenceLightDelay : BridgeLightDelay;
+    if (sequence->IsSequenceRunning() && GetMasterFrameTime(0)) {
+        // frames are scheduled on the master's timeline, no need to adjust
+        LightDelay = DefaultLightDelay;
+        return;
+    }
     if (diff > 1 || diff < -1) {
         int timerOffset = diff * (DefaultLightDelay / 100);
         int newLightDelay = LightDelay;
@@ -27,5 +27,7 @@ void StartForcingChannelOutput(void);
 void StopForcingChannelOutput(void);
 void ResetMasterPosition(void);
 void UpdateMasterPosition(int frameNumber);
+void UpdateMasterTimeline(long long sampleTime, float masterSeconds);
+long long GetMasterFrameTime(int frame);
 void CalculateNewChannelOutputDelay(float mediaPosition);
 void CalculateNewChannelOutputDelayForFrame(int expectedFramesSent);
@@ -42,6 +42,16 @@ void OutputProcessors::ProcessData(unsigned char* channelData) const {
     }
 }
 
+bool OutputProcessors::hasActiveProcessors() const {
+    std::lock_guard<std::mutex> lock(processorsLock);
+    for (OutputProcessor* a : processors) {
+        if (a->isActive()) {
+            return true;
+        }
+    }
+    return false;
+}
+
 void OutputProcessors::addProcessor(OutputProcessor* p) {
     if (p == nullptr) {
         return;
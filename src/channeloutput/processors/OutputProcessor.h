@@ -54,6 +54,7 @@ public:
     ~OutputProcessors();
 
     void ProcessData(unsigned char* channelData) const;
+    bool hasActiveProcessors() const;
 
     void addProcessor(OutputProcessor* p);
     void removeProcessor(OutputProcessor* p);
@@ -18,9 +18,12 @@
 
 #include <arpa/inet.h>
 #include <netinet/in.h>
+#include <poll.h>
+#include <pthread.h>
 #include <sys/socket.h>
 #include <sys/uio.h>
 #include <algorithm>
+#include <atomic>
 #include <cstdlib>
 #include <errno.h>
 #include <fstream>
@@ -28,13 +31,16 @@
 #include <inttypes.h>
 #include <map>
 #include <memory>
+#include <shared_mutex>
 #include <stdio.h>
 #include <string.h>
 #include <string>
+#include <thread>
 #include <unistd.h>
 #include <utility>
 #include <vector>
 
+#include "BridgeRecorder.h"
 #include "Sequence.h"
 #include "Warnings.h"
 #include "common.h"
@@ -60,7 +66,7 @@ int bridgeSock = -1;
 int ddpSock = -1;
 int artnetSock = -1;
 
-long long last_packet_time = GetTimeMS();
+std::atomic<long long> last_packet_time(GetTimeMS());
 long long expireOffSet = 1000; // expire after 1 second
 
 #define MAX_MSG 64
@@ -75,33 +81,79 @@ unsigned int UniverseCache[65536];
 std::vector<UniverseEntry> InputUniverses;
 int InputUniverseCount;
 
-static uint64_t ddpBytesReceived = 0;
-static uint32_t ddpPacketsReceived = 0;
-static uint32_t ddpErrors = 0;
+// The stats are updated from the ingest threads as well as the main loop
+static std::atomic<uint64_t> ddpBytesReceived = 0;
+static std::atomic<uint32_t> ddpPacketsReceived = 0;
+static std::atomic<uint32_t> ddpErrors = 0;
 
-static uint32_t ddpLastSequence = 0;
-static uint32_t ddpLastChannel = 0;
-static uint32_t ddpMinChannel = 0xFFFFFFF;
-static uint32_t ddpMaxChannel = 0;
+static std::atomic<uint32_t> ddpLastSequence = 0;
+static std::atomic<uint32_t> ddpLastChannel = 0;
+static std::atomic<uint32_t> ddpMinChannel = 0xFFFFFFF;
+static std::atomic<uint32_t> ddpMaxChannel = 0;
 
-static uint32_t e131Errors = 0;
-static uint32_t e131SyncPackets = 0;
+static std::atomic<uint32_t> e131Errors = 0;
+static std::atomic<uint32_t> e131SyncPackets = 0;
 static UniverseEntry unknownUniverse;
 
-static bool bridgeDataReceived = false;
-
+static std::atomic_bool bridgeDataReceived(false);
+
+// When BridgeDDPDirectReceive is set, the DDP header is peeked first and the
+// channel data is then received straight into the bridge (or sequence)
+// buffer instead of into a packet buffer and copied
+static bool ddpDirectReceive = false;
+
+// When BridgeIngestThreads is set, each protocol gets that many sockets
+// bound with SO_REUSEPORT, each read by its own thread instead of
+// by the main fppd loop.  The kernel picks the socket by hashing the
+// source/destination address and port so all the packets from a single
+// unicast sender land on the same thread, the threads only help when
+// there are multiple senders (or multicast from multiple sources).
+class BridgeIngestThread {
+public:
+    BridgeIngestThread(int s, bool own, const std::string& n, std::function<bool(uint8_t*, long long)> h) :
+        sock(s),
+        ownsSocket(own),
+        name(n),
+        handler(h) {}
+
+    int sock;
+    bool ownsSocket;
+    std::string name;
+    std::function<bool(uint8_t*, long long)> handler;
+    bool directDDP = false;
+    std::thread thread;
+
+    struct mmsghdr msgs[MAX_MSG];
+    struct iovec iovecs[MAX_MSG];
+    uint8_t buffers[MAX_MSG][BUFSIZE + 1];
+    struct sockaddr_in inAddress[MAX_MSG];
+};
+static std::vector<BridgeIngestThread*> ingestThreads;
+static std::atomic_bool runIngestThreads(false);
+static int ingestThreadCount = 0;
+
+// set on the ingest threads so SetBridgeData batches the ranges
+static thread_local std::vector<std::pair<uint32_t, uint32_t>>* ingestRanges = nullptr;
+static thread_local int ingestShard = 0;
+
+// looked up from the ingest threads, handlers are called with the read
+// lock held so they must not add or remove handlers themselves
 static std::map<int, std::function<bool(uint8_t* data, long long packetTime)>> ArtNetOpcodeHandlers;
+static std::shared_mutex ArtNetOpcodeHandlersLock;
 
 void AddArtNetOpcodeHandler(int opCode, std::function<bool(uint8_t* data, long long packetTime)> handler) {
+    std::unique_lock<std::shared_mutex> lock(ArtNetOpcodeHandlersLock);
     ArtNetOpcodeHandlers[opCode] = handler;
 }
 void RemoveArtNetOpcodeHandler(int opCode) {
+    std::unique_lock<std::shared_mutex> lock(ArtNetOpcodeHandlersLock);
     ArtNetOpcodeHandlers.erase(opCode);
 }
 
 // prototypes for functions below
 bool Bridge_StoreData(uint8_t* bridgeBuffer, long long packetTime);
 bool Bridge_StoreDDPData(uint8_t* bridgeBuffer, long long packetTime);
+static void Bridge_ReadDDPHeader(const uint8_t* bridgeBuffer, uint32_t& chan, uint32_t& len);
 
 int Bridge_GetIndexFromUniverseNumber(int universe);
 void InputUniversesPrint();
@@ -125,6 +177,11 @@ int CreateArtNetSocket() {
 #endif
         int bufSize = 512 * 1024;
         setsockopt(artnetSock, SOL_SOCKET, SO_RCVBUF, &bufSize, sizeof(bufSize));
+        if (getSettingInt("BridgeIngestThreads") > 1) {
+            // the ArtNet ingest threads will bind more sockets to the port
+            enable = 1;
+            setsockopt(artnetSock, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(enable));
+        }
 
         memset((char*)&addr, 0, sizeof(addr));
         addr.sin_family = AF_INET;
@@ -227,11 +284,20 @@ bool LoadInputUniversesFromFile(void) {
     return enabled;
 }
 
+inline void MarkBridgeData(int startChannel, int len, long long packetTime) {
+    if (ingestRanges) {
+        ingestRanges->emplace_back(startChannel, len);
+        return;
+    }
+    sequence->UpdateBridgeRange(startChannel, len, packetTime + expireOffSet);
+}
+
 inline void SetBridgeData(uint8_t* data, int startChannel, int len, long long packetTime) {
     last_packet_time = packetTime;
-    packetTime += expireOffSet;
     bridgeDataReceived = true;
-    sequence->SetBridgeData(data, startChannel, len, packetTime);
+    if (sequence->CopyBridgeData(data, startChannel, len)) {
+        MarkBridgeData(startChannel, len, packetTime);
+    }
 }
 
 double GetSecondsFromInputPacket() {
@@ -257,8 +323,78 @@ bool Bridge_ReceiveE131Data(void) {
     }
     return sync;
 }
+/*
+ * Receive a single DDP packet, scattering the channel data directly to
+ * its location.  Returns false when there is nothing left to read.
+ */
+static bool Bridge_ReceiveDDPPacketDirect(int sock, uint8_t* buffer, long long packetTime, bool& push) {
+    uint8_t header[14];
+    ssize_t hlen = recv(sock, header, sizeof(header), MSG_PEEK | MSG_DONTWAIT);
+    if (hlen < 0) {
+        return false;
+    }
+    if (hlen < 10 || header[3] != 1 || ((header[0] & DDP_TIMECODE_FLAG) && hlen < 14)) {
+        // not channel data, use the normal handler
+        ssize_t r = recv(sock, buffer, BUFSIZE, MSG_DONTWAIT);
+        if (r >= 10) {
+            push |= Bridge_StoreDDPData(buffer, packetTime);
+        }
+        return r >= 0;
+    }
+    int offset = (header[0] & DDP_TIMECODE_FLAG) ? 14 : 10;
+    uint32_t chan = 0;
+    uint32_t len = 0;
+    Bridge_ReadDDPHeader(header, chan, len);
+    ddpBytesReceived += len;
+    if (chan >= FPPD_MAX_CHANNELS) {
+        len = 0;
+    } else if (len > (FPPD_MAX_CHANNELS - chan)) {
+        len = FPPD_MAX_CHANNELS - chan;
+    }
+
+    last_packet_time = packetTime;
+    bridgeDataReceived = true;
+    uint8_t* dest = len ? sequence->GetBridgeDataTarget(chan, len) : nullptr;
+
+    // if the data isn't wanted, it's discarded by the truncated read
+    struct iovec iov[2];
+    iov[0].iov_base = header;
+    iov[0].iov_len = offset;
+    iov[1].iov_base = dest;
+    iov[1].iov_len = len;
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = dest ? 2 : 1;
+    ssize_t r = recvmsg(sock, &msg, MSG_DONTWAIT);
+    if (dest) {
+        // must always be called, the sequence waits on outstanding targets
+        sequence->FinishBridgeData(chan, len);
+        // the packet may hold less data than the header claims
+        uint32_t got = r > offset ? std::min((uint32_t)(r - offset), len) : 0;
+        if (got) {
+            MarkBridgeData(chan, got, packetTime);
+        }
+    }
+    if (r < 0) {
+        return false;
+    }
+    if (header[0] & DDP_PUSH_FLAG) {
+        sequence->CommitBridgeData();
+        push = true;
+    }
+    return true;
+}
+
 bool Bridge_ReceiveDDPData(void) {
     //    LogExcess(VB_E131BRIDGE, "Bridge_ReceiveData()\n");
+    if (ddpDirectReceive) {
+        bool push = false;
+        long long packetTime = GetTimeMS();
+        while (Bridge_ReceiveDDPPacketDirect(ddpSock, buffers[0], packetTime, push)) {
+        }
+        return push;
+    }
     int msgcnt = recvmmsg(ddpSock, msgs, MAX_MSG, MSG_DONTWAIT, nullptr);
     bool sync = false;
     long long packetTime = GetTimeMS();
@@ -270,40 +406,243 @@ bool Bridge_ReceiveDDPData(void) {
     }
     return sync;
 }
+static bool Bridge_HandleArtNetPacket(uint8_t* bridgeBuffer, long long packetTime) {
+    if (bridgeBuffer[0] != 'A' || bridgeBuffer[1] != 'r' || bridgeBuffer[2] != 't' || bridgeBuffer[3] != '-' || bridgeBuffer[4] != 'N' || bridgeBuffer[5] != 'e' || bridgeBuffer[6] != 't' || bridgeBuffer[7] != 0 || bridgeBuffer[11] != 0xE) { // version must be 14
+        return false;
+    }
+    int opCode = (bridgeBuffer[9] << 8) | bridgeBuffer[8];
+    if (opCode == 0x2000 && ingestShard > 0) {
+        // broadcasts are delivered to every ingest socket, only reply once
+        return false;
+    }
+    std::shared_lock<std::shared_mutex> lock(ArtNetOpcodeHandlersLock);
+    auto cb = ArtNetOpcodeHandlers.find(opCode);
+    if (cb != ArtNetOpcodeHandlers.end()) {
+        return cb->second(bridgeBuffer, packetTime);
+    }
+    return false;
+}
 bool Bridge_ReceiveArtNetData(void) {
     int msgcnt = recvmmsg(artnetSock, msgs, MAX_MSG, MSG_DONTWAIT, nullptr);
     bool sync = false;
     long long packetTime = GetTimeMS();
     while (msgcnt > 0) {
         for (int x = 0; x < msgcnt; x++) {
-            uint8_t* bridgeBuffer = (uint8_t*)buffers[x];
-            if (bridgeBuffer[0] != 'A' || bridgeBuffer[1] != 'r' || bridgeBuffer[2] != 't' || bridgeBuffer[3] != '-' || bridgeBuffer[4] != 'N' || bridgeBuffer[5] != 'e' || bridgeBuffer[6] != 't' || bridgeBuffer[7] != 0 || bridgeBuffer[11] != 0xE) { // version must be 14
+            sync |= Bridge_HandleArtNetPacket((uint8_t*)buffers[x], packetTime);
+        }
+        msgcnt = recvmmsg(artnetSock, msgs, MAX_MSG, MSG_DONTWAIT, nullptr);
+    }
+    return sync;
+}
+
+static void InitReceiveBuffers(struct mmsghdr* m, struct iovec* iov, uint8_t (*bufs)[BUFSIZE + 1], struct sockaddr_in* in) {
+    memset(m, 0, sizeof(struct mmsghdr) * MAX_MSG);
+    for (int i = 0; i < MAX_MSG; i++) {
+        iov[i].iov_base = bufs[i];
+        iov[i].iov_len = BUFSIZE;
+        m[i].msg_hdr.msg_iov = &iov[i];
+        m[i].msg_hdr.msg_iovlen = 1;
+        m[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+        m[i].msg_hdr.msg_name = &in[i];
+    }
+}
+
+static void JoinMulticastGroups(int sock, int shard, int shardCount) {
+    int UniverseOctet[2];
+    struct ip_mreq mreq;
+    char strMulticastGroup[16];
+
+#ifdef IP_MULTICAST_ALL
+    if (shardCount > 1) {
+        // only receive the groups joined on this socket, not every
+        // group joined on the system, so each universe is only
+        // delivered to one of the ingest sockets
+        int all = 0;
+        setsockopt(sock, IPPROTO_IP, IP_MULTICAST_ALL, &all, sizeof(all));
+    }
+#endif
+
+    // get all the addresses
+    struct ifaddrs *interfaces, *tmp;
+    getifaddrs(&interfaces);
+
+    char address[16];
+    address[0] = 0;
+    int multicastIdx = 0;
+    // Join the multicast groups
+    for (int i = 0; i < InputUniverseCount; i++) {
+        if (InputUniverses[i].type == E131_TYPE_MULTICAST) {
+            if ((multicastIdx++ % shardCount) != shard) {
                 continue;
             }
-            int opCode = (bridgeBuffer[9] << 8) | bridgeBuffer[8];
-            auto cb = ArtNetOpcodeHandlers.find(opCode);
-            if (cb != ArtNetOpcodeHandlers.end()) {
-                sync |= cb->second(bridgeBuffer, packetTime);
+            UniverseOctet[0] = InputUniverses[i].universe / 256;
+            UniverseOctet[1] = InputUniverses[i].universe % 256;
+            snprintf(strMulticastGroup, sizeof(strMulticastGroup), "239.255.%d.%d", UniverseOctet[0], UniverseOctet[1]);
+            mreq.imr_multiaddr.s_addr = inet_addr(strMulticastGroup);
+
+            LogInfo(VB_E131BRIDGE, "Adding group %s\n", strMulticastGroup);
+
+            // add group to groups to listen for on eth0 and wlan0 if it exists
+            int multicastJoined = 0;
+            tmp = interfaces;
+            // loop through all the interfaces and subscribe to the group
+            while (tmp) {
+                // struct sockaddr_in *sin = (struct sockaddr_in *)tmp->ifa_addr;
+                // strcpy(address, inet_ntoa(sin->sin_addr));
+                if (tmp->ifa_addr && tmp->ifa_addr->sa_family == AF_INET) {
+                    GetInterfaceAddress(tmp->ifa_name, address, NULL, NULL);
+                    if (strcmp(address, "127.0.0.1")) {
+                        LogDebug(VB_E131BRIDGE, "   Adding interface %s - %s\n", tmp->ifa_name, address);
+                        mreq.imr_interface.s_addr = inet_addr(address);
+                        if (setsockopt(sock, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0) {
+                            LogWarn(VB_E131BRIDGE, "   Could not setup Multicast Group for interface %s\n", tmp->ifa_name);
+                        }
+                        multicastJoined = 1;
+                    }
+                } else if (tmp->ifa_addr && tmp->ifa_addr->sa_family == AF_INET6) {
+                    // FIXME for ipv6 multicast
+                    // LogDebug(VB_E131BRIDGE, "   Inet6 interface %s\n", tmp->ifa_name);
+                }
+                tmp = tmp->ifa_next;
+            }
+
+            if (!multicastJoined) {
+                LogDebug(VB_E131BRIDGE, "  Binding to default interface\n");
+                mreq.imr_interface.s_addr = htonl(INADDR_ANY);
+                if (setsockopt(sock, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0) {
+                    LogWarn(VB_E131BRIDGE, "   Could not setup Multicast Group\n");
+                }
             }
         }
-        msgcnt = recvmmsg(artnetSock, msgs, MAX_MSG, MSG_DONTWAIT, nullptr);
     }
-    return sync;
+    freeifaddrs(interfaces);
+}
+
+static int CreateIngestSocket(int port) {
+    int sock = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+    if (sock < 0) {
+        LogWarn(VB_E131BRIDGE, "Bridge ingest socket for port %d failed: %s\n", port, strerror(errno));
+        return -1;
+    }
+    int enable = 1;
+    setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(enable));
+    int bufSize = 512 * 1024;
+    setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &bufSize, sizeof(bufSize));
+
+    struct sockaddr_in a;
+    memset((char*)&a, 0, sizeof(a));
+    a.sin_family = AF_INET;
+    a.sin_addr.s_addr = htonl(INADDR_ANY);
+    a.sin_port = htons(port);
+    if (bind(sock, (struct sockaddr*)&a, sizeof(a)) < 0) {
+        LogWarn(VB_E131BRIDGE, "Bridge ingest bind for port %d failed: %s\n", port, strerror(errno));
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+static void BridgeIngestLoop(BridgeIngestThread* t, int shard) {
+    SetThreadName(t->name);
+    ingestShard = shard;
+    InitReceiveBuffers(t->msgs, t->iovecs, t->buffers, t->inAddress);
+
+    std::vector<std::pair<uint32_t, uint32_t>> ranges;
+    ranges.reserve(MAX_MSG);
+    ingestRanges = &ranges;
+
+    struct pollfd pfd;
+    pfd.fd = t->sock;
+    pfd.events = POLLIN;
+    while (runIngestThreads) {
+        // timeout so the thread notices shutdown
+        pfd.revents = 0;
+        if (poll(&pfd, 1, 250) <= 0) {
+            continue;
+        }
+        bool sync = false;
+        long long packetTime = GetTimeMS();
+        if (t->directDDP) {
+            int count = 0;
+            while (Bridge_ReceiveDDPPacketDirect(t->sock, t->buffers[0], packetTime, sync)) {
+                if (++count == MAX_MSG) {
+                    sequence->AddBridgeRanges(ranges, packetTime + expireOffSet);
+                    ranges.clear();
+                    count = 0;
+                }
+            }
+            sequence->AddBridgeRanges(ranges, packetTime + expireOffSet);
+            ranges.clear();
+            if (sync) {
+                ForceChannelOutputNow();
+            }
+            continue;
+        }
+        int msgcnt = recvmmsg(t->sock, t->msgs, MAX_MSG, MSG_DONTWAIT, nullptr);
+        while (msgcnt > 0) {
+            for (int x = 0; x < msgcnt; x++) {
+                sync |= t->handler(t->buffers[x], packetTime);
+            }
+            sequence->AddBridgeRanges(ranges, packetTime + expireOffSet);
+            ranges.clear();
+            msgcnt = recvmmsg(t->sock, t->msgs, MAX_MSG, MSG_DONTWAIT, nullptr);
+        }
+        if (sync) {
+            ForceChannelOutputNow();
+        }
+    }
+    ingestRanges = nullptr;
+}
+
+static void StartIngestThreads(int sock, int port, int count, const std::string& name, std::function<bool(uint8_t*, long long)> handler) {
+    int cpus = std::thread::hardware_concurrency();
+    for (int x = 0; x < count; x++) {
+        int s = sock;
+        if (x) {
+            s = CreateIngestSocket(port);
+            if (s < 0) {
+                break;
+            }
+            if (port == E131_DEST_PORT) {
+                JoinMulticastGroups(s, x, ingestThreadCount);
+            }
+        }
+        BridgeIngestThread* t = new BridgeIngestThread(s, x != 0, "FPP-" + name + "-" + std::to_string(x), handler);
+        t->directDDP = (port == DDP_PORT) && ddpDirectReceive;
+        ingestThreads.push_back(t);
+        t->thread = std::thread(BridgeIngestLoop, t, x);
+#ifndef PLATFORM_OSX
+        if (cpus > 1) {
+            // keep the ingest threads off of CPU 0 which is busy with
+            // interrupt handling and the main fppd thread
+            cpu_set_t cpuset;
+            CPU_ZERO(&cpuset);
+            CPU_SET(1 + ((ingestThreads.size() - 1) % (cpus - 1)), &cpuset);
+            pthread_setaffinity_np(t->thread.native_handle(), sizeof(cpuset), &cpuset);
+        }
+#endif
+    }
+}
+
+static void StopIngestThreads() {
+    runIngestThreads = false;
+    for (auto t : ingestThreads) {
+        if (t->thread.joinable()) {
+            t->thread.join();
+        }
+        if (t->ownsSocket) {
+            close(t->sock);
+        }
+        delete t;
+    }
+    ingestThreads.clear();
 }
 
 bool Bridge_Initialize_Internal() {
     LogExcess(VB_E131BRIDGE, "Bridge_Initialize()\n");
 
     // prepare the msg receive buffers
-    memset(msgs, 0, sizeof(msgs));
-    for (int i = 0; i < MAX_MSG; i++) {
-        iovecs[i].iov_base = buffers[i];
-        iovecs[i].iov_len = BUFSIZE;
-        msgs[i].msg_hdr.msg_iov = &iovecs[i];
-        msgs[i].msg_hdr.msg_iovlen = 1;
-        msgs[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
-        msgs[i].msg_hdr.msg_name = &inAddress[i];
-    }
+    InitReceiveBuffers(msgs, iovecs, buffers, inAddress);
 
     /* Initialize our Universe Index lookup cache */
     for (int i = 0; i < 65536; i++) {
@@ -313,6 +652,20 @@ bool Bridge_Initialize_Internal() {
     bool enabled = LoadInputUniversesFromFile();
     bool disableFakeBridges = getSettingInt("DisableFakeNetworkBridges");
 
+    // reserve the bridge ranges for the configured universes up front
+    for (int i = 0; i < InputUniverseCount; i++) {
+        sequence->RegisterBridgeRange(InputUniverses[i].startAddress - 1, InputUniverses[i].size);
+    }
+
+    ingestThreadCount = enabled ? getSettingInt("BridgeIngestThreads", 0) : 0;
+    ddpDirectReceive = getSettingInt("BridgeDDPDirectReceive", 0);
+    if (ingestThreadCount > 0) {
+        // fill in the cache up front so the ingest threads only read it
+        for (int i = InputUniverseCount - 1; i >= 0; i--) {
+            UniverseCache[InputUniverses[i].universe & 0xFFFF] = i;
+        }
+    }
+
     LogInfo(VB_E131BRIDGE, "Universe Count = %d\n", InputUniverseCount);
     InputUniversesPrint();
 
@@ -335,6 +688,10 @@ bool Bridge_Initialize_Internal() {
         addr.sin_addr.s_addr = htonl(INADDR_ANY);
         addr.sin_port = htons(DDP_PORT);
         addrlen = sizeof(addr);
+        if (ingestThreadCount > 1) {
+            int enable = 1;
+            setsockopt(ddpSock, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(enable));
+        }
         // Bind the socket to address/port
         if (bind(ddpSock, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
             LogDebug(VB_E131BRIDGE, "e131bridge DDP bind failed: %s", strerror(errno));
@@ -357,9 +714,6 @@ bool Bridge_Initialize_Internal() {
     }
 
     if (hase131 || !disableFakeBridges) {
-        int UniverseOctet[2];
-        struct ip_mreq mreq;
-        char strMulticastGroup[16];
         /* set up socket */
         bridgeSock = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
         if (bridgeSock < 0) {
@@ -377,6 +731,10 @@ bool Bridge_Initialize_Internal() {
         addr.sin_addr.s_addr = htonl(INADDR_ANY);
         addr.sin_port = htons(E131_DEST_PORT);
         addrlen = sizeof(addr);
+        if (ingestThreadCount > 1) {
+            int enable = 1;
+            setsockopt(bridgeSock, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(enable));
+        }
         // Bind the socket to address/port
         if (bind(bridgeSock, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
             LogDebug(VB_E131BRIDGE, "e131bridge bind failed: %s", strerror(errno));
@@ -386,56 +744,7 @@ bool Bridge_Initialize_Internal() {
         int bufSize = 512 * 1024;
         setsockopt(bridgeSock, SOL_SOCKET, SO_RCVBUF, &bufSize, sizeof(bufSize));
 
-        // get all the addresses
-        struct ifaddrs *interfaces, *tmp;
-        getifaddrs(&interfaces);
-
-        char address[16];
-        address[0] = 0;
-        // Join the multicast groups
-        for (int i = 0; i < InputUniverseCount; i++) {
-            if (InputUniverses[i].type == E131_TYPE_MULTICAST) {
-                UniverseOctet[0] = InputUniverses[i].universe / 256;
-                UniverseOctet[1] = InputUniverses[i].universe % 256;
-                snprintf(strMulticastGroup, sizeof(strMulticastGroup), "239.255.%d.%d", UniverseOctet[0], UniverseOctet[1]);
-                mreq.imr_multiaddr.s_addr = inet_addr(strMulticastGroup);
-
-                LogInfo(VB_E131BRIDGE, "Adding group %s\n", strMulticastGroup);
-
-                // add group to groups to listen for on eth0 and wlan0 if it exists
-                int multicastJoined = 0;
-                tmp = interfaces;
-                // loop through all the interfaces and subscribe to the group
-                while (tmp) {
-                    // struct sockaddr_in *sin = (struct sockaddr_in *)tmp->ifa_addr;
-                    // strcpy(address, inet_ntoa(sin->sin_addr));
-                    if (tmp->ifa_addr && tmp->ifa_addr->sa_family == AF_INET) {
-                        GetInterfaceAddress(tmp->ifa_name, address, NULL, NULL);
-                        if (strcmp(address, "127.0.0.1")) {
-                            LogDebug(VB_E131BRIDGE, "   Adding interface %s - %s\n", tmp->ifa_name, address);
-                            mreq.imr_interface.s_addr = inet_addr(address);
-                            if (setsockopt(bridgeSock, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0) {
-                                LogWarn(VB_E131BRIDGE, "   Could not setup Multicast Group for interface %s\n", tmp->ifa_name);
-                            }
-                            multicastJoined = 1;
-                        }
-                    } else if (tmp->ifa_addr && tmp->ifa_addr->sa_family == AF_INET6) {
-                        // FIXME for ipv6 multicast
-                        // LogDebug(VB_E131BRIDGE, "   Inet6 interface %s\n", tmp->ifa_name);
-                    }
-                    tmp = tmp->ifa_next;
-                }
-
-                if (!multicastJoined) {
-                    LogDebug(VB_E131BRIDGE, "  Binding to default interface\n");
-                    mreq.imr_interface.s_addr = htonl(INADDR_ANY);
-                    if (setsockopt(bridgeSock, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0) {
-                        LogWarn(VB_E131BRIDGE, "   Could not setup Multicast Group\n");
-                    }
-                }
-            }
-        }
-        freeifaddrs(interfaces);
+        JoinMulticastGroups(bridgeSock, 0, std::max(ingestThreadCount, 1));
     }
 
     if (hasArtNet || getSettingInt("ARTNETTimeCodeSync", 0)) {
@@ -488,6 +797,7 @@ bool Bridge_StoreData(uint8_t* bridgeBuffer, long long packetTime) {
     } else if (bridgeBuffer[E131_VECTOR_INDEX] == VECTOR_ROOT_E131_EXTENDED) {
         if (bridgeBuffer[E131_EXTENDED_PACKET_TYPE_INDEX] == VECTOR_E131_EXTENDED_SYNCHRONIZATION) {
             e131SyncPackets++;
+            sequence->CommitBridgeData();
             return true;
         }
         e131Errors++;
@@ -501,6 +811,7 @@ bool Bridge_StoreData(uint8_t* bridgeBuffer, long long packetTime) {
 
 bool Bridge_HandleArtNetSync(uint8_t* bridgeBuffer, long long packetTime) {
     // sync packet
+    sequence->CommitBridgeData();
     return true;
 }
 bool Bridge_StoreArtNetData(uint8_t* bridgeBuffer, long long packetTime) {
@@ -631,46 +942,56 @@ bool Bridge_HandleArtNetPoll(uint8_t* bridgeBuffer, long long packetTime) {
     }
     return false;
 }
+static void Bridge_ReadDDPHeader(const uint8_t* bridgeBuffer, uint32_t& chan, uint32_t& len) {
+    ddpPacketsReceived++;
+    chan = bridgeBuffer[4];
+    chan <<= 8;
+    chan += bridgeBuffer[5];
+    chan <<= 8;
+    chan += bridgeBuffer[6];
+    chan <<= 8;
+    chan += bridgeBuffer[7];
+
+    len = bridgeBuffer[8] << 8;
+    len += bridgeBuffer[9];
+
+    uint32_t sn = bridgeBuffer[1] & 0xF;
+    if (sn) {
+        bool isErr = false;
+        if (ddpLastSequence) {
+            if (sn == 1) {
+                if (ddpLastSequence != 15) {
+                    isErr = true;
+                }
+            } else if ((sn - 1) != ddpLastSequence) {
+                isErr = true;
+            }
+        }
+        if (isErr) {
+            ddpErrors++;
+            // printf("%d   %d    %d  %d\n", sn, ddpLastSequence, chan, ddpLastChannel);
+        }
+        ddpLastSequence = sn;
+        ddpLastChannel = chan + len;
+    }
+
+    uint32_t v = ddpMinChannel.load(std::memory_order_relaxed);
+    while ((chan + 1) < v && !ddpMinChannel.compare_exchange_weak(v, chan + 1, std::memory_order_relaxed)) {
+    }
+    v = ddpMaxChannel.load(std::memory_order_relaxed);
+    while ((chan + len) > v && !ddpMaxChannel.compare_exchange_weak(v, chan + len, std::memory_order_relaxed)) {
+    }
+}
+
 bool Bridge_StoreDDPData(uint8_t* bridgeBuffer, long long packetTime) {
     bool push = false;
     if (bridgeBuffer[3] == 1) {
-        ddpPacketsReceived++;
         bool tc = bridgeBuffer[0] & DDP_TIMECODE_FLAG;
         push = bridgeBuffer[0] & DDP_PUSH_FLAG;
 
-        uint32_t chan = bridgeBuffer[4];
-        chan <<= 8;
-        chan += bridgeBuffer[5];
-        chan <<= 8;
-        chan += bridgeBuffer[6];
-        chan <<= 8;
-        chan += bridgeBuffer[7];
-
-        uint32_t len = bridgeBuffer[8] << 8;
-        len += bridgeBuffer[9];
-
-        uint32_t sn = bridgeBuffer[1] & 0xF;
-        if (sn) {
-            bool isErr = false;
-            if (ddpLastSequence) {
-                if (sn == 1) {
-                    if (ddpLastSequence != 15) {
-                        isErr = true;
-                    }
-                } else if ((sn - 1) != ddpLastSequence) {
-                    isErr = true;
-                }
-            }
-            if (isErr) {
-                ddpErrors++;
-                // printf("%d   %d    %d  %d\n", sn, ddpLastSequence, chan, ddpLastChannel);
-            }
-            ddpLastSequence = sn;
-            ddpLastChannel = chan + len;
-        }
-
-        ddpMinChannel = std::min(ddpMinChannel, chan + 1);
-        ddpMaxChannel = std::max(ddpMaxChannel, chan + len);
+        uint32_t chan = 0;
+        uint32_t len = 0;
+        Bridge_ReadDDPHeader(bridgeBuffer, chan, len);
 
         int offset = tc ? 14 : 10;
         SetBridgeData(&bridgeBuffer[offset],
@@ -678,6 +999,9 @@ bool Bridge_StoreDDPData(uint8_t* bridgeBuffer, long long packetTime) {
                       len,
                       packetTime);
         ddpBytesReceived += len;
+        if (push) {
+            sequence->CommitBridgeData();
+        }
     } else if (bridgeBuffer[0] & 0x02 && bridgeBuffer[3] == 250) {
         printf("Query config packet: %d \n", (int)bridgeBuffer[3]);
     } else if (bridgeBuffer[0] & 0x02 && bridgeBuffer[3] == 251) {
@@ -705,6 +1029,8 @@ inline int Bridge_GetIndexFromUniverseNumber(int universe) {
 }
 
 void Bridge_Shutdown(void) {
+    BridgeRecorder::INSTANCE.Stop();
+    StopIngestThreads();
     if (bridgeSock >= 0)
         close(bridgeSock);
     if (ddpSock >= 0)
@@ -715,6 +1041,7 @@ void Bridge_Shutdown(void) {
     ddpSock = -1;
     artnetSock = -1;
 
+    std::unique_lock<std::shared_mutex> lock(ArtNetOpcodeHandlersLock);
     ArtNetOpcodeHandlers.clear();
 }
 
@@ -839,6 +1166,11 @@ Json::Value GetE131UniverseBytesReceived() {
     }
 
     result["universes"] = universes;
+    if (BridgeRecorder::INSTANCE.IsRecording()) {
+        Json::Value recording;
+        BridgeRecorder::INSTANCE.GetStatus(recording);
+        result["recording"] = recording;
+    }
 
     return result;
 }
@@ -891,44 +1223,8 @@ bool AddWarningForProtocol(int sock, const std::string& protocol) {
 void Bridge_Initialize(std::map<int, std::function<bool(int)>>& callbacks) {
     bool enabled = Bridge_Initialize_Internal();
     bool disableFakeBridges = getSettingInt("DisableFakeNetworkBridges");
-    if (bridgeSock > 0) {
-        if (enabled) {
-            std::function<bool(int)> f = [](int i) {
-                return Bridge_ReceiveE131Data();
-            };
-            callbacks[bridgeSock] = f;
-        } else if (!disableFakeBridges) {
-            std::function<bool(int)> f = [](int i) {
-                return AddWarningForProtocol(i, "E1.31");
-            };
-            callbacks[bridgeSock] = f;
-        }
-    }
-    if (ddpSock > 0) {
-        if (enabled) {
-            std::function<bool(int)> f = [](int i) {
-                return Bridge_ReceiveDDPData();
-            };
-            callbacks[ddpSock] = f;
-        } else if (!disableFakeBridges) {
-            std::function<bool(int)> f = [](int i) {
-                return AddWarningForProtocol(i, "DDP");
-            };
-            callbacks[ddpSock] = f;
-        }
-    }
-    if (artnetSock > 0) {
-        if (enabled) {
-            AddArtNetOpcodeHandler(0x5000, Bridge_StoreArtNetData);  // ArtOutput
-            AddArtNetOpcodeHandler(0x5200, Bridge_HandleArtNetSync); // ArtSync
-            AddArtNetOpcodeHandler(0x2000, Bridge_HandleArtNetPoll); // ArtPoll
-
-            std::function<bool(int)> f = [](int i) {
-                return Bridge_ReceiveArtNetData();
-            };
-            callbacks[artnetSock] = f;
-        }
-    }
+    // DMX inputs grow InputUniverses so they must be added before any
+    // ingest thread starts reading it
     std::string filename = FPP_DIR_CONFIG("/ci-dmx.json");
     if (FileExists(filename)) {
         Json::Value root;
@@ -1002,6 +1298,63 @@ void Bridge_Initialize(std::map<int, std::function<bool(int)>>& callbacks) {
             }
         }
     }
+    if (enabled && ingestThreadCount > 0) {
+        runIngestThreads = true;
+    }
+    if (bridgeSock > 0) {
+        if (enabled && ingestThreadCount > 0) {
+            StartIngestThreads(bridgeSock, E131_DEST_PORT, ingestThreadCount, "E131In", Bridge_StoreData);
+        } else if (enabled) {
+            std::function<bool(int)> f = [](int i) {
+                return Bridge_ReceiveE131Data();
+            };
+            callbacks[bridgeSock] = f;
+        } else if (!disableFakeBridges) {
+            std::function<bool(int)> f = [](int i) {
+                return AddWarningForProtocol(i, "E1.31");
+            };
+            callbacks[bridgeSock] = f;
+        }
+    }
+    if (ddpSock > 0) {
+        if (enabled && ingestThreadCount > 0) {
+            StartIngestThreads(ddpSock, DDP_PORT, ingestThreadCount, "DDPIn", Bridge_StoreDDPData);
+        } else if (enabled) {
+            std::function<bool(int)> f = [](int i) {
+                return Bridge_ReceiveDDPData();
+            };
+            callbacks[ddpSock] = f;
+        } else if (!disableFakeBridges) {
+            std::function<bool(int)> f = [](int i) {
+                return AddWarningForProtocol(i, "DDP");
+            };
+            callbacks[ddpSock] = f;
+        }
+    }
+    if (artnetSock > 0) {
+        if (enabled) {
+            AddArtNetOpcodeHandler(0x5000, Bridge_StoreArtNetData);  // ArtOutput
+            AddArtNetOpcodeHandler(0x5200, Bridge_HandleArtNetSync); // ArtSync
+            AddArtNetOpcodeHandler(0x2000, Bridge_HandleArtNetPoll); // ArtPoll
+
+            if (ingestThreadCount > 0) {
+                // Broadcast packets are copied to every socket bound to the
+                // port so broadcast universes can only use a single thread
+                int count = ingestThreadCount;
+                for (int i = 0; i < InputUniverseCount; i++) {
+                    if (InputUniverses[i].type == ARTNET_TYPE_BROADCAST) {
+                        count = 1;
+                    }
+                }
+                StartIngestThreads(artnetSock, 0x1936, count, "ArtNetIn", Bridge_HandleArtNetPacket);
+            } else {
+                std::function<bool(int)> f = [](int i) {
+                    return Bridge_ReceiveArtNetData();
+                };
+                callbacks[artnetSock] = f;
+            }
+        }
+    }
 }
 
 bool HasBridgeData() {
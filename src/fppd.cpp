@@ -53,6 +53,7 @@
 #include "mqtt.h"
 #include "settings.h"
 
+#include "BridgeRecorder.h"
 #include "CurlManager.h"
 #include "Events.h"
 #include "MultiSync.h"
@@ -62,6 +63,7 @@
 #include "Plugins.h"
 #include "Scheduler.h"
 #include "Sequence.h"
+#include "SequenceStream.h"
 #include "Timers.h"
 #include "Warnings.h"
 #include "command.h"
@@ -713,6 +715,9 @@ int main(int argc, char* argv[]) {
     if (!MultiSync::INSTANCE.Init()) {
         exit(EXIT_FAILURE);
     }
+    if (getFPPmode() == REMOTE_MODE) {
+        SequenceStreamReceiver::INSTANCE.Init();
+    }
 
     Sensors::INSTANCE.DetectHWSensors();
     initCape();
@@ -735,6 +740,7 @@ int main(int argc, char* argv[]) {
 
     InitEffects();
     ChannelTester::INSTANCE.RegisterCommands();
+    BridgeRecorder::INSTANCE.RegisterCommands();
 
     WriteRuntimeInfoFile(multiSync->GetSystems(true, false));
 
@@ -756,6 +762,7 @@ int main(int argc, char* argv[]) {
     OutputMonitor::INSTANCE.Cleanup();
     CommandManager::INSTANCE.Cleanup();
     MultiSync::INSTANCE.ShutdownSync();
+    SequenceStreamReceiver::INSTANCE.Shutdown();
     PluginManager::INSTANCE.Cleanup();
     GPIOManager::INSTANCE.Cleanup();
 
@@ -28,6 +28,7 @@
 #include "commands/Commands.h"
 
 #include "fppversion.h"
+#include "overlays/PixelOverlayBuffer.h"
 
 char* blockName = NULL;
 char* inputFilename = NULL;
@@ -48,7 +49,8 @@ void usage(char* appname) {
     printf("                            VALUE of -1 will delete the range\n");
     printf("   -m MODEL               - List info about Pixel Overlay MODEL\n");
     printf("   -m MODEL -o MODE       - Set Pixel Overlay mode, Mode is one of:\n");
-    printf("                            off, on, transparent, transparentrgb\n");
+    printf("                            off, on, transparent, transparentrgb,\n");
+    printf("                            alpha, add, max, multiply, subtract\n");
     printf("   -m MODEL -f FILENAME   - Copy raw FILENAME data to MODEL\n");
     printf("   -m MODEL -s VALUE      - Fill MODEL with VALUE for all channels\n");
     printf("   -h                     - This help output\n");
@@ -95,6 +97,16 @@ static void parseArguments(int argc, char** argv) {
                 isActive = 2;
             else if (!strcmp(optarg, "transparentrgb"))
                 isActive = 3;
+            else if (!strcmp(optarg, "alpha"))
+                isActive = 4;
+            else if (!strcmp(optarg, "add"))
+                isActive = 5;
+            else if (!strcmp(optarg, "max"))
+                isActive = 6;
+            else if (!strcmp(optarg, "multiply"))
+                isActive = 7;
+            else if (!strcmp(optarg, "subtract"))
+                isActive = 8;
 
             break;
         case 'f':
@@ -192,15 +204,45 @@ void CopyFileToMappedBlock(const std::string& blockName, char* inputFilename) {
         std::string overlayBuferName = "/FPP-Model-Overlay-Buffer-" + blockName;
         mode_t mode = S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH | S_IWOTH;
         int f = shm_open(overlayBuferName.c_str(), O_RDWR | O_CREAT, mode);
+        struct stat st;
+        fstat(f, &st);
         int size = width * height * 3 + 12;
-        uint8_t* overlayBufferData = (uint8_t*)mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, f, 0);
+        if (st.st_size >= PixelOverlayBufferSize(width, height)) {
+            // fppd has set up the buffer with the frame handoff
+            size = PixelOverlayBufferSize(width, height);
+        } else if (st.st_size < size) {
+            ftruncate(f, size);
+        }
+        PixelOverlayBuffer* buffer = (PixelOverlayBuffer*)mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, f, 0);
         close(f);
-        memcpy(&overlayBufferData[12], data, channelCount);
-        //data is copied, mark the overlay buffer as dirty so it gets copied into the data buffer
-        uint32_t* flags = (uint32_t*)&overlayBufferData[8];
-        *flags |= 1;
-        munmap(overlayBufferData, size);
-        printf("Data imported\n");
+        PixelOverlayBufferSync* sync = nullptr;
+        if (size > width * height * 3 + 12) {
+            sync = PixelOverlayBufferGetSync(buffer);
+            if (__atomic_load_n(&sync->magic, __ATOMIC_ACQUIRE) != FPP_OVERLAY_SYNC_MAGIC) {
+                sync = nullptr;
+            }
+        }
+        if (sync) {
+            // publish into the buffer fppd isn't using once it has taken
+            // any previous frame, then wait for it to take ours
+            uint32_t seq = __atomic_load_n(&sync->readySeq, __ATOMIC_ACQUIRE);
+            PixelOverlayBufferWaitConsumed(sync, seq, 1000);
+            uint32_t idx = (sync->readyIndex & 0x1) ^ 0x1;
+            memcpy(PixelOverlayBufferData(buffer, idx), data, channelCount);
+            sync->readyIndex = idx;
+            __atomic_store_n(&sync->readySeq, seq + 1, __ATOMIC_RELEASE);
+            if (PixelOverlayBufferWaitConsumed(sync, seq + 1, 1000)) {
+                printf("Data imported at frame %u\n", __atomic_load_n(&sync->frameNumber, __ATOMIC_ACQUIRE));
+            } else {
+                printf("Data queued, the model is not currently being output\n");
+            }
+        } else {
+            memcpy(buffer->data, data, channelCount);
+            //data is copied, mark the overlay buffer as dirty so it gets copied into the data buffer
+            __atomic_fetch_or(&buffer->flags, FPP_OVERLAY_BUFFER_DIRTY, __ATOMIC_RELEASE);
+            printf("Data imported\n");
+        }
+        munmap(buffer, size);
     }
 }
 
@@ -252,6 +294,21 @@ void DumpMappedBlockInfo(const std::string& blockName) {
     case 3:
         printf("Active (Transparent RGB)\n");
         break;
+    case 4:
+        printf("Active (Alpha, Opacity %d)\n", v["opacity"].asInt());
+        break;
+    case 5:
+        printf("Active (Add)\n");
+        break;
+    case 6:
+        printf("Active (Max)\n");
+        break;
+    case 7:
+        printf("Active (Multiply)\n");
+        break;
+    case 8:
+        printf("Active (Subtract)\n");
+        break;
     }
 
     printf("Effect running : ");
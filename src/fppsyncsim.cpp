@@ -0,0 +1,700 @@
+/*
+ * This file is part of the Falcon Player (FPP) and is Copyright (C)
+ * 2013-2022 by the Falcon Player Developers.
+ *
+ * The Falcon Player (FPP) is free software, and is covered under
+ * multiple Open Source licenses.  Please see the included 'LICENSES'
+ * file for descriptions of what files are covered by each license.
+ *
+ * This source file is covered under the GPL v2 as described in the
+ * included LICENSE.GPL file.
+ */
+
+/*
+ * MultiSync fleet simulator
+ *
+ * Runs a number of virtual remotes in one process, each with its own
+ * socket bound to FPP_CTRL_PORT on a separate (loopback) address.  They
+ * speak the real MultiSync protocol: sync packets are followed with the
+ * same clock offset estimation and frame clock PLL as fppd remotes and
+ * the error to the master's timeline, packet loss and master CPU usage
+ * are reported.  The master is either built in or a real fppd driven
+ * through /api/command.
+ */
+
+#include "fpp-pch.h"
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <getopt.h>
+#include <random>
+
+#include "MasterClock.h"
+#include "MultiSync.h"
+#include "common.h"
+#include "fppversion.h"
+
+static const char* MULTISYNC_MULTICAST_ADDRESS = "239.70.80.80"; // 239.F.P.P
+
+static int remoteCount = 10;
+static std::string remoteBase = "127.0.1.1";
+static std::string masterAddress = "127.0.0.2";
+static bool joinMulticast = false;
+static int duration = 30;
+static int frameRate = 40;
+static int syncInterval = 10;
+static double lossPct = 0.0;
+static int jitterUS = 0;
+static std::string fppdHost;
+static std::string playlist;
+static int masterPid = 0;
+static std::string jsonFile;
+
+static std::atomic<bool> running(true);
+static std::atomic<uint32_t> syncPacketsSent(0);
+static std::atomic<long long> masterCPUTime(0);
+static std::atomic<long long> masterSendTime(0);
+
+class VirtualRemote {
+public:
+    std::string address;
+    int sock = -1;
+
+    // receive stats
+    uint32_t syncPackets = 0;
+    uint32_t otherPackets = 0;
+    uint32_t dropped = 0;
+    std::vector<long long> errors;
+
+    // the same clock offset estimation and frame clock follower as fppd
+    MasterClockEstimator clock;
+    long long lastTimeRequest = 0;
+    MasterClockPLL timeline;
+};
+
+static std::vector<VirtualRemote> remotes;
+
+/*
+ * Usage information for fppsyncsim binary
+ */
+void usage(char* appname) {
+    printf("Usage: %s [OPTIONS]\n", appname);
+    printf("\n");
+    printf("  Options:\n");
+    printf("   -V                     - Print version information\n");
+    printf("   -n COUNT               - Number of virtual remotes (default 10)\n");
+    printf("   -b ADDRESS             - Address of the first remote, the others use the\n");
+    printf("                            following addresses (default 127.0.1.1)\n");
+    printf("   -a ADDRESS             - Address of the built in master (default 127.0.0.2)\n");
+    printf("   -M                     - Remotes also join the MultiSync multicast group\n");
+    printf("   -t SECONDS             - Length of the test (default 30)\n");
+    printf("   -r FPS                 - Frame rate of the built in master (default 40)\n");
+    printf("   -s FRAMES              - Built in master sends sync every FRAMES frames (default 10)\n");
+    printf("   -l PERCENT             - Simulated packet loss on the remotes\n");
+    printf("   -j USEC                - Simulated maximum receive jitter on the remotes\n");
+    printf("   -f HOST                - Drive the fppd master on HOST via /api/command instead\n");
+    printf("                            of using the built in master.  The master must send\n");
+    printf("                            MultiSync to the remote addresses or via multicast (-M)\n");
+    printf("   -p PLAYLIST            - Playlist to start on the fppd master\n");
+    printf("   -P PID                 - Sample CPU usage of local process PID as the master\n");
+    printf("   -o FILE                - Write the results as JSON to FILE\n");
+    printf("   -h                     - This help output\n");
+}
+
+/*
+ * Parse command line arguments for fppsyncsim binary
+ */
+static void parseArguments(int argc, char** argv) {
+    int c;
+
+    while (1) {
+        int option_index = 0;
+        static struct option long_options[] = {
+            { "displayvers", no_argument, 0, 'V' },
+            { "remotes", required_argument, 0, 'n' },
+            { "base", required_argument, 0, 'b' },
+            { "master", required_argument, 0, 'a' },
+            { "multicast", no_argument, 0, 'M' },
+            { "time", required_argument, 0, 't' },
+            { "rate", required_argument, 0, 'r' },
+            { "sync", required_argument, 0, 's' },
+            { "loss", required_argument, 0, 'l' },
+            { "jitter", required_argument, 0, 'j' },
+            { "fppd", required_argument, 0, 'f' },
+            { "playlist", required_argument, 0, 'p' },
+            { "pid", required_argument, 0, 'P' },
+            { "output", required_argument, 0, 'o' },
+            { "help", no_argument, 0, 'h' },
+            { 0, 0, 0, 0 }
+        };
+
+        c = getopt_long(argc, argv, "Vn:b:a:Mt:r:s:l:j:f:p:P:o:h", long_options, &option_index);
+        if (c == -1)
+            break;
+
+        switch (c) {
+        case 'V':
+            printVersionInfo();
+            exit(0);
+        case 'n':
+            remoteCount = std::max(1, atoi(optarg));
+            break;
+        case 'b':
+            remoteBase = optarg;
+            break;
+        case 'a':
+            masterAddress = optarg;
+            break;
+        case 'M':
+            joinMulticast = true;
+            break;
+        case 't':
+            duration = std::max(1, atoi(optarg));
+            break;
+        case 'r':
+            frameRate = std::clamp(atoi(optarg), 1, 1000);
+            break;
+        case 's':
+            syncInterval = std::max(1, atoi(optarg));
+            break;
+        case 'l':
+            lossPct = std::clamp(atof(optarg), 0.0, 100.0);
+            break;
+        case 'j':
+            jitterUS = std::max(0, atoi(optarg));
+            break;
+        case 'f':
+            fppdHost = optarg;
+            break;
+        case 'p':
+            playlist = optarg;
+            break;
+        case 'P':
+            masterPid = atoi(optarg);
+            break;
+        case 'o':
+            jsonFile = optarg;
+            break;
+        case 'h':
+            usage(argv[0]);
+            exit(EXIT_SUCCESS);
+        default:
+            usage(argv[0]);
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+/*
+ * Open a UDP socket bound to the control port on the given address
+ */
+static int OpenSocket(const std::string& address, bool multicast) {
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock < 0) {
+        fprintf(stderr, "Error opening socket: %s\n", strerror(errno));
+        return -1;
+    }
+    int optval = 1;
+    setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &optval, sizeof(optval));
+    setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, &optval, sizeof(optval));
+    setsockopt(sock, SOL_SOCKET, SO_TIMESTAMP, &optval, sizeof(optval));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(FPP_CTRL_PORT);
+    addr.sin_addr.s_addr = inet_addr(address.c_str());
+    if (bind(sock, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        fprintf(stderr, "Error binding to %s:%d: %s\n", address.c_str(), FPP_CTRL_PORT, strerror(errno));
+        close(sock);
+        return -1;
+    }
+    if (multicast) {
+        struct ip_mreq mreq;
+        memset(&mreq, 0, sizeof(mreq));
+        mreq.imr_multiaddr.s_addr = inet_addr(MULTISYNC_MULTICAST_ADDRESS);
+        mreq.imr_interface.s_addr = INADDR_ANY;
+        if (setsockopt(sock, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0) {
+            fprintf(stderr, "Could not join multicast group on %s: %s\n", address.c_str(), strerror(errno));
+        }
+    }
+    return sock;
+}
+
+static void SendTo(int sock, const std::string& address, void* buf, int len) {
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(FPP_CTRL_PORT);
+    addr.sin_addr.s_addr = inet_addr(address.c_str());
+    sendto(sock, buf, len, MSG_DONTWAIT, (struct sockaddr*)&addr, sizeof(addr));
+}
+
+/*
+ * Receive a packet along with its kernel receive timestamp
+ */
+static int ReceivePacket(int sock, uint8_t* buf, int size, struct sockaddr_in& src, long long& rcvTime) {
+    struct iovec iov = { buf, (size_t)size };
+    unsigned char cmbuf[0x100];
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_name = &src;
+    msg.msg_namelen = sizeof(src);
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = cmbuf;
+    msg.msg_controllen = sizeof(cmbuf);
+
+    int len = recvmsg(sock, &msg, MSG_DONTWAIT);
+    rcvTime = GetTimeMicros();
+    if (len <= 0) {
+        return len;
+    }
+    for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMP) {
+            struct timeval tv;
+            memcpy(&tv, CMSG_DATA(cmsg), sizeof(tv));
+            rcvTime = tv.tv_sec * 1000000LL + tv.tv_usec;
+        }
+    }
+    return len;
+}
+
+static void InitControlPacket(ControlPkt* cpkt, uint8_t type, int extraDataLen) {
+    cpkt->fppd[0] = 'F';
+    cpkt->fppd[1] = 'P';
+    cpkt->fppd[2] = 'P';
+    cpkt->fppd[3] = 'D';
+    cpkt->pktType = type;
+    cpkt->extraDataLen = extraDataLen;
+}
+
+/*
+ * Built in master, sends sequence sync packets to all remotes and answers
+ * their time requests
+ */
+static void RunMaster(int sock, const std::string& filename) {
+    std::vector<struct sockaddr_in> addrs;
+    for (auto& r : remotes) {
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(FPP_CTRL_PORT);
+        addr.sin_addr.s_addr = inet_addr(r.address.c_str());
+        addrs.push_back(addr);
+    }
+    struct iovec iov;
+    std::vector<struct mmsghdr> msgs(addrs.size());
+    for (int x = 0; x < addrs.size(); x++) {
+        memset(&msgs[x], 0, sizeof(struct mmsghdr));
+        msgs[x].msg_hdr.msg_name = &addrs[x];
+        msgs[x].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+        msgs[x].msg_hdr.msg_iov = &iov;
+        msgs[x].msg_hdr.msg_iovlen = 1;
+    }
+
+    uint8_t outBuf[2048];
+    auto sendSync = [&](uint8_t type, int frame, float seconds) {
+        memset(outBuf, 0, sizeof(outBuf));
+        int len = sizeof(ControlPkt) + sizeof(SyncPkt) + filename.length();
+        InitControlPacket((ControlPkt*)outBuf, CTRL_PKT_SYNC, sizeof(SyncPkt) + filename.length());
+        SyncPkt* spkt = (SyncPkt*)(outBuf + sizeof(ControlPkt));
+        spkt->pktType = type;
+        spkt->fileType = SYNC_FILE_SEQ;
+        spkt->frameNumber = frame;
+        spkt->secondsElapsed = seconds;
+        strcpy(spkt->filename, filename.c_str());
+        if (type == SYNC_PKT_SYNC) {
+            SyncPktTimestamp ts;
+            ts.marker[0] = 'T';
+            ts.marker[1] = 'S';
+            ts.masterTime = GetTimeMicros();
+            memcpy(outBuf + len, &ts, sizeof(ts));
+            len += sizeof(ts);
+            ((ControlPkt*)outBuf)->extraDataLen += sizeof(ts);
+        }
+        iov.iov_base = outBuf;
+        iov.iov_len = len;
+
+        long long start = GetTimeMicros();
+        int sent = 0;
+        while (sent < msgs.size()) {
+            int rc = sendmmsg(sock, &msgs[sent], msgs.size() - sent, 0);
+            if (rc <= 0) {
+                break;
+            }
+            sent += rc;
+        }
+        masterSendTime += GetTimeMicros() - start;
+        if (type == SYNC_PKT_SYNC) {
+            syncPacketsSent++;
+        }
+    };
+
+    struct rusage startUsage;
+    getrusage(RUSAGE_THREAD, &startUsage);
+
+    sendSync(SYNC_PKT_OPEN, 0, 0.0f);
+    sendSync(SYNC_PKT_START, 0, 0.0f);
+
+    long long frameTime = 1000000 / frameRate;
+    long long startTime = GetTimeMicros();
+    int frame = 0;
+    while (running) {
+        long long now = GetTimeMicros();
+        long long next = startTime + (frame + 1) * frameTime;
+        struct pollfd pfd = { sock, POLLIN, 0 };
+        int timeout = std::max(0LL, (next - now) / 1000);
+        if (poll(&pfd, 1, timeout) > 0) {
+            uint8_t buf[1500];
+            struct sockaddr_in src;
+            long long rcvTime;
+            int len;
+            while ((len = ReceivePacket(sock, buf, sizeof(buf), src, rcvTime)) > 0) {
+                ControlPkt* cpkt = (ControlPkt*)buf;
+                if (len < (sizeof(ControlPkt) + sizeof(TimePkt)) || cpkt->pktType != CTRL_PKT_TIME) {
+                    continue;
+                }
+                TimePkt tpkt;
+                memcpy(&tpkt, buf + sizeof(ControlPkt), sizeof(tpkt));
+                if (tpkt.pktType != TIME_PKT_REQUEST) {
+                    continue;
+                }
+                tpkt.pktType = TIME_PKT_REPLY;
+                tpkt.receiveTime = rcvTime;
+                tpkt.transmitTime = GetTimeMicros();
+                memcpy(buf + sizeof(ControlPkt), &tpkt, sizeof(tpkt));
+                sendto(sock, buf, sizeof(ControlPkt) + sizeof(TimePkt), MSG_DONTWAIT, (struct sockaddr*)&src, sizeof(src));
+            }
+        }
+        now = GetTimeMicros();
+        if (now >= next) {
+            frame++;
+            if ((frame % syncInterval) == 0) {
+                sendSync(SYNC_PKT_SYNC, frame, (float)frame / frameRate);
+            }
+        }
+    }
+    sendSync(SYNC_PKT_STOP, frame, (float)frame / frameRate);
+
+    struct rusage endUsage;
+    getrusage(RUSAGE_THREAD, &endUsage);
+    auto toMicros = [](const struct timeval& tv) { return tv.tv_sec * 1000000LL + tv.tv_usec; };
+    masterCPUTime = toMicros(endUsage.ru_utime) - toMicros(startUsage.ru_utime) +
+                    toMicros(endUsage.ru_stime) - toMicros(startUsage.ru_stime);
+}
+
+static void SendTimeRequest(VirtualRemote& r, const std::string& master) {
+    uint8_t outBuf[sizeof(ControlPkt) + sizeof(TimePkt)];
+    memset(outBuf, 0, sizeof(outBuf));
+    InitControlPacket((ControlPkt*)outBuf, CTRL_PKT_TIME, sizeof(TimePkt));
+    TimePkt tpkt;
+    memset(&tpkt, 0, sizeof(tpkt));
+    tpkt.pktType = TIME_PKT_REQUEST;
+    r.lastTimeRequest = GetTimeMicros();
+    tpkt.originateTime = r.lastTimeRequest;
+    memcpy(outBuf + sizeof(ControlPkt), &tpkt, sizeof(tpkt));
+    SendTo(r.sock, master, outBuf, sizeof(outBuf));
+}
+
+/*
+ * Follow the master's frame clock the same way fppd remotes do and
+ * record how far the prediction is from the master's actual timeline
+ */
+static void ProcessSync(VirtualRemote& r, SyncPkt* spkt, int extraDataLen, long long rcvTime, bool sameClock) {
+    long long position = (long long)(spkt->secondsElapsed * 1000000.0f);
+    int tsOffset = offsetof(SyncPkt, filename) + strnlen(spkt->filename, extraDataLen - offsetof(SyncPkt, filename)) + 1;
+    bool hasTs = extraDataLen >= (tsOffset + (int)sizeof(SyncPktTimestamp));
+    SyncPktTimestamp ts;
+    if (hasTs) {
+        memcpy(&ts, ((uint8_t*)spkt) + tsOffset, sizeof(ts));
+        hasTs = ts.marker[0] == 'T' && ts.marker[1] == 'S';
+    }
+
+    long long sampleTime = rcvTime;
+    if (hasTs && r.clock.isValid()) {
+        sampleTime = (long long)ts.masterTime - r.clock.getOffset();
+    }
+
+    if (r.timeline.isValid() && hasTs) {
+        // local time we expected the master to be at this position vs
+        // when it really was, on the master's clock if it is shared
+        long long expected = r.timeline.getLocalTime(position);
+        long long actual = (long long)ts.masterTime - (sameClock ? 0 : r.clock.getOffset());
+        if (sameClock || r.clock.isValid()) {
+            r.errors.push_back(expected - actual);
+        }
+    }
+
+    long long err;
+    r.timeline.update(sampleTime, position, err);
+}
+
+/*
+ * Receive and process packets for all the virtual remotes
+ */
+static void RunRemotes(const std::string& master, bool sameClock) {
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<double> lossDist(0.0, 100.0);
+    std::uniform_int_distribution<int> jitterDist(0, jitterUS);
+
+    std::vector<struct pollfd> pfds(remotes.size());
+    for (int x = 0; x < remotes.size(); x++) {
+        pfds[x].fd = remotes[x].sock;
+        pfds[x].events = POLLIN;
+    }
+    uint8_t buf[1500];
+    while (running) {
+        if (poll(&pfds[0], pfds.size(), 50) <= 0) {
+            continue;
+        }
+        for (int x = 0; x < remotes.size(); x++) {
+            if (!(pfds[x].revents & POLLIN)) {
+                continue;
+            }
+            VirtualRemote& r = remotes[x];
+            struct sockaddr_in src;
+            long long rcvTime;
+            int len;
+            while ((len = ReceivePacket(r.sock, buf, sizeof(buf), src, rcvTime)) > 0) {
+                ControlPkt* cpkt = (ControlPkt*)buf;
+                if (len < sizeof(ControlPkt) || memcmp(cpkt->fppd, "FPPD", 4) || len != (sizeof(ControlPkt) + cpkt->extraDataLen)) {
+                    continue;
+                }
+                if (cpkt->pktType == CTRL_PKT_TIME && cpkt->extraDataLen >= sizeof(TimePkt)) {
+                    TimePkt tpkt;
+                    memcpy(&tpkt, buf + sizeof(ControlPkt), sizeof(tpkt));
+                    if (tpkt.pktType == TIME_PKT_REPLY) {
+                        r.clock.addSample(tpkt.originateTime, tpkt.receiveTime, tpkt.transmitTime, rcvTime);
+                    }
+                    continue;
+                }
+                if (cpkt->pktType != CTRL_PKT_SYNC || cpkt->extraDataLen < sizeof(SyncPkt)) {
+                    r.otherPackets++;
+                    continue;
+                }
+                SyncPkt* spkt = (SyncPkt*)(buf + sizeof(ControlPkt));
+                if (spkt->pktType != SYNC_PKT_SYNC || spkt->fileType != SYNC_FILE_SEQ) {
+                    if (spkt->pktType == SYNC_PKT_OPEN || spkt->pktType == SYNC_PKT_START) {
+                        r.timeline.reset();
+                    }
+                    r.otherPackets++;
+                    continue;
+                }
+                if (lossPct > 0.0 && lossDist(rng) < lossPct) {
+                    r.dropped++;
+                    continue;
+                }
+                if (jitterUS) {
+                    rcvTime += jitterDist(rng);
+                }
+                r.syncPackets++;
+                ProcessSync(r, spkt, cpkt->extraDataLen, rcvTime, sameClock);
+
+                long long now = GetTimeMicros();
+                if ((now - r.lastTimeRequest) > (r.clock.getSampleCount() < MAX_CLOCK_SAMPLES ? 250000 : 2000000)) {
+                    SendTimeRequest(r, master);
+                }
+            }
+        }
+    }
+}
+
+/*
+ * CPU time (us) used so far by a local process
+ */
+static long long GetProcessCPUTime(int pid) {
+    std::string stat = GetFileContents("/proc/" + std::to_string(pid) + "/stat");
+    size_t pos = stat.rfind(')');
+    if (pos == std::string::npos) {
+        return -1;
+    }
+    std::vector<std::string> fields = split(stat.substr(pos + 2), ' ');
+    if (fields.size() < 13) {
+        return -1;
+    }
+    // utime and stime are fields 14 and 15 of /proc/PID/stat
+    long long ticks = std::stoll(fields[11]) + std::stoll(fields[12]);
+    return ticks * 1000000LL / sysconf(_SC_CLK_TCK);
+}
+
+static bool RunFPPCommand(const std::string& command, const std::vector<std::string>& args) {
+    Json::Value val;
+    val["command"] = command;
+    val["args"] = Json::Value(Json::arrayValue);
+    for (auto& a : args) {
+        val["args"].append(a);
+    }
+    std::string resp;
+    std::string url = "http://" + fppdHost + "/api/command";
+    if (!urlPost(url, SaveJsonToString(val), resp)) {
+        fprintf(stderr, "Error running '%s' on %s: %s\n", command.c_str(), fppdHost.c_str(), resp.c_str());
+        return false;
+    }
+    return true;
+}
+
+static std::string ResolveHost(const std::string& host) {
+    struct hostent* uhost = gethostbyname(host.c_str());
+    if (!uhost) {
+        return host;
+    }
+    char tmpIP[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET, uhost->h_addr, tmpIP, INET_ADDRSTRLEN);
+    return tmpIP;
+}
+
+static Json::Value Report(long long elapsed, long long masterCPU) {
+    Json::Value result;
+    result["remotes"] = (int)remotes.size();
+    result["duration"] = elapsed / 1000000.0;
+    if (fppdHost.empty()) {
+        result["syncPacketsSent"] = syncPacketsSent.load();
+    }
+    if (masterCPU >= 0) {
+        result["masterCPUPercent"] = 100.0 * masterCPU / elapsed;
+    }
+    if (fppdHost.empty() && syncPacketsSent) {
+        result["masterSendTimePerPacket"] = (double)masterSendTime / syncPacketsSent;
+    }
+
+    printf("%-16s %8s %8s %8s %10s %10s %10s\n", "Remote", "Sync", "Lost", "Dropped", "AvgErr(ms)", "P95Err(ms)", "MaxErr(ms)");
+    std::vector<long long> allErrors;
+    for (auto& r : remotes) {
+        Json::Value rv;
+        std::vector<long long> errs;
+        for (auto e : r.errors) {
+            errs.push_back(std::abs(e));
+        }
+        std::sort(errs.begin(), errs.end());
+        allErrors.insert(allErrors.end(), errs.begin(), errs.end());
+        double avg = 0;
+        for (auto e : errs) {
+            avg += e;
+        }
+        if (!errs.empty()) {
+            avg /= errs.size();
+        }
+        long long p95 = errs.empty() ? 0 : errs[errs.size() * 95 / 100];
+        long long max = errs.empty() ? 0 : errs.back();
+        int lost = 0;
+        if (fppdHost.empty()) {
+            lost = std::max(0, (int)syncPacketsSent - (int)r.syncPackets - (int)r.dropped);
+        }
+
+        printf("%-16s %8u %8d %8u %10.2f %10.2f %10.2f\n", r.address.c_str(), r.syncPackets, lost, r.dropped,
+               avg / 1000.0, p95 / 1000.0, max / 1000.0);
+
+        rv["address"] = r.address;
+        rv["syncPackets"] = r.syncPackets;
+        rv["otherPackets"] = r.otherPackets;
+        rv["lost"] = lost;
+        rv["dropped"] = r.dropped;
+        rv["avgError"] = avg;
+        rv["p95Error"] = (Json::Int64)p95;
+        rv["maxError"] = (Json::Int64)max;
+        if (r.clock.isValid()) {
+            rv["clockOffset"] = (Json::Int64)r.clock.getOffset();
+        }
+        result["remoteStats"].append(rv);
+    }
+    std::sort(allErrors.begin(), allErrors.end());
+    if (!allErrors.empty()) {
+        result["p95Error"] = (Json::Int64)allErrors[allErrors.size() * 95 / 100];
+        result["maxError"] = (Json::Int64)allErrors.back();
+        printf("\nAll remotes: P95 error %.2fms, max error %.2fms\n",
+               allErrors[allErrors.size() * 95 / 100] / 1000.0, allErrors.back() / 1000.0);
+    }
+    if (result.isMember("masterCPUPercent")) {
+        printf("Master CPU: %.2f%%\n", result["masterCPUPercent"].asDouble());
+    }
+    if (result.isMember("masterSendTimePerPacket")) {
+        printf("Master send time per sync packet: %.1fus\n", result["masterSendTimePerPacket"].asDouble());
+    }
+    return result;
+}
+
+int main(int argc, char* argv[]) {
+    parseArguments(argc, argv);
+
+    if (!fppdHost.empty() && playlist.empty()) {
+        fprintf(stderr, "A playlist (-p) is required when driving an fppd master\n");
+        exit(EXIT_FAILURE);
+    }
+
+    in_addr_t base = ntohl(inet_addr(remoteBase.c_str()));
+    for (int x = 0; x < remoteCount; x++) {
+        struct in_addr a;
+        a.s_addr = htonl(base + x);
+        VirtualRemote r;
+        r.address = inet_ntoa(a);
+        r.sock = OpenSocket(r.address, joinMulticast);
+        if (r.sock < 0) {
+            exit(EXIT_FAILURE);
+        }
+        remotes.push_back(r);
+    }
+
+    std::string master = fppdHost.empty() ? masterAddress : ResolveHost(fppdHost);
+    bool sameClock = fppdHost.empty() || master.rfind("127.", 0) == 0;
+    int masterSock = -1;
+    if (fppdHost.empty()) {
+        masterSock = OpenSocket(masterAddress, false);
+        if (masterSock < 0) {
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    printf("Simulating %d remotes starting at %s for %d seconds\n", remoteCount, remoteBase.c_str(), duration);
+
+    std::thread remoteThread(RunRemotes, master, sameClock);
+    std::thread masterThread;
+    long long startCPU = masterPid ? GetProcessCPUTime(masterPid) : -1;
+    long long startTime = GetTimeMicros();
+    if (fppdHost.empty()) {
+        masterThread = std::thread(RunMaster, masterSock, std::string("fppsyncsim.fseq"));
+    } else if (!RunFPPCommand("Start Playlist", { playlist })) {
+        running = false;
+    }
+
+    while (running && (GetTimeMicros() - startTime) < (duration * 1000000LL)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    running = false;
+    if (masterThread.joinable()) {
+        masterThread.join();
+    }
+    remoteThread.join();
+    long long elapsed = GetTimeMicros() - startTime;
+
+    if (!fppdHost.empty()) {
+        RunFPPCommand("Stop Now", {});
+    }
+
+    long long masterCPU = -1;
+    if (fppdHost.empty()) {
+        masterCPU = masterCPUTime;
+    } else if (startCPU >= 0) {
+        long long endCPU = GetProcessCPUTime(masterPid);
+        if (endCPU >= 0) {
+            masterCPU = endCPU - startCPU;
+        }
+    }
+
+    Json::Value result = Report(elapsed, masterCPU);
+    if (!jsonFile.empty()) {
+        SaveJsonToFile(result, jsonFile);
+    }
+
+    for (auto& r : remotes) {
+        close(r.sock);
+    }
+    if (masterSock >= 0) {
+        close(masterSock);
+    }
+    exit(EXIT_SUCCESS);
+}
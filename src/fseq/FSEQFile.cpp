@@ -209,31 +209,42 @@ static const int V1ESEQ_HEADER_IDENTIFIER = 'E';
 static const int V1ESEQ_CHANNEL_DATA_OFFSET = 20;
 static const int V1ESEQ_STEP_TIME = 50;
 
-FSEQFile* FSEQFile::openFSEQFile(const std::string& fn) {
-    FILE* seqFile = fopen((const char*)fn.c_str(), "rb");
-    if (seqFile == NULL) {
-        LogErr(VB_SEQUENCE, "Error pre-reading FSEQ file (%s), fopen returned NULL\n", fn.c_str());
-        return nullptr;
-    }
-
-    fseeko(seqFile, 0L, SEEK_SET);
+// Reads the header from either the file or the source and creates the
+// version specific reader.  On failure the file/source is closed.
+static FSEQFile* openFSEQReader(const std::string& fn, FILE* seqFile, FSEQFileSource* source) {
+    auto readAt = [seqFile, source](uint64_t pos, void* ptr, uint64_t size) -> uint64_t {
+        if (source) {
+            return source->read(pos, ptr, size);
+        }
+        fseeko(seqFile, pos, SEEK_SET);
+        return fread(ptr, 1, size, seqFile);
+    };
+    auto closeInput = [seqFile, source]() {
+        if (source) {
+            delete source;
+        } else {
+            fclose(seqFile);
+        }
+    };
 
     // An initial read request of 8 bytes covers the file identifier, version fields and channel data offset
     // This is the minimum needed to validate the file and prepare the proper sized buffer for a larger read
     static const int initialReadLen = 8;
 
     unsigned char headerPeek[initialReadLen];
-    int bytesRead = fread(headerPeek, 1, initialReadLen, seqFile);
+    int bytesRead = readAt(0, headerPeek, initialReadLen);
 #ifndef PLATFORM_UNKNOWN
-    posix_fadvise(fileno(seqFile), 0, 0, POSIX_FADV_SEQUENTIAL);
-    posix_fadvise(fileno(seqFile), 0, 1024 * 1024, POSIX_FADV_WILLNEED);
+    if (seqFile) {
+        posix_fadvise(fileno(seqFile), 0, 0, POSIX_FADV_SEQUENTIAL);
+        posix_fadvise(fileno(seqFile), 0, 1024 * 1024, POSIX_FADV_WILLNEED);
+    }
 #endif
 
     // Validate bytesRead covers at least the initial read length
     if (bytesRead < initialReadLen) {
         LogErr(VB_SEQUENCE, "Error pre-reading FSEQ file (%s) header, required %d bytes but read %d\n", fn.c_str(), initialReadLen, bytesRead);
         DumpHeader("File hader peek:", headerPeek, bytesRead);
-        fclose(seqFile);
+        closeInput();
         return nullptr;
     }
 
@@ -241,7 +252,7 @@ FSEQFile* FSEQFile::openFSEQFile(const std::string& fn) {
     if ((headerPeek[0] != 'P' && headerPeek[0] != 'F' && headerPeek[0] != V1ESEQ_HEADER_IDENTIFIER) || headerPeek[1] != 'S' || headerPeek[2] != 'E' || headerPeek[3] != 'Q') {
         LogErr(VB_SEQUENCE, "Error pre-reading FSEQ file (%s) header, invalid identifier\n", fn.c_str());
         DumpHeader("File header peek:", headerPeek, bytesRead);
-        fclose(seqFile);
+        closeInput();
         return nullptr;
     }
 
@@ -259,33 +270,45 @@ FSEQFile* FSEQFile::openFSEQFile(const std::string& fn) {
 
     // Read the full header size (beginning at 0 and ending at seqChanDataOffset)
     std::vector<uint8_t> header(seqChanDataOffset);
-    fseeko(seqFile, 0L, SEEK_SET);
-    bytesRead = fread(&header[0], 1, seqChanDataOffset, seqFile);
+    bytesRead = readAt(0, &header[0], seqChanDataOffset);
 
     if (bytesRead != seqChanDataOffset) {
         LogErr(VB_SEQUENCE, "Error reading FSEQ file (%s) header, length is %d bytes but read %d\n", fn.c_str(), seqChanDataOffset, bytesRead);
         DumpHeader("File header:", &header[0], bytesRead);
-        fclose(seqFile);
+        closeInput();
         return nullptr;
     }
 
     // Validate the major version is supported
     // Return a file wrapper to handle version specific metadata
     FSEQFile* file = nullptr;
-    if (seqVersionMajor == V1FSEQ_MAJOR_VERSION) {
+    if (seqVersionMajor == V1FSEQ_MAJOR_VERSION && !source) {
         file = new V1FSEQFile(fn, seqFile, header);
     } else if (seqVersionMajor == V2FSEQ_MAJOR_VERSION) {
-        file = new V2FSEQFile(fn, seqFile, header);
+        file = new V2FSEQFile(fn, seqFile, header, source);
     } else {
         LogErr(VB_SEQUENCE, "Error opening FSEQ file (%s), unknown version %d.%d\n", fn.c_str(), seqVersionMajor, seqVersionMinor);
         DumpHeader("File header:", &header[0], bytesRead);
-        fclose(seqFile);
+        closeInput();
         return nullptr;
     }
 
     file->dumpInfo();
     return file;
 }
+FSEQFile* FSEQFile::openFSEQFile(const std::string& fn) {
+    FILE* seqFile = fopen((const char*)fn.c_str(), "rb");
+    if (seqFile == NULL) {
+        LogErr(VB_SEQUENCE, "Error pre-reading FSEQ file (%s), fopen returned NULL\n", fn.c_str());
+        return nullptr;
+    }
+
+    fseeko(seqFile, 0L, SEEK_SET);
+    return openFSEQReader(fn, seqFile, nullptr);
+}
+FSEQFile* FSEQFile::openFSEQFile(const std::string& fn, FSEQFileSource* source) {
+    return openFSEQReader(fn, nullptr, source);
+}
 FSEQFile* FSEQFile::createFSEQFile(const std::string& fn,
                                    int version,
                                    CompressionType ct,
@@ -338,6 +361,7 @@ FSEQFile::FSEQFile(const std::string& fn) :
     m_seqFileSize(0),
     m_memoryBuffer(),
     m_seqChanDataOffset(0),
+    m_source(nullptr),
     m_memoryBufferPos(0) {
     if (fn == "-memory-") {
         m_seqFile = nullptr;
@@ -378,15 +402,20 @@ void FSEQFile::initializeFromFSEQ(const FSEQFile& fseq) {
     }
 }
 
-FSEQFile::FSEQFile(const std::string& fn, FILE* file, const std::vector<uint8_t>& header) :
+FSEQFile::FSEQFile(const std::string& fn, FILE* file, const std::vector<uint8_t>& header, FSEQFileSource* source) :
     m_filename(fn),
     m_seqFile(file),
+    m_source(source),
     m_uniqueId(0),
     m_memoryBuffer(),
     m_memoryBufferPos(0) {
-    fseeko(m_seqFile, 0L, SEEK_END);
-    m_seqFileSize = ftello(m_seqFile);
-    fseeko(m_seqFile, 0L, SEEK_SET);
+    if (m_source) {
+        m_seqFileSize = m_source->size();
+    } else {
+        fseeko(m_seqFile, 0L, SEEK_END);
+        m_seqFileSize = ftello(m_seqFile);
+        fseeko(m_seqFile, 0L, SEEK_SET);
+    }
 
     if (header[0] == V1ESEQ_HEADER_IDENTIFIER) {
         m_seqChanDataOffset = V1ESEQ_CHANNEL_DATA_OFFSET;
@@ -408,11 +437,16 @@ FSEQFile::~FSEQFile() {
     if (m_seqFile) {
         fclose(m_seqFile);
     }
+    if (m_source) {
+        delete m_source;
+    }
 }
 
 int FSEQFile::seek(uint64_t location, int origin) {
     if (m_seqFile) {
         return fseeko(m_seqFile, location, origin);
+    } else if (m_source && origin == SEEK_END) {
+        m_memoryBufferPos = m_seqFileSize + location;
     } else if (origin == SEEK_SET) {
         m_memoryBufferPos = location;
     } else if (origin == SEEK_CUR) {
@@ -443,10 +477,19 @@ uint64_t FSEQFile::write(const void* ptr, uint64_t size) {
 }
 
 uint64_t FSEQFile::read(void* ptr, uint64_t size) {
+    if (m_source) {
+        uint64_t r = m_source->read(m_memoryBufferPos, ptr, size);
+        m_memoryBufferPos += r;
+        return r;
+    }
     return fread(ptr, 1, size, m_seqFile);
 }
 
 void FSEQFile::preload(uint64_t pos, uint64_t size) {
+    if (m_source) {
+        m_source->preload(pos, size);
+        return;
+    }
 #ifndef PLATFORM_UNKNOWN
     if (posix_fadvise(fileno(m_seqFile), pos, size, POSIX_FADV_WILLNEED) != 0) {
         LogErr(VB_SEQUENCE, "Could not advise kernel %d  size: %d\n", (int)pos, (int)size);
@@ -1690,8 +1733,8 @@ void V2FSEQFile::writeHeader() {
     dumpInfo(true);
 }
 
-V2FSEQFile::V2FSEQFile(const std::string& fn, FILE* file, const std::vector<uint8_t>& header) :
-    FSEQFile(fn, file, header),
+V2FSEQFile::V2FSEQFile(const std::string& fn, FILE* file, const std::vector<uint8_t>& header, FSEQFileSource* source) :
+    FSEQFile(fn, file, header, source),
     m_compressionType(none),
     m_handler(nullptr) {
     if (m_seqVersionMajor == 2 && m_seqVersionMinor > 2) {
@@ -1896,6 +1939,14 @@ void V2FSEQFile::finalize() {
     if (m_handler != nullptr) {
         m_handler->finalize();
     }
+    // the frame count may have been updated after the header was written
+    // (recording of unknown length), make sure the header matches
+    uint64_t end = tell();
+    uint8_t buf[4];
+    write4ByteUInt(buf, m_seqNumFrames);
+    seek(14, SEEK_SET);
+    write(buf, 4);
+    seek(end, SEEK_SET);
     FSEQFile::finalize();
 }
 
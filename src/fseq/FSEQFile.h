@@ -4,6 +4,18 @@
 #include <string>
 #include <vector>
 
+// Supplies the contents of a sequence that is not being read from a local
+// file (such as one being fetched from another system)
+class FSEQFileSource {
+public:
+    virtual ~FSEQFileSource() {}
+
+    virtual uint64_t size() = 0;
+    virtual uint64_t read(uint64_t pos, void *ptr, uint64_t size) = 0;
+    // hint that the range will be read soon
+    virtual void preload(uint64_t pos, uint64_t size) {}
+};
+
 class FSEQFile {
 public:
     class VariableHeader {
@@ -41,7 +53,7 @@ public:
 
 protected:
     //open file for reading
-    FSEQFile(const std::string &fn, FILE *file, const std::vector<uint8_t> &header);
+    FSEQFile(const std::string &fn, FILE *file, const std::vector<uint8_t> &header, FSEQFileSource *source = nullptr);
     //open file for writing
     FSEQFile(const std::string &fn);
 
@@ -50,6 +62,8 @@ public:
     virtual ~FSEQFile();
 
     static FSEQFile* openFSEQFile(const std::string &fn);
+    //open a V2 sequence read from the source, the FSEQFile takes ownership of the source
+    static FSEQFile* openFSEQFile(const std::string &fn, FSEQFileSource *source);
 
     static FSEQFile* createFSEQFile(const std::string &fn,
                                     int version,
@@ -127,6 +141,7 @@ protected:
 
 private:
     FILE* volatile  m_seqFile;
+    FSEQFileSource* m_source;
     std::vector<uint8_t> m_memoryBuffer;
     uint64_t      m_memoryBufferPos;
 };
@@ -161,7 +176,7 @@ class V2Handler;
 class V2FSEQFile : public FSEQFile {
 
 public:
-    V2FSEQFile(const std::string &fn, FILE *file, const std::vector<uint8_t> &header);
+    V2FSEQFile(const std::string &fn, FILE *file, const std::vector<uint8_t> &header, FSEQFileSource *source = nullptr);
     V2FSEQFile(const std::string &fn, CompressionType ct, int cl);
 
     virtual ~V2FSEQFile();
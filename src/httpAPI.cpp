@@ -46,6 +46,7 @@
 #include "log.h"
 #include "mqtt.h"
 #include "settings.h"
+#include "channeloutput/ChannelOutputSetup.h"
 #include "channeloutput/channeloutputthread.h"
 #include "channeltester/ChannelTester.h"
 #include "commands/Commands.h"
@@ -373,6 +374,8 @@ HTTP_RESPONSE_CONST std::shared_ptr<httpserver::http_response> PlayerResource::r
             reset = true;
 
         GetMultiSyncStats(result, reset);
+    } else if (url == "outputStats") {
+        GetOutputStats(result);
     } else if (url == "playlists") {
         GetCurrentPlaylists(result);
     } else if (url == "playlist/filetime") {
@@ -744,6 +747,15 @@ void PlayerResource::GetMultiSyncStats(Json::Value& result, bool reset) {
         SetErrorResult(result, 400, "MultiSync did not return any systems.");
 }
 
+/*
+ *
+ */
+void PlayerResource::GetOutputStats(Json::Value& result) {
+    GetChannelOutputStats(result); // ChannelOutputSetup.cpp
+
+    SetOKResult(result, "");
+}
+
 /*
  *
  */
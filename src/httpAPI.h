@@ -39,6 +39,7 @@ private:
     void GetE131BytesReceived(Json::Value& result);
     void GetMultiSyncSystems(Json::Value& result, bool localOnly = false);
     void GetMultiSyncStats(Json::Value& result, bool reset = false);
+    void GetOutputStats(Json::Value& result);
     void GetPlaylistFileTime(Json::Value& result);
     void GetPlaylistConfig(Json::Value& result);
 
@@ -38,6 +38,7 @@ OBJECTS_fpp_so += \
     commands/MediaCommands.o \
 	common.o \
 	common_mini.o \
+	BridgeRecorder.o \
 	CurlManager.o \
 	e131bridge.o \
 	effects.o \
@@ -52,10 +53,13 @@ OBJECTS_fpp_so += \
 	fseq/FSEQFile.o \
 	gpio.o \
 	httpAPI.o \
+	HTTPFSEQSource.o \
 	log.o \
 	FPPLocale.o \
+	MasterClock.o \
 	MultiSync.o \
 	mediadetails.o \
+	mediaoutput/AudioAnalysis.o \
 	mediaoutput/MediaOutputBase.o \
 	mediaoutput/mediaoutput.o \
 	mediaoutput/SDLOut.o \
@@ -71,6 +75,7 @@ OBJECTS_fpp_so += \
 	overlays/PixelOverlayModel.o \
 	overlays/PixelOverlayModelFB.o \
 	overlays/PixelOverlayModelSub.o \
+	overlays/PixelOverlayText.o \
     overlays/WLEDEffects.o \
     overlays/wled/colors.o \
     overlays/wled/FX.o \
@@ -108,6 +113,7 @@ OBJECTS_fpp_so += \
 	sensors/Sensors.o \
 	sensors/ADS7828.o \
 	Sequence.o \
+	SequenceStream.o \
 	settings.o \
 	SunRise.o \
 	Timers.o \
@@ -167,7 +173,7 @@ libfpp.$(SHLIB_EXT): $(OBJECTS_fpp_so) $(DEPS_fpp_so)
 CXXFLAGS_overlays/wled/FX.o+=-Wno-deprecated-declarations
 CXXFLAGS_overlays/wled/FX_fcn.o+=-Wno-deprecated-declarations -Wno-format -Wno-tautological-constant-out-of-range-compare
 CXXFLAGS_overlays/PixelOverlay.o+=$(MAGICK_INCLUDE_PATH)
-CXXFLAGS_overlays/PixelOverlayEffects.o+=$(MAGICK_INCLUDE_PATH)
 CXXFLAGS_overlays/PixelOverlayModel.o+=$(MAGICK_INCLUDE_PATH)
+CXXFLAGS_overlays/PixelOverlayText.o+=$(MAGICK_INCLUDE_PATH)
 CXXFLAGS_playlist/PlaylistEntryImage.o+=$(MAGICK_INCLUDE_PATH)
 CXXFLAGS_channeloutput/VirtualDisplayBase.o+=$(MAGICK_INCLUDE_PATH)
@@ -0,0 +1,16 @@
+OBJECTS_fppsyncsim = \
+	common.o common_mini.o \
+	log.o \
+	MasterClock.o \
+	fppsyncsim.o \
+	fppversion.o
+LIBS_fppsyncsim = \
+	-lcurl \
+	-ljsoncpp
+
+TARGETS += fppsyncsim
+OBJECTS_ALL+=$(OBJECTS_fppsyncsim)
+
+fppsyncsim: $(OBJECTS_fppsyncsim)
+	$(CCACHE) $(CC) $(CFLAGS_$@) $(OBJECTS_$@) $(LIBS_$@) $(LDFLAGS) $(LDFLAGS_$@) -o $@
+
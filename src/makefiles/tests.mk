@@ -0,0 +1,14 @@
+# Standalone checks, build and run with "make tests"
+TESTS = tests/UDPPacerTest
+
+OBJECTS_ALL += $(addsuffix .o,$(TESTS))
+
+tests/%Test: tests/%Test.o
+	$(CCACHE) $(CC) $(CFLAGS_$@) $< $(LDFLAGS) -o $@
+
+.PHONY: tests
+tests: $(TESTS)
+	@for t in $(TESTS); do ./$$t || exit 1; done
+
+clean::
+	rm -f $(TESTS) $(addsuffix .o,$(TESTS))
@@ -0,0 +1,326 @@
+/*
+ * This file is part of the Falcon Player (FPP) and is Copyright (C)
+ * 2013-2022 by the Falcon Player Developers.
+ *
+ * The Falcon Player (FPP) is free software, and is covered under
+ * multiple Open Source licenses.  Please see the included 'LICENSES'
+ * file for descriptions of what files are covered by each license.
+ *
+ * This source file is covered under the LGPL v2.1 as described in the
+ * included LICENSE.LGPL file.
+ */
+
+#include "fpp-pch.h"
+
+#include <SDL2/SDL.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <thread>
+
+#include "../common.h"
+#include "../log.h"
+#include "../settings.h"
+#include "../overlays/wled/kiss_fftr.h"
+
+#include "SDLOut.h"
+
+#include "AudioAnalysis.h"
+
+// minimum time between beats
+#define BEAT_HOLDOFF_MS 150
+
+AudioAnalysis AudioAnalysis::INSTANCE;
+
+AudioAnalysis::AudioAnalysis() :
+    writePos(0),
+    sampleRate(0),
+    frame(0),
+    testSourceActive(false),
+    testSourceRunning(false) {
+    // calloc'd so pages are only committed once audio is actually played
+    ring = (float*)calloc(RING_SIZE, sizeof(float));
+    fftConfig = kiss_fftr_alloc(AUDIO_ANALYSIS_FFT_SIZE, false, 0, 0);
+
+    // Hann window, scaled by 2 so a sine keeps the magnitude it had
+    // without the window
+    window.resize(AUDIO_ANALYSIS_FFT_SIZE);
+    for (int x = 0; x < AUDIO_ANALYSIS_FFT_SIZE; x++) {
+        window[x] = 1.0f - cosf(2.0f * M_PI * x / (AUDIO_ANALYSIS_FFT_SIZE - 1));
+    }
+    result.frame = (uint64_t)-1;
+}
+AudioAnalysis::~AudioAnalysis() {
+    stopTestSource();
+    kiss_fftr_free(fftConfig);
+    free(ring);
+}
+
+void AudioAnalysis::pushSamples(const float* samples, int count, int rate) {
+    uint64_t pos = writePos.load(std::memory_order_relaxed);
+    for (int x = 0; x < count; x++) {
+        ring[(pos + x) & (RING_SIZE - 1)] = samples[x];
+    }
+    sampleRate.store(rate, std::memory_order_relaxed);
+    writePos.store(pos + count, std::memory_order_release);
+}
+
+void AudioAnalysis::addPlaybackSamples(const uint8_t* data, int bytes, int bytesPerSample, bool isFloat, int channels, int rate) {
+    if (testSourceActive) {
+        return;
+    }
+    int count = bytes / (bytesPerSample * channels);
+    uint64_t pos = writePos.load(std::memory_order_relaxed);
+    if (bytesPerSample == 2) {
+        const int16_t* ds = (const int16_t*)data;
+        for (int x = 0; x < count; x++) {
+            ring[(pos + x) & (RING_SIZE - 1)] = ds[x * channels] / 32768.0f;
+        }
+    } else if (isFloat) {
+        const float* ds = (const float*)data;
+        for (int x = 0; x < count; x++) {
+            ring[(pos + x) & (RING_SIZE - 1)] = ds[x * channels];
+        }
+    } else {
+        const int32_t* ds = (const int32_t*)data;
+        for (int x = 0; x < count; x++) {
+            ring[(pos + x) & (RING_SIZE - 1)] = ds[x * channels] / 2147483648.0f;
+        }
+    }
+    sampleRate.store(rate, std::memory_order_relaxed);
+    writePos.store(pos + count, std::memory_order_release);
+}
+
+bool AudioAnalysis::readWindow(float* samples, int numSamples, int& rate) {
+    uint64_t end = writePos.load(std::memory_order_acquire);
+    if (end < (uint64_t)numSamples) {
+        return false;
+    }
+    uint64_t start = end - numSamples;
+    if (!testSourceActive) {
+        // media is queued well ahead of what is playing, start at
+        // whatever SDL will play next
+        int queued = SDLOutput::GetQueuedAudioFrames();
+        if (queued < 0) {
+            return false;
+        }
+        start = std::min(start, end - std::min((uint64_t)queued, end));
+    }
+    if (end - start > RING_SIZE) {
+        return false;
+    }
+    for (int x = 0; x < numSamples; x++) {
+        samples[x] = ring[(start + x) & (RING_SIZE - 1)];
+    }
+    // make sure the producer didn't wrap around onto what was copied
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (writePos.load(std::memory_order_relaxed) - start > RING_SIZE) {
+        return false;
+    }
+    rate = sampleRate.load(std::memory_order_relaxed);
+    return rate > 0;
+}
+
+bool AudioAnalysis::getSamples(float* samples, int numSamples, int& rate) {
+    {
+        std::unique_lock<std::mutex> l(lock);
+        startTestSource();
+    }
+    return readWindow(samples, numSamples, rate);
+}
+
+AudioAnalysisResult AudioAnalysis::getResult() {
+    std::unique_lock<std::mutex> l(lock);
+    startTestSource();
+    uint64_t f = frame.load(std::memory_order_relaxed);
+    if (result.frame != f) {
+        result.frame = f;
+        analyze(result);
+    }
+    return result;
+}
+
+void AudioAnalysis::analyze(AudioAnalysisResult& r) {
+    float samples[AUDIO_ANALYSIS_FFT_SIZE];
+    r.valid = readWindow(samples, AUDIO_ANALYSIS_FFT_SIZE, r.sampleRate);
+    if (!r.valid) {
+        return;
+    }
+
+    float sum = 0;
+    float peak = 0;
+    for (int x = 0; x < AUDIO_ANALYSIS_FFT_SIZE; x++) {
+        sum += samples[x] * samples[x];
+        peak = std::max(peak, fabsf(samples[x]));
+        samples[x] *= window[x];
+    }
+    r.volume = sqrtf(sum / AUDIO_ANALYSIS_FFT_SIZE);
+    r.samplePeak = peak;
+
+    kiss_fft_cpx fftOut[AUDIO_ANALYSIS_FFT_SIZE / 2 + 1];
+    kiss_fftr((kiss_fftr_cfg)fftConfig, samples, fftOut);
+
+    // bands are split at every 8th midi note starting at note 16 (~20Hz)
+    float res[AUDIO_ANALYSIS_BANDS] = { 0 };
+    float rate = r.sampleRate;
+    float binHzRange = rate / AUDIO_ANALYSIS_FFT_SIZE;
+    int curBucket = 0;
+    int end = 440.0 * exp2f(((float)((curBucket + 1) * 8) - 69.0) / 12.0) * AUDIO_ANALYSIS_FFT_SIZE / rate;
+    float maxValue = 0;
+    int maxBin = 0;
+    int maxBucket = 0;
+    for (int bin = 0; bin < (AUDIO_ANALYSIS_FFT_SIZE / 2); ++bin) {
+        if (bin > end) {
+            curBucket++;
+            if (curBucket == AUDIO_ANALYSIS_BANDS) {
+                break;
+            }
+            end = 440.0 * exp2f(((float)((curBucket + 1) * 8) - 69.0) / 12.0) * AUDIO_ANALYSIS_FFT_SIZE / rate;
+        }
+        float nv = sqrtf(fftOut[bin].r * fftOut[bin].r + fftOut[bin].i * fftOut[bin].i);
+        if (nv > maxValue) {
+            maxValue = nv;
+            maxBin = bin;
+            maxBucket = curBucket;
+        }
+        res[curBucket] = std::max(res[curBucket], nv);
+    }
+
+    int maxV = 0;
+    float maxRV = 0;
+    for (int x = 0; x < AUDIO_ANALYSIS_BANDS; x++) {
+        int v = std::clamp((int)round(log10f(res[x]) * 120.0f), 0, 255);
+        maxV = std::max(maxV, v);
+        maxRV = std::max(maxRV, res[x]);
+        r.bands[x] = v;
+    }
+    r.maxBand = maxV;
+    r.peakFrequency = (maxBin * binHzRange) + (binHzRange / 2);
+    r.peakMagnitude = maxRV;
+    r.peakBand = maxBucket;
+
+    // a beat is bass energy well above its recent average
+    float bass = res[0] + res[1] + res[2] + res[3];
+    uint64_t now = GetTimeMS();
+    r.beat = bass > bassAverage * 1.5f && r.volume > 0.01f && (now - lastBeatMS) > BEAT_HOLDOFF_MS;
+    if (r.beat) {
+        lastBeatMS = now;
+    }
+    bassAverage = bassAverage * 0.95f + bass * 0.05f;
+}
+
+void AudioAnalysis::startTestSource() {
+    if (testSourceChecked) {
+        return;
+    }
+    testSourceChecked = true;
+
+    std::string src = getSetting("AudioAnalysisSource");
+    if (src.empty()) {
+        return;
+    }
+    if (SDL_InitSubSystem(SDL_INIT_AUDIO) < 0) {
+        LogErr(VB_MEDIAOUT, "Could not initialize SDL audio for audio analysis source: %s\n", SDL_GetError());
+        return;
+    }
+    if (startsWith(src, "capture:")) {
+        std::string dev = src.substr(8);
+        std::string devName;
+        int cnt = SDL_GetNumAudioDevices(1);
+        for (int x = 0; x < cnt; x++) {
+            std::string dn = SDL_GetAudioDeviceName(x, 1);
+            if (startsWith(dn, dev)) {
+                devName = dn;
+                break;
+            }
+        }
+        SDL_AudioSpec want, have;
+        memset(&want, 0, sizeof(want));
+        want.freq = 44100;
+        want.format = AUDIO_F32SYS;
+        want.channels = 1;
+        want.samples = 512;
+        want.callback = captureCallback;
+        want.userdata = this;
+        captureDevice = SDL_OpenAudioDevice(devName.empty() ? nullptr : devName.c_str(), 1, &want, &have, SDL_AUDIO_ALLOW_FREQUENCY_CHANGE);
+        if (captureDevice == 0) {
+            LogErr(VB_MEDIAOUT, "Could not open audio capture device '%s': %s\n", dev.c_str(), SDL_GetError());
+            return;
+        }
+        captureRate = have.freq;
+        testSourceActive = true;
+        SDL_PauseAudioDevice(captureDevice, 0);
+        LogInfo(VB_MEDIAOUT, "Analyzing audio captured from '%s'\n", devName.empty() ? "default device" : devName.c_str());
+        return;
+    }
+
+    SDL_AudioSpec spec;
+    uint8_t* buf = nullptr;
+    uint32_t len = 0;
+    if (!SDL_LoadWAV(src.c_str(), &spec, &buf, &len)) {
+        LogErr(VB_MEDIAOUT, "Could not load audio analysis source '%s': %s\n", src.c_str(), SDL_GetError());
+        return;
+    }
+    SDL_AudioCVT cvt;
+    SDL_BuildAudioCVT(&cvt, spec.format, spec.channels, spec.freq, AUDIO_F32SYS, 1, spec.freq);
+    std::vector<uint8_t> converted(len * cvt.len_mult);
+    memcpy(&converted[0], buf, len);
+    SDL_FreeWAV(buf);
+    cvt.buf = &converted[0];
+    cvt.len = len;
+    if (cvt.needed) {
+        SDL_ConvertAudio(&cvt);
+    } else {
+        cvt.len_cvt = len;
+    }
+    std::vector<float> samples(cvt.len_cvt / sizeof(float));
+    if (samples.empty()) {
+        return;
+    }
+    memcpy(&samples[0], &converted[0], samples.size() * sizeof(float));
+
+    testSourceActive = true;
+    testSourceRunning = true;
+    testSourceThread = new std::thread(&AudioAnalysis::runWAVSource, this, std::move(samples), spec.freq);
+    LogInfo(VB_MEDIAOUT, "Analyzing audio from '%s'\n", src.c_str());
+}
+
+void AudioAnalysis::stopTestSource() {
+    if (captureDevice) {
+        SDL_CloseAudioDevice(captureDevice);
+        captureDevice = 0;
+    }
+    if (testSourceThread) {
+        testSourceRunning = false;
+        testSourceThread->join();
+        delete testSourceThread;
+        testSourceThread = nullptr;
+    }
+}
+
+void AudioAnalysis::captureCallback(void* userdata, uint8_t* stream, int len) {
+    AudioAnalysis* a = (AudioAnalysis*)userdata;
+    a->pushSamples((const float*)stream, len / sizeof(float), a->captureRate);
+}
+
+// Loops the file in real time, 10ms at a time
+void AudioAnalysis::runWAVSource(std::vector<float> samples, int rate) {
+    SetThreadName("FPP-AudioSource");
+    int chunk = rate / 100;
+    size_t pos = 0;
+    auto next = std::chrono::steady_clock::now();
+    while (testSourceRunning) {
+        int count = std::min((size_t)chunk, samples.size() - pos);
+        pushSamples(&samples[pos], count, rate);
+        pos += count;
+        if (pos >= samples.size()) {
+            pos = 0;
+        }
+        next += std::chrono::microseconds(count * 1000000LL / rate);
+        std::this_thread::sleep_until(next);
+    }
+}
@@ -0,0 +1,99 @@
+#pragma once
+/*
+ * This file is part of the Falcon Player (FPP) and is Copyright (C)
+ * 2013-2022 by the Falcon Player Developers.
+ *
+ * The Falcon Player (FPP) is free software, and is covered under
+ * multiple Open Source licenses.  Please see the included 'LICENSES'
+ * file for descriptions of what files are covered by each license.
+ *
+ * This source file is covered under the LGPL v2.1 as described in the
+ * included LICENSE.LGPL file.
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define AUDIO_ANALYSIS_FFT_SIZE 1024
+#define AUDIO_ANALYSIS_BANDS 16
+
+class AudioAnalysisResult {
+public:
+    bool valid = false; // false if there is no audio to analyze
+    uint64_t frame = 0; // output frame the analysis was done for
+    int sampleRate = 0;
+
+    uint8_t bands[AUDIO_ANALYSIS_BANDS] = { 0 }; // log scaled energy, 0-255
+    uint8_t maxBand = 0;                         // max of bands
+    float peakFrequency = 0;                     // frequency of the loudest FFT bin
+    float peakMagnitude = 0;
+    int peakBand = 0; // band containing peakFrequency
+
+    float volume = 0;     // RMS of the window, 0-1
+    float samplePeak = 0; // max absolute sample in the window, 0-1
+    bool beat = false;    // onset of bass energy
+};
+
+// Analyzes the audio that is currently playing once per output frame so
+// any number of audio reactive effects and plugins can share the result.
+//
+// Samples are added to a lock free single producer ring as they are
+// queued to SDL, the playback position is found from what SDL still has
+// queued.  For testing, the AudioAnalysisSource setting can instead loop
+// a WAV file or record from an SDL capture device such as an ALSA
+// loopback.
+class AudioAnalysis {
+public:
+    static AudioAnalysis INSTANCE;
+
+    // Called by the media output with interleaved audio as it is queued
+    // for playback, only the first channel is analyzed.  Never blocks.
+    void addPlaybackSamples(const uint8_t* data, int bytes, int bytesPerSample, bool isFloat, int channels, int sampleRate);
+
+    // Called by the output thread before the overlays of each frame
+    void nextFrame() { frame.fetch_add(1, std::memory_order_relaxed); }
+
+    // The analysis for the current output frame.  The first caller in a
+    // frame runs the FFT, everyone else gets a copy of its result.
+    AudioAnalysisResult getResult();
+
+    // Copies the mono samples at the playback position
+    bool getSamples(float* samples, int numSamples, int& sampleRate);
+
+private:
+    AudioAnalysis();
+    ~AudioAnalysis();
+
+    void pushSamples(const float* samples, int count, int rate);
+    bool readWindow(float* samples, int numSamples, int& rate);
+    void analyze(AudioAnalysisResult& r);
+
+    void startTestSource();
+    void stopTestSource();
+    void runWAVSource(std::vector<float> samples, int rate);
+    static void captureCallback(void* userdata, uint8_t* stream, int len);
+
+    static constexpr uint64_t RING_SIZE = 1 << 20;
+    float* ring = nullptr;
+    std::atomic<uint64_t> writePos;
+    std::atomic<int> sampleRate;
+    std::atomic<uint64_t> frame;
+
+    std::mutex lock;
+    AudioAnalysisResult result;
+    void* fftConfig = nullptr;
+    std::vector<float> window;
+    float bassAverage = 0;
+    uint64_t lastBeatMS = 0;
+
+    bool testSourceChecked = false;
+    std::atomic<bool> testSourceActive;
+    std::atomic<bool> testSourceRunning;
+    std::thread* testSourceThread = nullptr;
+    uint32_t captureDevice = 0;
+    int captureRate = 0;
+};
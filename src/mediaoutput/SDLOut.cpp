@@ -37,6 +37,7 @@ extern "C" {
 #include "../overlays/PixelOverlay.h"
 #include "../overlays/PixelOverlayModel.h"
 
+#include "AudioAnalysis.h"
 #include "SDLOut.h"
 
 // Only keep 30 frames in buffer
@@ -103,9 +104,6 @@ public:
         minQueueSize = rate * bps * 2 * ch; // 2 seconds of 2 channel audio
         maxQueueSize = minQueueSize * ch;
         outBuffer = new uint8_t[maxQueueSize];
-
-        sampleBuffer = new uint8_t[maxQueueSize * 2];
-        sampleBufferCount = 0;
     }
     ~SDLInternalData() {
         if (frame != nullptr) {
@@ -143,7 +141,6 @@ public:
             swr_free(&au_convert_ctx);
         }
 
-        delete[] sampleBuffer;
         delete[] outBuffer;
     }
 
@@ -170,9 +167,6 @@ public:
     int minQueueSize;
     int maxQueueSize;
 
-    uint8_t* sampleBuffer;
-    int sampleBufferCount;
-
     // stuff for the video stream
     AVCodecContext* videoCodecContext;
     int video_stream_idx = -1;
@@ -237,13 +231,7 @@ public:
             curPosLock.lock();
             SDL_QueueAudio(audioDev, outBuffer, outBufferPos);
             queue = SDL_GetQueuedAudioSize(audioDev);
-            int ms = queue - outBufferPos;
-            if (ms < sampleBufferCount) {
-                memmove(sampleBuffer, &sampleBuffer[sampleBufferCount - ms], ms);
-                sampleBufferCount = ms;
-            }
-            memcpy(&sampleBuffer[sampleBufferCount], outBuffer, outBufferPos);
-            sampleBufferCount += outBufferPos;
+            AudioAnalysis::INSTANCE.addPlaybackSamples(outBuffer, outBufferPos, bytesPerSample, isSamplesFloat, channels, currentRate);
 
             curPos += outBufferPos;
             outBufferPos = 0;
@@ -496,8 +484,8 @@ public:
                 data->curPosLock.lock();
                 SDL_ClearQueuedAudio(audioDev);
                 SDL_QueueAudio(audioDev, data->outBuffer, data->outBufferPos);
-                memcpy(data->sampleBuffer, data->outBuffer, data->outBufferPos);
-                data->sampleBufferCount = data->outBufferPos;
+                AudioAnalysis::INSTANCE.addPlaybackSamples(data->outBuffer, data->outBufferPos, data->bytesPerSample,
+                                                           data->isSamplesFloat, data->channels, data->currentRate);
                 data->curPos += data->outBufferPos;
                 data->outBufferPos = 0;
                 data->curPosLock.unlock();
@@ -861,41 +849,14 @@ bool SDLOutput::ProcessVideoOverlay(unsigned int msTimestamp) {
     return false;
 }
 bool SDLOutput::GetAudioSamples(float* samples, int numSamples, int& sampleRate) {
+    return AudioAnalysis::INSTANCE.getSamples(samples, numSamples, sampleRate);
+}
+int SDLOutput::GetQueuedAudioFrames() {
     SDLInternalData* data = sdlManager.data;
-    if (data && !data->stopped) {
-        // printf("In Samples:  %d\n", data->outBufferPos);
-        data->curPosLock.lock();
-        int queue = SDL_GetQueuedAudioSize(data->audioDev);
-        if (data->bytesPerSample == 2) {
-            int offset = data->sampleBufferCount - queue;
-            int16_t* ds = (int16_t*)(&data->sampleBuffer[offset]);
-            // just grab the left channel audio
-            for (int x = 0; x < numSamples; x++) {
-                samples[x] = ds[x * data->channels];
-                samples[x] /= 32767.0f;
-            }
-        } else if (data->isSamplesFloat) {
-            int offset = data->sampleBufferCount - queue;
-            float* ds = (float*)(&data->sampleBuffer[offset]);
-            // just grab the left channel audio
-            for (int x = 0; x < numSamples; x++) {
-                samples[x] = ds[x * data->channels];
-            }
-        } else {
-            // 32bit sampling
-            int offset = data->sampleBufferCount - queue;
-            int32_t* ds = (int32_t*)(&data->sampleBuffer[offset]);
-            // just grab the left channel audio
-            for (int x = 0; x < numSamples; x++) {
-                samples[x] = ds[x * data->channels];
-                samples[x] /= 0x8FFFFFFF;
-            }
-        }
-        sampleRate = data->currentRate;
-        data->curPosLock.unlock();
-        return true;
+    if (data && !data->stopped && data->audioDev) {
+        return SDL_GetQueuedAudioSize(data->audioDev) / (data->bytesPerSample * data->channels);
     }
-    return false;
+    return -1;
 }
 
 static std::string currentMediaFilename;
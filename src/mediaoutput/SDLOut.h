@@ -28,7 +28,10 @@ public:
 
     static bool IsOverlayingVideo();
     static bool ProcessVideoOverlay(unsigned int msTimestamp);
+    // the mono samples about to be played, see AudioAnalysis
     static bool GetAudioSamples(float *samples, int numSamples, int &sampleRate);
+    // audio frames SDL has queued but not yet played, -1 if not playing
+    static int GetQueuedAudioFrames();
 
 private:
     SDLInternalData* data;
@@ -76,18 +76,12 @@ uint32_t PixelOverlayManager::mapColor(const std::string& c) {
 }
 
 PixelOverlayManager::PixelOverlayManager() :
-    numActive(0) {
+    numActive(0),
+    pendingEffects(0),
+    pendingSerialEffects(0) {
 }
 PixelOverlayManager::~PixelOverlayManager() {
-    if (updateThread != nullptr) {
-        std::unique_lock<std::mutex> l(threadLock);
-        threadKeepRunning = false;
-        l.unlock();
-        threadCV.notify_all();
-        updateThread->join();
-        delete updateThread;
-        updateThread = nullptr;
-    }
+    stopEffectThreads();
     for (auto a : models) {
         delete a.second;
     }
@@ -128,16 +122,7 @@ void PixelOverlayManager::addModel(Json::Value config) {
 
 void PixelOverlayManager::loadModelMap() {
     LogDebug(VB_CHANNELOUT, "PixelOverlayManager::loadModelMap()\n");
-    if (updateThread != nullptr) {
-        std::unique_lock<std::mutex> l(threadLock);
-        threadKeepRunning = false;
-        updates.clear();
-        l.unlock();
-        threadCV.notify_all();
-        updateThread->join();
-        delete updateThread;
-        updateThread = nullptr;
-    }
+    stopEffectThreads();
     for (auto a : models) {
         delete a.second;
     }
@@ -279,6 +264,7 @@ void PixelOverlayManager::doOverlays(uint8_t* channels) {
     std::unique_lock<std::mutex> lock(activeModelsLock);
     // First, flush any buffers
     for (auto m : activeModels) {
+        m->consumeOverlayBufferFrame();
         if (m->overlayBufferIsDirty()) {
             m->flushOverlayBuffer();
         }
@@ -452,11 +438,13 @@ HTTP_RESPONSE_CONST std::shared_ptr<httpserver::http_response> PixelOverlayManag
                 PixelOverlayModel* m = models[mn];
                 m->toJson(model);
                 model["isActive"] = (int)m->getState().getState();
+                model["opacity"] = m->getOpacity();
                 std::unique_lock<std::recursive_mutex> lock(m->getRunningEffectMutex());
                 if (m->getRunningEffect()) {
                     model["effectName"] = m->getRunningEffect()->name();
                     model["isLocked"] = true;
                     model["effectRunning"] = true;
+                    m->getEffectStats(model["effectStats"]);
                 } else {
                     model["effectRunning"] = false;
                 }
@@ -486,10 +474,12 @@ HTTP_RESPONSE_CONST std::shared_ptr<httpserver::http_response> PixelOverlayManag
                 } else {
                     m->toJson(result);
                     result["isActive"] = (int)m->getState().getState();
+                    result["opacity"] = m->getOpacity();
                     if (m->getRunningEffect()) {
                         result["effectName"] = m->getRunningEffect()->name();
                         result["isLocked"] = true;
                         result["effectRunning"] = true;
+                        m->getEffectStats(result["effectStats"]);
                     } else {
                         result["isLocked"] = false; //compatibility
                         result["effectRunning"] = false;
@@ -566,7 +556,14 @@ HTTP_RESPONSE_CONST std::shared_ptr<httpserver::http_response> PixelOverlayManag
                     Json::Value root;
                     if (LoadJsonFromString(std::string(req.get_content()), root)) {
                         if (root.isMember("State")) {
-                            m->setState(PixelOverlayState(root["State"].asInt()));
+                            if (root.isMember("Opacity")) {
+                                m->setOpacity(root["Opacity"].asInt());
+                            }
+                            if (root["State"].isString()) {
+                                m->setState(PixelOverlayState(root["State"].asString()));
+                            } else {
+                                m->setState(PixelOverlayState(root["State"].asInt()));
+                            }
                             return std::shared_ptr<httpserver::http_response>(new httpserver::string_response("{ \"Status\": \"OK\", \"Message\": \"\"}", 200));
                         } else {
                             return std::shared_ptr<httpserver::http_response>(new httpserver::string_response("Invalid request " + std::string(req.get_content()), 500));
@@ -759,7 +756,7 @@ public:
     EnableOverlayCommand(PixelOverlayManager* m) :
         OverlayCommand("Overlay Model State", m) {
         args.push_back(CommandArg("Model", "multistring", "Model").setContentListUrl("api/models?simple=true", false));
-        args.push_back(CommandArg("State", "string", "State").setContentList({ "Disabled", "Enabled", "Transparent", "TransparentRGB" }));
+        args.push_back(CommandArg("State", "string", "State").setContentList({ "Disabled", "Enabled", "Transparent", "TransparentRGB", "Alpha", "Add", "Max", "Multiply", "Subtract" }));
     }
 
     virtual std::unique_ptr<Command::Result> run(const std::vector<std::string>& args) override {
@@ -782,6 +779,35 @@ public:
         return std::make_unique<Command::Result>("Model State Set");
     }
 };
+class OpacityOverlayCommand : public OverlayCommand {
+public:
+    OpacityOverlayCommand(PixelOverlayManager* m) :
+        OverlayCommand("Overlay Model Opacity", m) {
+        args.push_back(CommandArg("Model", "multistring", "Model").setContentListUrl("api/models?simple=true", false));
+        args.push_back(CommandArg("Opacity", "int", "Opacity").setRange(0, 255).setDefaultValue("255").setAdjustable());
+    }
+
+    virtual std::unique_ptr<Command::Result> run(const std::vector<std::string>& args) override {
+        if (args.size() != 2) {
+            return std::make_unique<Command::ErrorResult>("Command needs 2 arguments, found " + std::to_string(args.size()));
+        }
+        std::unique_lock<std::mutex> lock(getLock());
+        std::list<PixelOverlayModel*> models;
+        for (auto& ms : split(args[0], ',')) {
+            auto m = manager->getModel(ms);
+            if (m) {
+                models.push_back(m);
+            } else {
+                return std::make_unique<Command::ErrorResult>("No model found: " + ms);
+            }
+        }
+        int opacity = std::atoi(args[1].c_str());
+        for (auto m : models) {
+            m->setOpacity(opacity);
+        }
+        return std::make_unique<Command::Result>("Model Opacity Set");
+    }
+};
 class ClearOverlayCommand : public OverlayCommand {
 public:
     ClearOverlayCommand(PixelOverlayManager* m) :
@@ -814,7 +840,7 @@ public:
     FillOverlayCommand(PixelOverlayManager* m) :
         OverlayCommand("Overlay Model Fill", m) {
         args.push_back(CommandArg("Model", "multistring", "Model").setContentListUrl("api/models?simple=true", false));
-        args.push_back(CommandArg("State", "string", "State").setContentList({ "Don't Set", "Enabled", "Transparent", "TransparentRGB" }));
+        args.push_back(CommandArg("State", "string", "State").setContentList({ "Don't Set", "Enabled", "Transparent", "TransparentRGB", "Alpha", "Add", "Max", "Multiply", "Subtract" }));
         args.push_back(CommandArg("Color", "color", "Color").setDefaultValue("#FF0000"));
     }
 
@@ -903,7 +929,7 @@ public:
     ApplyEffectOverlayCommand(PixelOverlayManager* m) :
         OverlayCommand("Overlay Model Effect", m) {
         args.push_back(CommandArg("Models", "multistring", "Models").setContentListUrl("api/models?simple=true", false));
-        args.push_back(CommandArg("AutoEnable", "string", "Auto Enable/Disable").setContentList({ "False", "Enabled", "Transparent", "Transparent RGB" }).setDefaultValue("Enabled"));
+        args.push_back(CommandArg("AutoEnable", "string", "Auto Enable/Disable").setContentList({ "False", "Enabled", "Transparent", "Transparent RGB", "Alpha", "Add", "Max", "Multiply", "Subtract" }).setDefaultValue("Enabled"));
         args.push_back(CommandArg("Effect", "subcommand", "Effect").setContentListUrl("api/overlays/effects/", false));
     }
 
@@ -937,6 +963,7 @@ void PixelOverlayManager::RegisterCommands() {
         return;
     }
     CommandManager::INSTANCE.addCommand(new EnableOverlayCommand(this));
+    CommandManager::INSTANCE.addCommand(new OpacityOverlayCommand(this));
     CommandManager::INSTANCE.addCommand(new FillOverlayCommand(this));
     CommandManager::INSTANCE.addCommand(new TextOverlayCommand(this));
     CommandManager::INSTANCE.addCommand(new ClearOverlayCommand(this));
@@ -969,27 +996,33 @@ void PixelOverlayManager::doOverlayModelEffects() {
         uint32_t waitTime = 1000;
         if (!updates.empty()) {
             uint64_t curTime = GetTimeMS();
+            int queued = 0;
+            int queuedSerial = 0;
             while (!updates.empty() && updates.begin()->first <= curTime) {
-                std::list<PixelOverlayModel*> models = updates.begin()->second;
                 uint64_t startTime = updates.begin()->first;
-                updates.erase(updates.begin());
-                l.unlock();
-
-                for (auto m : models) {
-                    int32_t ms = m->updateRunningEffects();
-                    if (ms != 0) {
-                        l.lock();
-                        if (ms > 0) {
-                            uint64_t t = startTime + ms;
-                            updates[t].push_back(m);
-                        } else {
-                            afterOverlayModels.push_back(m);
-                        }
-                        l.unlock();
+                for (auto m : updates.begin()->second) {
+                    inFlightModels.insert(m);
+                    if (m->hasSerialEffect()) {
+                        EffectWorker* w = effectWorkers[0];
+                        std::unique_lock<std::mutex> ql(w->lock);
+                        w->serialQueue.emplace_back(m, startTime);
+                        queuedSerial++;
+                    } else {
+                        EffectWorker* w = effectWorkers[nextWorker];
+                        nextWorker = (nextWorker + 1) % effectWorkers.size();
+                        std::unique_lock<std::mutex> ql(w->lock);
+                        w->queue.emplace_back(m, startTime);
+                        queued++;
                     }
                 }
-                l.lock();
-                curTime = GetTimeMS();
+                updates.erase(updates.begin());
+            }
+            if (queued || queuedSerial) {
+                std::unique_lock<std::mutex> wl(workerLock);
+                pendingEffects += queued;
+                pendingSerialEffects += queuedSerial;
+                wl.unlock();
+                workerCV.notify_all();
             }
             if (!updates.empty()) {
                 waitTime = updates.begin()->first - curTime;
@@ -998,17 +1031,121 @@ void PixelOverlayManager::doOverlayModelEffects() {
         threadCV.wait_for(l, std::chrono::milliseconds(waitTime));
     }
 }
+
+void PixelOverlayManager::effectWorkerThread(int idx) {
+    SetThreadName("FPP-OverlayW" + std::to_string(idx));
+    std::pair<PixelOverlayModel*, uint64_t> work;
+    while (nextEffect(idx, work)) {
+        runModelEffect(work.first, work.second);
+    }
+}
+
+bool PixelOverlayManager::nextEffect(int idx, std::pair<PixelOverlayModel*, uint64_t>& work) {
+    int count = effectWorkers.size();
+    while (true) {
+        // oldest from our own queue first, otherwise steal the newest
+        // from someone else's
+        for (int x = 0; x < count; x++) {
+            EffectWorker* w = effectWorkers[(idx + x) % count];
+            std::unique_lock<std::mutex> ql(w->lock);
+            if (x == 0 && !w->serialQueue.empty()) {
+                work = w->serialQueue.front();
+                w->serialQueue.pop_front();
+                pendingSerialEffects--;
+                return true;
+            }
+            if (!w->queue.empty()) {
+                if (x == 0) {
+                    work = w->queue.front();
+                    w->queue.pop_front();
+                } else {
+                    work = w->queue.back();
+                    w->queue.pop_back();
+                }
+                pendingEffects--;
+                return true;
+            }
+        }
+        std::unique_lock<std::mutex> l(workerLock);
+        workerCV.wait(l, [this, idx]() {
+            return pendingEffects > 0 || (idx == 0 && pendingSerialEffects > 0) || !workersKeepRunning;
+        });
+        if (!workersKeepRunning) {
+            return false;
+        }
+    }
+}
+
+void PixelOverlayManager::runModelEffect(PixelOverlayModel* m, uint64_t scheduledTime) {
+    int64_t late = GetTimeMS() - scheduledTime;
+    int32_t ms = m->updateRunningEffects(late > 0 ? late : 0);
+
+    std::unique_lock<std::mutex> l(threadLock);
+    inFlightModels.erase(m);
+    if (replacedModels.erase(m) || ms == 0) {
+        return;
+    }
+    if (ms > 0) {
+        updates[scheduledTime + ms].push_back(m);
+    } else {
+        afterOverlayModels.push_back(m);
+    }
+    l.unlock();
+    threadCV.notify_all();
+}
+
+void PixelOverlayManager::stopEffectThreads() {
+    if (updateThread == nullptr) {
+        return;
+    }
+    std::unique_lock<std::mutex> l(threadLock);
+    threadKeepRunning = false;
+    updates.clear();
+    l.unlock();
+    threadCV.notify_all();
+    updateThread->join();
+    delete updateThread;
+    updateThread = nullptr;
+
+    std::unique_lock<std::mutex> wl(workerLock);
+    workersKeepRunning = false;
+    wl.unlock();
+    workerCV.notify_all();
+    for (auto w : effectWorkers) {
+        w->thread->join();
+        delete w->thread;
+        delete w;
+    }
+    effectWorkers.clear();
+    pendingEffects = 0;
+    pendingSerialEffects = 0;
+    inFlightModels.clear();
+    replacedModels.clear();
+}
+
 void PixelOverlayManager::removePeriodicUpdate(PixelOverlayModel* m) {
     std::unique_lock<std::mutex> l(threadLock);
     for (auto& a : updates) {
-        updates.begin()->second.remove(m);
+        a.second.remove(m);
     }
     afterOverlayModels.remove(m);
+    if (inFlightModels.find(m) != inFlightModels.end()) {
+        replacedModels.insert(m);
+    }
 }
 
 void PixelOverlayManager::addPeriodicUpdate(int32_t initialDelayMS, PixelOverlayModel* m) {
     std::unique_lock<std::mutex> l(threadLock);
     if (updateThread == nullptr) {
+        // leave a core for the channel output thread
+        int count = std::clamp((int)std::thread::hardware_concurrency() - 1, 1, 4);
+        workersKeepRunning = true;
+        for (int x = 0; x < count; x++) {
+            effectWorkers.push_back(new EffectWorker());
+        }
+        for (int x = 0; x < count; x++) {
+            effectWorkers[x]->thread = new std::thread(&PixelOverlayManager::effectWorkerThread, this, x);
+        }
         threadKeepRunning = true;
         updateThread = new std::thread(&PixelOverlayManager::doOverlayModelEffects, this);
     }
@@ -13,12 +13,15 @@
 
 #include <atomic>
 #include <condition_variable>
+#include <deque>
 #include <httpserver.hpp>
 #include <list>
 #include <map>
 #include <mutex>
+#include <set>
 #include <string>
 #include <thread>
+#include <vector>
 
 class PixelOverlayState;
 class PixelOverlayModel;
@@ -79,12 +82,40 @@ private:
     std::mutex modelsLock;
 
     void doOverlayModelEffects();
+    void stopEffectThreads();
     std::thread* updateThread = nullptr;
     bool threadKeepRunning = true;
     std::mutex threadLock;
     std::condition_variable threadCV;
     std::map<uint64_t, std::list<PixelOverlayModel*>> updates;
     std::list<PixelOverlayModel*> afterOverlayModels;
+    // models being updated by a worker and, of those, the ones whose
+    // effect was replaced meanwhile and must not be rescheduled
+    std::set<PixelOverlayModel*> inFlightModels;
+    std::set<PixelOverlayModel*> replacedModels;
+
+    // Effects that are due are handed out round robin to the workers, a
+    // worker with nothing queued steals from the back of another's queue.
+    // A model is not rescheduled until its update has returned so its
+    // updates stay in order.  Effects that require serial updates all go
+    // to the first worker's serialQueue which is never stolen from.
+    class EffectWorker {
+    public:
+        std::thread* thread = nullptr;
+        std::mutex lock;
+        std::deque<std::pair<PixelOverlayModel*, uint64_t>> queue;
+        std::deque<std::pair<PixelOverlayModel*, uint64_t>> serialQueue;
+    };
+    void effectWorkerThread(int idx);
+    bool nextEffect(int idx, std::pair<PixelOverlayModel*, uint64_t>& work);
+    void runModelEffect(PixelOverlayModel* m, uint64_t scheduledTime);
+    std::vector<EffectWorker*> effectWorkers;
+    std::mutex workerLock;
+    std::condition_variable workerCV;
+    bool workersKeepRunning = true;
+    std::atomic_int pendingEffects;       // in the stealable queues
+    std::atomic_int pendingSerialEffects; // in the first worker's serialQueue
+    int nextWorker = 0;
 
     void loadFonts();
 
@@ -0,0 +1,151 @@
+#pragma once
+/*
+ * This file is part of the Falcon Player (FPP) and is Copyright (C)
+ * 2013-2022 by the Falcon Player Developers.
+ *
+ * The Falcon Player (FPP) is free software, and is covered under
+ * multiple Open Source licenses.  Please see the included 'LICENSES'
+ * file for descriptions of what files are covered by each license.
+ *
+ * This source file is covered under the LGPL v2.1 as described in the
+ * included LICENSE.LGPL file.
+ */
+
+// Layout of the shared memory overlay buffer fppd maps for each pixel
+// overlay model as /FPP-Model-Overlay-Buffer-<Model> (/FPPMB-<Model> on
+// systems with short shared memory names).  It is mapped the first time
+// the buffer is used or the model is output.
+//
+// The original interface is a single width*height*3 RGB buffer: write
+// the data, then set FPP_OVERLAY_BUFFER_DIRTY in flags and fppd copies
+// it into the model on its next frame.  There is no way to know when
+// that happened and writing the next frame may tear the current one.
+//
+// Following the data is a PixelOverlayBufferSync block (check magic) that
+// adds a second buffer and a handoff where fppd tells the producer when
+// a frame has been consumed:
+//
+//   idx = 0
+//   loop:
+//       render into PixelOverlayBufferData(buf, idx)
+//       wait until consumedSeq == readySeq     (previous frame taken)
+//       readyIndex = idx
+//       readySeq++                             (release)
+//       idx ^= 1
+//
+// While one frame waits to be consumed the next one can be rendered into
+// the other buffer.  fppd copies each published frame out exactly once
+// on the output thread, then stores readySeq into consumedSeq.  It also
+// increments frameNumber every output frame while the model is active.
+// consumedSeq and frameNumber are futex words so producers can sleep on
+// them with PixelOverlayBufferWait() instead of polling.  Sleepers are
+// counted in waiters so fppd only makes the wake syscalls when someone
+// is actually waiting.
+
+#include <errno.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+
+#if __has_include(<linux/futex.h>)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+#define FPP_OVERLAY_BUFFER_DIRTY 0x1
+
+#define FPP_OVERLAY_SYNC_MAGIC 0x534F5046 // 'FPOS'
+#define FPP_OVERLAY_SYNC_VERSION 1
+
+typedef struct __attribute__((__packed__)) {
+    uint32_t width;
+    uint32_t height;
+    uint32_t flags;
+    uint8_t data[4];
+} PixelOverlayBuffer;
+
+typedef struct {
+    uint32_t magic;       // FPP_OVERLAY_SYNC_MAGIC once fppd has set up the block
+    uint32_t version;     // FPP_OVERLAY_SYNC_VERSION
+    uint32_t frameNumber; // fppd: output frames since the buffer was mapped
+    uint32_t readySeq;    // producer: incremented after each published frame
+    uint32_t readyIndex;  // producer: buffer (0 or 1) holding the published frame
+    uint32_t consumedSeq; // fppd: readySeq of the last frame copied out
+    uint32_t waiters;     // producers sleeping in PixelOverlayBufferWait()
+    uint32_t reserved;
+    uint8_t data[8]; // the second width*height*3 buffer
+} PixelOverlayBufferSync;
+
+static inline uint32_t PixelOverlayBufferSyncOffset(uint32_t width, uint32_t height) {
+    return (12 + width * height * 3 + 7) & ~7;
+}
+static inline uint32_t PixelOverlayBufferSize(uint32_t width, uint32_t height) {
+    return PixelOverlayBufferSyncOffset(width, height) + sizeof(PixelOverlayBufferSync) + width * height * 3;
+}
+static inline PixelOverlayBufferSync* PixelOverlayBufferGetSync(PixelOverlayBuffer* b) {
+    return (PixelOverlayBufferSync*)((uint8_t*)b + PixelOverlayBufferSyncOffset(b->width, b->height));
+}
+static inline uint8_t* PixelOverlayBufferData(PixelOverlayBuffer* b, uint32_t idx) {
+    return idx ? PixelOverlayBufferGetSync(b)->data : b->data;
+}
+
+// Wakes anyone waiting on one of the futex words of the sync block.  The
+// word must have been updated with __ATOMIC_SEQ_CST so either the waiter
+// sees the new value or we see the waiter.
+static inline void PixelOverlayBufferWake(PixelOverlayBufferSync* sync, uint32_t* addr) {
+#ifdef FUTEX_WAKE
+    if (__atomic_load_n(&sync->waiters, __ATOMIC_SEQ_CST)) {
+        syscall(SYS_futex, addr, FUTEX_WAKE, 0x7FFFFFFF, nullptr, nullptr, 0);
+    }
+#endif
+}
+
+// Sleeps until *addr no longer contains val or timeoutMS elapses.
+// Returns true if the value changed.
+static inline bool PixelOverlayBufferWait(PixelOverlayBufferSync* sync, uint32_t* addr, uint32_t val, int timeoutMS) {
+#ifdef FUTEX_WAIT
+    struct timespec ts;
+    ts.tv_sec = timeoutMS / 1000;
+    ts.tv_nsec = (timeoutMS % 1000) * 1000000;
+    __atomic_add_fetch(&sync->waiters, 1, __ATOMIC_SEQ_CST);
+    while (__atomic_load_n(addr, __ATOMIC_SEQ_CST) == val) {
+        struct timespec start;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        if (syscall(SYS_futex, addr, FUTEX_WAIT, val, &ts, nullptr, 0) != 0 && errno == ETIMEDOUT) {
+            __atomic_sub_fetch(&sync->waiters, 1, __ATOMIC_SEQ_CST);
+            return false;
+        }
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        long elapsed = (now.tv_sec - start.tv_sec) * 1000000000L + (now.tv_nsec - start.tv_nsec);
+        long left = ts.tv_sec * 1000000000L + ts.tv_nsec - elapsed;
+        if (left <= 0) {
+            __atomic_sub_fetch(&sync->waiters, 1, __ATOMIC_SEQ_CST);
+            return __atomic_load_n(addr, __ATOMIC_ACQUIRE) != val;
+        }
+        ts.tv_sec = left / 1000000000L;
+        ts.tv_nsec = left % 1000000000L;
+    }
+    __atomic_sub_fetch(&sync->waiters, 1, __ATOMIC_SEQ_CST);
+    return true;
+#else
+    for (int x = 0; x < timeoutMS; x++) {
+        if (__atomic_load_n(addr, __ATOMIC_ACQUIRE) != val) {
+            return true;
+        }
+        usleep(1000);
+    }
+    return __atomic_load_n(addr, __ATOMIC_ACQUIRE) != val;
+#endif
+}
+
+// Waits for fppd to consume the frame that was published as seq
+static inline bool PixelOverlayBufferWaitConsumed(PixelOverlayBufferSync* sync, uint32_t seq, int timeoutMS) {
+    uint32_t c;
+    while ((c = __atomic_load_n(&sync->consumedSeq, __ATOMIC_ACQUIRE)) != seq) {
+        if (!PixelOverlayBufferWait(sync, &sync->consumedSeq, c, timeoutMS)) {
+            return false;
+        }
+    }
+    return true;
+}
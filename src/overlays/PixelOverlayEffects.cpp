@@ -12,13 +12,6 @@
 
 #include "fpp-pch.h"
 
-#include <Magick++/Blob.h>
-#include <Magick++/Color.h>
-#include <Magick++/Geometry.h>
-#include <Magick++/Image.h>
-#include <Magick++/Include.h>
-#include <Magick++/TypeMetric.h>
-#include <magick/image.h>
 #include <algorithm>
 #include <cstdint>
 #include <cstdlib>
@@ -36,6 +29,7 @@
 
 #include "PixelOverlay.h"
 #include "PixelOverlayModel.h"
+#include "PixelOverlayText.h"
 #include "WLEDEffects.h"
 
 #include "PixelOverlayEffects.h"
@@ -513,59 +507,13 @@ public:
             disableWhenDone = true;
         }
 
-        Magick::Image* image = new Magick::Image(Magick::Geometry(m->getWidth(), m->getHeight()), Magick::Color("black"));
-        image->quiet(true);
-        image->depth(8);
-        image->font(font);
-        image->fontPointsize(fontSize);
-        image->antiAlias(antialias);
-
-        int maxWid = 0;
-        int totalHi = 0;
-
-        int lines = 1;
-        int last = 0;
-        for (int x = 0; x < msg.length(); x++) {
-            if (msg[x] == '\n' || ((x < msg.length() - 1) && msg[x] == '\\' && msg[x + 1] == 'n')) {
-                lines++;
-                std::string newM = msg.substr(last, x);
-                Magick::TypeMetric metrics;
-                image->fontTypeMetrics(newM, &metrics);
-                maxWid = std::max(maxWid, (int)metrics.textWidth());
-                totalHi += (int)metrics.textHeight();
-                if (msg[x] == '\n') {
-                    last = x + 1;
-                } else {
-                    last = x + 2;
-                }
-            }
-        }
-        std::string newM = msg.substr(last);
-        Magick::TypeMetric metrics;
-        image->fontTypeMetrics(newM, &metrics);
-        maxWid = std::max(maxWid, (int)metrics.textWidth());
-        totalHi += (int)metrics.textHeight();
-
         if (position == "Centered" || position == "Center") {
-            image->magick("RGB");
             // one shot, just draw the text and return
-            double rr = r;
-            double rg = g;
-            double rb = b;
-            rr /= 255.0f;
-            rg /= 255.0f;
-            rb /= 255.0f;
-
-            image->fillColor(Magick::Color(Magick::Color::scaleDoubleToQuantum(rr),
-                                           Magick::Color::scaleDoubleToQuantum(rg),
-                                           Magick::Color::scaleDoubleToQuantum(rb)));
-            image->antiAlias(antialias);
-            image->strokeAntiAlias(antialias);
-            image->annotate(msg, Magick::CenterGravity);
-            Magick::Blob blob;
-            image->write(&blob);
-
-            m->setData((uint8_t*)blob.data());
+            std::shared_ptr<const TextRaster> text = PixelOverlayTextCache::INSTANCE.getCenteredText(font, fontSize, antialias, msg,
+                                                                                                     m->getWidth(), m->getHeight());
+            std::vector<uint8_t> data(text->width * text->height * 3);
+            text->toRGB(&data[0], r, g, b);
+            m->setData(&data[0]);
 
             if (disableWhenDone) {
                 int nd = 25;
@@ -574,66 +522,25 @@ public:
                 }
                 m->setRunningEffect(new StopRunningEffect(m, "Text", disableWhenDone), nd);
             }
-            delete image;
         } else {
-            delete image;
             // movement
-            double rr = r;
-            double rg = g;
-            double rb = b;
-            rr /= 255.0f;
-            rg /= 255.0f;
-            rb /= 255.0f;
-
-            Magick::Image image2(Magick::Geometry(maxWid, totalHi), Magick::Color("black"));
-            image2.quiet(true);
-            image2.depth(8);
-            image2.font(font);
-            image2.fontPointsize(fontSize);
-            image2.antiAlias(antialias);
-
-            image2.fillColor(Magick::Color(Magick::Color::scaleDoubleToQuantum(rr),
-                                           Magick::Color::scaleDoubleToQuantum(rg),
-                                           Magick::Color::scaleDoubleToQuantum(rb)));
-            image2.antiAlias(antialias);
-            image2.strokeAntiAlias(antialias);
-            image2.annotate(msg, Magick::CenterGravity);
-
-            double y = (m->getHeight() / 2.0) - ((totalHi) / 2.0);
-            double x = (m->getWidth() / 2.0) - (maxWid / 2.0);
+            std::shared_ptr<const TextRaster> text = PixelOverlayTextCache::INSTANCE.getText(font, fontSize, antialias, msg);
+
+            double y = (m->getHeight() / 2.0) - (text->height / 2.0);
+            double x = (m->getWidth() / 2.0) - (text->width / 2.0);
             if (position == "R2L") {
                 x = m->getWidth();
             } else if (position == "L2R") {
-                x = -maxWid;
+                x = -text->width;
             } else if (position == "B2T") {
                 y = m->getHeight();
             } else if (position == "T2B") {
-                y = -metrics.ascent();
-            }
-            image2.modifyImage();
-
-            const MagickLib::PixelPacket* pixel_cache = image2.getConstPixels(0, 0, image2.columns(), image2.rows());
-            uint8_t* newData = (uint8_t*)malloc(image2.columns() * image2.rows() * 3);
-            for (int yi = 0; yi < image2.rows(); yi++) {
-                int idx = yi * image2.columns();
-                int nidx = yi * image2.columns() * 3;
-
-                for (int xi = 0; xi < image2.columns(); xi++) {
-                    const MagickLib::PixelPacket* ptr2 = &pixel_cache[idx + xi];
-                    uint8_t* np = &newData[nidx + (xi * 3)];
-
-                    float r = Magick::Color::scaleQuantumToDouble(ptr2->red);
-                    float g = Magick::Color::scaleQuantumToDouble(ptr2->green);
-                    float b = Magick::Color::scaleQuantumToDouble(ptr2->blue);
-                    r *= 255;
-                    g *= 255;
-                    b *= 255;
-                    np[0] = r;
-                    np[1] = g;
-                    np[2] = b;
-                }
+                y = -text->ascent;
             }
 
+            uint8_t* newData = (uint8_t*)malloc(text->width * text->height * 3);
+            text->toRGB(newData, r, g, b);
+
             std::unique_lock<std::recursive_mutex> lock(m->getRunningEffectMutex());
             TextMovementEffect* ef = dynamic_cast<TextMovementEffect*>(m->getRunningEffect());
             if (ef == nullptr) {
@@ -650,8 +557,8 @@ public:
             }
             uint8_t* old = ef->imageData;
             ef->imageData = newData;
-            ef->imageDataCols = image2.columns();
-            ef->imageDataRows = image2.rows();
+            ef->imageDataCols = text->width;
+            ef->imageDataRows = text->height;
             ef->copyImageData(ef->x, ef->y);
             m->setRunningEffect(ef, t);
             lock.unlock();
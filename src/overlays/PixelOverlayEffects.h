@@ -32,6 +32,11 @@ public:
 
     virtual const std::string& name() const = 0;
 
+    // Effects are normally updated in parallel on the overlay worker
+    // threads.  Effects that share global state between instances must
+    // return true so they are all updated from the same thread.
+    virtual bool requiresSerialUpdates() const { return false; }
+
     PixelOverlayModel* model;
 };
 
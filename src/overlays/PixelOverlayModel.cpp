@@ -42,6 +42,12 @@
 #include <utility>
 #include <vector>
 
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #include "../Plugins.h"
 #include "../Sequence.h"
 #include "../commands/Commands.h"
@@ -54,6 +60,9 @@
 #include "PixelOverlayEffects.h"
 #include "PixelOverlayModel.h"
 
+// An effect update starting this much after it was due counts as late
+#define EFFECT_LATE_MS 5
+
 static uint8_t* createChannelDataMemory(const std::string& dataName, uint32_t size) {
     mode_t mode = S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH | S_IWOTH;
     int f = shm_open(dataName.c_str(), O_RDWR | O_CREAT, mode);
@@ -88,6 +97,229 @@ static uint8_t* createChannelDataMemory(const std::string& dataName, uint32_t si
     return channelData;
 }
 
+// dst = src for every non-zero byte of src
+static void copyTransparent(uint8_t* dst, const uint8_t* src, int len) {
+    int i = 0;
+#if defined(__ARM_NEON)
+    for (; i + 16 <= len; i += 16) {
+        uint8x16_t s = vld1q_u8(src + i);
+        uint8x16_t z = vceqq_u8(s, vdupq_n_u8(0));
+        vst1q_u8(dst + i, vbslq_u8(z, vld1q_u8(dst + i), s));
+    }
+#elif defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= len; i += 16) {
+        __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+        __m128i z = _mm_cmpeq_epi8(s, zero);
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_or_si128(_mm_and_si128(z, d), _mm_andnot_si128(z, s)));
+    }
+#endif
+    for (; i < len; i++) {
+        if (src[i]) {
+            dst[i] = src[i];
+        }
+    }
+}
+
+// dst = src for every pixel of src that is not black.  len must be a
+// multiple of 3 unless the run is a single pixel of a model with less
+// than 3 channels per node.
+static void copyTransparentRGB(uint8_t* dst, const uint8_t* src, int len) {
+    int i = 0;
+#if defined(__ARM_NEON)
+    for (; i + 48 <= len; i += 48) {
+        uint8x16x3_t s = vld3q_u8(src + i);
+        uint8x16x3_t d = vld3q_u8(dst + i);
+        uint8x16_t z = vceqq_u8(vorrq_u8(vorrq_u8(s.val[0], s.val[1]), s.val[2]), vdupq_n_u8(0));
+        d.val[0] = vbslq_u8(z, d.val[0], s.val[0]);
+        d.val[1] = vbslq_u8(z, d.val[1], s.val[1]);
+        d.val[2] = vbslq_u8(z, d.val[2], s.val[2]);
+        vst3q_u8(dst + i, d);
+    }
+#elif defined(__SSE2__)
+    // 5 pixels per 16 byte load, the 16th byte is always left as is
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i lastOfPixel = _mm_setr_epi8(0, 0, -1, 0, 0, -1, 0, 0, -1, 0, 0, -1, 0, 0, -1, 0);
+    for (; i + 16 <= len; i += 15) {
+        __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+        __m128i nz = _mm_andnot_si128(_mm_cmpeq_epi8(s, zero), _mm_set1_epi8(-1));
+        // OR each pixel's bytes into its last byte, then spread that back
+        // over the whole pixel
+        __m128i m = _mm_or_si128(nz, _mm_or_si128(_mm_slli_si128(nz, 1), _mm_slli_si128(nz, 2)));
+        m = _mm_and_si128(m, lastOfPixel);
+        m = _mm_or_si128(m, _mm_or_si128(_mm_srli_si128(m, 1), _mm_srli_si128(m, 2)));
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_or_si128(_mm_andnot_si128(m, d), _mm_and_si128(m, s)));
+    }
+#endif
+    for (; i < len; i += 3) {
+        int n = std::min(3, len - i);
+        bool lit = false;
+        for (int x = 0; x < n; x++) {
+            lit |= src[i + x] != 0;
+        }
+        if (lit) {
+            memcpy(dst + i, src + i, n);
+        }
+    }
+}
+
+// v / 255, rounded, for v <= 255 * 255
+static inline uint8_t div255(uint32_t v) {
+    v += 128;
+    return (v + (v >> 8)) >> 8;
+}
+#if defined(__ARM_NEON)
+static inline uint8x8_t div255(uint16x8_t v) {
+    return vraddhn_u16(v, vrshrq_n_u16(v, 8));
+}
+#elif defined(__SSE2__)
+static inline __m128i div255(__m128i v) {
+    v = _mm_add_epi16(v, _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(v, _mm_srli_epi16(v, 8)), 8);
+}
+#endif
+
+// dst = (src * opacity + dst * (255 - opacity)) / 255
+static void blendAlpha(uint8_t* dst, const uint8_t* src, int len, uint8_t opacity) {
+    int i = 0;
+#if defined(__ARM_NEON)
+    const uint8x8_t a = vdup_n_u8(opacity);
+    const uint8x8_t ia = vdup_n_u8(255 - opacity);
+    for (; i + 16 <= len; i += 16) {
+        uint8x16_t s = vld1q_u8(src + i);
+        uint8x16_t d = vld1q_u8(dst + i);
+        uint16x8_t lo = vmlal_u8(vmull_u8(vget_low_u8(s), a), vget_low_u8(d), ia);
+        uint16x8_t hi = vmlal_u8(vmull_u8(vget_high_u8(s), a), vget_high_u8(d), ia);
+        vst1q_u8(dst + i, vcombine_u8(div255(lo), div255(hi)));
+    }
+#elif defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i a = _mm_set1_epi16(opacity);
+    const __m128i ia = _mm_set1_epi16(255 - opacity);
+    for (; i + 16 <= len; i += 16) {
+        __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+        __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(s, zero), a), _mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), ia));
+        __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(s, zero), a), _mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), ia));
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_packus_epi16(div255(lo), div255(hi)));
+    }
+#endif
+    for (; i < len; i++) {
+        dst[i] = div255(src[i] * opacity + dst[i] * (255 - opacity));
+    }
+}
+
+// dst = dst * src / 255
+static void blendMultiply(uint8_t* dst, const uint8_t* src, int len) {
+    int i = 0;
+#if defined(__ARM_NEON)
+    for (; i + 16 <= len; i += 16) {
+        uint8x16_t s = vld1q_u8(src + i);
+        uint8x16_t d = vld1q_u8(dst + i);
+        uint16x8_t lo = vmull_u8(vget_low_u8(s), vget_low_u8(d));
+        uint16x8_t hi = vmull_u8(vget_high_u8(s), vget_high_u8(d));
+        vst1q_u8(dst + i, vcombine_u8(div255(lo), div255(hi)));
+    }
+#elif defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= len; i += 16) {
+        __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+        __m128i lo = _mm_mullo_epi16(_mm_unpacklo_epi8(s, zero), _mm_unpacklo_epi8(d, zero));
+        __m128i hi = _mm_mullo_epi16(_mm_unpackhi_epi8(s, zero), _mm_unpackhi_epi8(d, zero));
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_packus_epi16(div255(lo), div255(hi)));
+    }
+#endif
+    for (; i < len; i++) {
+        dst[i] = div255(src[i] * dst[i]);
+    }
+}
+
+// Saturating add, saturating subtract and max all map to a single
+// instruction on both NEON and SSE2
+#if defined(__ARM_NEON)
+#define BLEND_BYTEWISE(fname, simd, scalar)                           \
+    static void fname(uint8_t* dst, const uint8_t* src, int len) {    \
+        int i = 0;                                                    \
+        for (; i + 16 <= len; i += 16) {                              \
+            uint8x16_t s = vld1q_u8(src + i);                         \
+            uint8x16_t d = vld1q_u8(dst + i);                         \
+            vst1q_u8(dst + i, simd##_neon(d, s));                     \
+        }                                                             \
+        for (; i < len; i++) {                                        \
+            dst[i] = scalar(dst[i], src[i]);                          \
+        }                                                             \
+    }
+#define blendAdd_neon vqaddq_u8
+#define blendSubtract_neon vqsubq_u8
+#define blendMax_neon vmaxq_u8
+#elif defined(__SSE2__)
+#define BLEND_BYTEWISE(fname, simd, scalar)                                      \
+    static void fname(uint8_t* dst, const uint8_t* src, int len) {               \
+        int i = 0;                                                               \
+        for (; i + 16 <= len; i += 16) {                                         \
+            __m128i s = _mm_loadu_si128((const __m128i*)(src + i));              \
+            __m128i d = _mm_loadu_si128((const __m128i*)(dst + i));              \
+            _mm_storeu_si128((__m128i*)(dst + i), simd##_sse(d, s));             \
+        }                                                                        \
+        for (; i < len; i++) {                                                   \
+            dst[i] = scalar(dst[i], src[i]);                                     \
+        }                                                                        \
+    }
+#define blendAdd_sse _mm_adds_epu8
+#define blendSubtract_sse _mm_subs_epu8
+#define blendMax_sse _mm_max_epu8
+#else
+#define BLEND_BYTEWISE(fname, simd, scalar)                        \
+    static void fname(uint8_t* dst, const uint8_t* src, int len) { \
+        for (int i = 0; i < len; i++) {                            \
+            dst[i] = scalar(dst[i], src[i]);                       \
+        }                                                          \
+    }
+#endif
+static inline uint8_t addSaturate(uint8_t d, uint8_t s) { return std::min(d + s, 255); }
+static inline uint8_t subSaturate(uint8_t d, uint8_t s) { return d > s ? d - s : 0; }
+static inline uint8_t maxValue(uint8_t d, uint8_t s) { return std::max(d, s); }
+BLEND_BYTEWISE(blendAdd, blendAdd, addSaturate)
+BLEND_BYTEWISE(blendSubtract, blendSubtract, subSaturate)
+BLEND_BYTEWISE(blendMax, blendMax, maxValue)
+
+// Applies src onto dst using the blend for the given PixelOverlayState
+static void blendChannels(int st, uint8_t* dst, const uint8_t* src, int len, uint8_t opacity) {
+    switch (st) {
+    case PixelOverlayState::Enabled:
+        memcpy(dst, src, len);
+        break;
+    case PixelOverlayState::Transparent:
+        copyTransparent(dst, src, len);
+        break;
+    case PixelOverlayState::TransparentRGB:
+        copyTransparentRGB(dst, src, len);
+        break;
+    case PixelOverlayState::Alpha:
+        if (opacity == 255) {
+            memcpy(dst, src, len);
+        } else if (opacity) {
+            blendAlpha(dst, src, len, opacity);
+        }
+        break;
+    case PixelOverlayState::Add:
+        blendAdd(dst, src, len);
+        break;
+    case PixelOverlayState::Max:
+        blendMax(dst, src, len);
+        break;
+    case PixelOverlayState::Multiply:
+        blendMultiply(dst, src, len);
+        break;
+    case PixelOverlayState::Subtract:
+        blendSubtract(dst, src, len);
+        break;
+    }
+}
+
 PixelOverlayModel::PixelOverlayModel(const Json::Value& c) :
     config(c),
     overlayBufferData(nullptr),
@@ -263,6 +495,7 @@ PixelOverlayModel::PixelOverlayModel(const Json::Value& c) :
             }
         }
     }
+    buildChannelSpans();
 }
 PixelOverlayModel::~PixelOverlayModel() {
     if (channelData) {
@@ -278,7 +511,7 @@ PixelOverlayModel::~PixelOverlayModel() {
         shm_unlink(dataName.c_str());
     }
     if (overlayBufferData) {
-        munmap(overlayBufferData, width * height * 3 + sizeof(OverlayBufferData));
+        munmap(overlayBufferData, PixelOverlayBufferSize(width, height));
         std::string overlayBufferName = "/FPP-Model-Overlay-Buffer-" + name;
         if (PSHMNAMLEN <= 48) {
             // system doesn't allow very long shared memory names, we'll use a shortened form
@@ -291,6 +524,56 @@ PixelOverlayModel::~PixelOverlayModel() {
     }
 }
 
+void PixelOverlayModel::buildChannelSpans() {
+    channelSpans.clear();
+    rowSpans.resize(height + 1);
+    uint32_t rowLen = width * 3;
+    for (int y = 0; y < height; y++) {
+        rowSpans[y] = channelSpans.size();
+        uint32_t base = y * rowLen;
+        for (uint32_t x = 0; x < rowLen; x++) {
+            uint32_t ch = channelMap[base + x];
+            if (ch == FPPD_OFF_CHANNEL || ch >= (uint32_t)channelCount) {
+                continue;
+            }
+            if (channelSpans.size() > rowSpans[y]) {
+                ChannelSpan& span = channelSpans.back();
+                if ((span.src + span.len == base + x) && (span.dst + span.len == ch)) {
+                    span.len++;
+                    continue;
+                }
+            }
+            channelSpans.push_back({ base + x, ch, 1 });
+        }
+    }
+    rowSpans[height] = channelSpans.size();
+    LogDebug(VB_CHANNELOUT, "Model %s mapped to %d channel spans\n", name.c_str(), (int)channelSpans.size());
+}
+
+// Calls f(src, dst, len) for each span, clipped to the w x h region at x,y.
+// src is relative to the top left of the region in a w*3 stride buffer.
+template<class F>
+void PixelOverlayModel::forEachSpan(int x, int y, int w, int h, F&& f) const {
+    uint32_t rowLen = width * 3;
+    for (int yPos = y; yPos < (y + h); yPos++) {
+        uint32_t start = yPos * rowLen + x * 3;
+        uint32_t end = start + w * 3;
+        uint32_t rowOffset = (yPos - y) * w * 3;
+        auto it = std::upper_bound(channelSpans.begin() + rowSpans[yPos], channelSpans.begin() + rowSpans[yPos + 1], start,
+                                   [](uint32_t v, const ChannelSpan& span) { return v < span.src; });
+        if (it != channelSpans.begin() + rowSpans[yPos]) {
+            --it;
+        }
+        for (auto last = channelSpans.begin() + rowSpans[yPos + 1]; it != last && it->src < end; ++it) {
+            uint32_t s = std::max(it->src, start);
+            uint32_t e = std::min(it->src + it->len, end);
+            if (s < e) {
+                f(rowOffset + s - start, it->dst + s - it->src, e - s);
+            }
+        }
+    }
+}
+
 PixelOverlayState PixelOverlayModel::getState() const {
     return state;
 }
@@ -311,7 +594,10 @@ void PixelOverlayModel::setState(const PixelOverlayState& st) {
     state = st;
     PixelOverlayManager::INSTANCE.modelStateChanged(this, old, state);
 }
-void PixelOverlayModel::setChildState(const std::string& n, const PixelOverlayState& st, int ox, int oy, int w, int h) {
+void PixelOverlayModel::setOpacity(int o) {
+    opacity = std::clamp(o, 0, 255);
+}
+void PixelOverlayModel::setChildState(const std::string& n, const PixelOverlayState& st, int ox, int oy, int w, int h, int o) {
     bool hadChildren = !children.empty();
 
     auto it = children.begin();
@@ -329,6 +615,7 @@ void PixelOverlayModel::setChildState(const std::string& n, const PixelOverlaySt
                 it->yoffset = oy;
                 it->width = w;
                 it->height = h;
+                it->opacity = std::clamp(o, 0, 255);
             }
         }
         it++;
@@ -342,6 +629,7 @@ void PixelOverlayModel::setChildState(const std::string& n, const PixelOverlaySt
         cms.yoffset = oy;
         cms.width = w;
         cms.height = h;
+        cms.opacity = std::clamp(o, 0, 255);
         children.push_back(cms);
     }
     bool hasChildren = !children.empty();
@@ -358,55 +646,9 @@ bool PixelOverlayModel::flushChildren(uint8_t* dst) {
     }
     for (auto& c : children) {
         int cst = c.state.getState();
-        for (int y = 0; y < c.height; y++) {
-            int yoff = (y + c.yoffset) * width * 3;
-            for (int x = 0; x < c.width; x++) {
-                int offr = (x + c.xoffset) * 3 + yoff;
-                int offg = offr + 1;
-                int offb = offr + 2;
-
-                switch (cst) {
-                case 1:
-                    if (channelMap[offr] != FPPD_OFF_CHANNEL) {
-                        dst[channelMap[offr]] = channelData[channelMap[offr]];
-                    }
-                    if (channelMap[offg] != FPPD_OFF_CHANNEL) {
-                        dst[channelMap[offg]] = channelData[channelMap[offg]];
-                    }
-                    if (channelMap[offb] != FPPD_OFF_CHANNEL) {
-                        dst[channelMap[offb]] = channelData[channelMap[offb]];
-                    }
-                    break;
-                case 2:
-                    if (channelMap[offr] != FPPD_OFF_CHANNEL && channelData[channelMap[offr]]) {
-                        dst[channelMap[offr]] = channelData[channelMap[offr]];
-                    }
-                    if (channelMap[offg] != FPPD_OFF_CHANNEL && channelData[channelMap[offg]]) {
-                        dst[channelMap[offg]] = channelData[channelMap[offg]];
-                    }
-                    if (channelMap[offb] != FPPD_OFF_CHANNEL && channelData[channelMap[offb]]) {
-                        dst[channelMap[offb]] = channelData[channelMap[offb]];
-                    }
-                    break;
-                case 3:
-                    bool cp = channelMap[offr] != FPPD_OFF_CHANNEL && channelData[channelMap[offr]];
-                    cp |= channelMap[offg] != FPPD_OFF_CHANNEL && channelData[channelMap[offg]];
-                    cp |= channelMap[offb] != FPPD_OFF_CHANNEL && channelData[channelMap[offb]];
-                    if (cp) {
-                        if (channelMap[offr] != FPPD_OFF_CHANNEL && channelData[channelMap[offr]]) {
-                            dst[channelMap[offr]] = channelData[offr];
-                        }
-                        if (channelMap[offg] != FPPD_OFF_CHANNEL && channelData[offg]) {
-                            dst[channelMap[offg]] = channelData[offg];
-                        }
-                        if (channelMap[offb] != FPPD_OFF_CHANNEL && channelData[offb]) {
-                            dst[channelMap[offb]] = channelData[offb];
-                        }
-                    }
-                    break;
-                }
-            }
-        }
+        forEachSpan(c.xoffset, c.yoffset, c.width, c.height, [&](uint32_t, uint32_t ch, uint32_t len) {
+            blendChannels(cst, &dst[ch], &channelData[ch], len, c.opacity);
+        });
     }
     return true;
 }
@@ -422,45 +664,33 @@ void PixelOverlayModel::doOverlay(uint8_t* channels) {
         dirtyBuffer = false;
         return;
     }
-    if (((st == 2) || (st == 3)) &&
+    if ((st >= 2) &&
         (!IsEffectRunning()) &&
         (!sequence->IsSequenceRunning()) &&
         !PluginManager::INSTANCE.hasPlugins()) {
-        //there is nothing running that we would be overlaying so do a straight copy
-        st = 1;
+        //there is nothing running that we would be overlaying
+        if (st <= 3) {
+            //so do a straight copy
+            st = 1;
+        } else {
+            //the channels may not be refreshed, blend over black so
+            //the result doesn't accumulate from frame to frame
+            memset(dst, 0, channelCount);
+        }
     }
 
-    uint8_t* src = channelData;
-    switch (st) {
-    case 1: //Active - Opaque
-        memcpy(dst, src, channelCount);
-        break;
-    case 2: //Active Transparent
-        for (int j = 0; j < channelCount; j++, src++, dst++) {
-            if (*src) {
-                *dst = *src;
-            }
-        }
-        break;
-    case 3: //Active Transparent RGB {
-        for (int j = 0; j < channelCount; j += 3, src += 3, dst += 3) {
-            if (src[0] || src[1] || src[2]) {
-                dst[0] = src[0];
-                dst[1] = src[1];
-                dst[2] = src[2];
-            }
-        }
-        break;
+    int len = channelCount;
+    if (st == PixelOverlayState::TransparentRGB) {
+        len -= len % 3;
     }
+    blendChannels(st, dst, channelData, len, opacity);
 
     dirtyBuffer = false;
 }
 
 void PixelOverlayModel::setData(const uint8_t* data) {
-    for (int c = 0; c < (width * height * 3); c++) {
-        if (channelMap[c] != FPPD_OFF_CHANNEL) {
-            channelData[channelMap[c]] = data[c];
-        }
+    for (auto& span : channelSpans) {
+        memcpy(&channelData[span.dst], &data[span.src], span.len);
     }
     dirtyBuffer = true;
 }
@@ -488,39 +718,14 @@ void PixelOverlayModel::setData(const uint8_t* data, int xOffset, int yOffset, i
     }
 
     int cst = st.getState();
-    int rowWrap = (width - w) * 3;
-    int s = 0;
-    int c = (yOffset * width * 3) + (xOffset * 3);
-    for (int yPos = 0; yPos < h; yPos++) {
-        for (int xPos = 0; xPos < w; xPos++) {
-            if (cst == 1) {
-                for (int i = 0; i < 3; i++, c++, s++) {
-                    if (channelMap[c] != FPPD_OFF_CHANNEL) {
-                        channelData[channelMap[c]] = data[s];
-                    }
-                }
-            } else if (cst == 2) {
-                for (int i = 0; i < 3; i++, c++, s++) {
-                    if (data[s] && channelMap[c] != FPPD_OFF_CHANNEL) {
-                        channelData[channelMap[c]] = data[s];
-                    }
-                }
-            } else if (cst == 3) {
-                bool b = data[s] | data[s + 1] | data[s + 2];
-                if (b) {
-                    for (int i = 0; i < 3; i++, c++, s++) {
-                        if (channelMap[c] != FPPD_OFF_CHANNEL) {
-                            channelData[channelMap[c]] = data[s];
-                        }
-                    }
-                } else {
-                    s += 3;
-                    c += 3;
-                }
-            }
-        }
-        c += rowWrap;
+    if (cst > PixelOverlayState::TransparentRGB) {
+        // blending happens when the model is output, writing into
+        // channelData with it would accumulate on every update
+        cst = PixelOverlayState::Enabled;
     }
+    forEachSpan(xOffset, yOffset, w, h, [&](uint32_t s, uint32_t ch, uint32_t len) {
+        blendChannels(cst, &channelData[ch], &data[s], len, opacity);
+    });
     dirtyBuffer = true;
 }
 
@@ -677,7 +882,16 @@ void PixelOverlayModel::setBufferIsDirty(bool dirty) {
 }
 
 uint8_t* PixelOverlayModel::getOverlayBuffer() {
-    if (!overlayBufferData) {
+    OverlayBufferData* buffer = __atomic_load_n(&overlayBufferData, __ATOMIC_ACQUIRE);
+    if (buffer) {
+        return buffer->data;
+    }
+
+    // effect workers, the output thread and the http threads can all get
+    // here first, map once and publish the pointer after the sync block
+    std::unique_lock<std::mutex> lock(overlayBufferLock);
+    buffer = overlayBufferData;
+    if (!buffer) {
         std::string overlayBufferName = "/FPP-Model-Overlay-Buffer-" + name;
         if (PSHMNAMLEN <= 48) {
             // system doesn't allow very long shared memory names, we'll use a shortened form
@@ -689,15 +903,19 @@ uint8_t* PixelOverlayModel::getOverlayBuffer() {
 
         mode_t mode = S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH | S_IWOTH;
         int f = shm_open(overlayBufferName.c_str(), O_RDWR | O_CREAT, mode);
-        int size = width * height * 3 + sizeof(OverlayBufferData);
+        int size = PixelOverlayBufferSize(width, height);
         ftruncate(f, size);
-        overlayBufferData = (OverlayBufferData*)mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, f, 0);
-        memset(overlayBufferData, 0, size);
-        overlayBufferData->width = width;
-        overlayBufferData->height = height;
+        buffer = (OverlayBufferData*)mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, f, 0);
+        memset(buffer, 0, size);
+        buffer->width = width;
+        buffer->height = height;
+        overlayBufferSync = PixelOverlayBufferGetSync(buffer);
+        overlayBufferSync->version = FPP_OVERLAY_SYNC_VERSION;
+        __atomic_store_n(&overlayBufferSync->magic, FPP_OVERLAY_SYNC_MAGIC, __ATOMIC_RELEASE);
         close(f);
+        __atomic_store_n(&overlayBufferData, buffer, __ATOMIC_RELEASE);
     }
-    return overlayBufferData->data;
+    return buffer->data;
 }
 
 void PixelOverlayModel::clearOverlayBuffer() {
@@ -740,17 +958,34 @@ void PixelOverlayModel::flushOverlayBuffer() {
     setOverlayBufferDirty(false);
 }
 
+// The dirty flag publishes the overlay buffer from the effect workers
+// (or external programs) to the output thread
 bool PixelOverlayModel::overlayBufferIsDirty() {
-    return (overlayBufferData && (overlayBufferData->flags & 0x1));
+    OverlayBufferData* buffer = __atomic_load_n(&overlayBufferData, __ATOMIC_ACQUIRE);
+    return (buffer && (__atomic_load_n(&buffer->flags, __ATOMIC_ACQUIRE) & FPP_OVERLAY_BUFFER_DIRTY));
 }
 
 void PixelOverlayModel::setOverlayBufferDirty(bool dirty) {
     getOverlayBuffer();
 
     if (dirty)
-        overlayBufferData->flags |= 0x1;
+        __atomic_fetch_or(&overlayBufferData->flags, FPP_OVERLAY_BUFFER_DIRTY, __ATOMIC_RELEASE);
     else
-        overlayBufferData->flags &= ~0x1;
+        __atomic_fetch_and(&overlayBufferData->flags, ~FPP_OVERLAY_BUFFER_DIRTY, __ATOMIC_RELEASE);
+}
+
+void PixelOverlayModel::consumeOverlayBufferFrame() {
+    getOverlayBuffer();
+
+    uint32_t seq = __atomic_load_n(&overlayBufferSync->readySeq, __ATOMIC_ACQUIRE);
+    if (seq != overlayBufferSync->consumedSeq) {
+        uint32_t idx = overlayBufferSync->readyIndex & 0x1;
+        setData(PixelOverlayBufferData(overlayBufferData, idx));
+        __atomic_store_n(&overlayBufferSync->consumedSeq, seq, __ATOMIC_SEQ_CST);
+        PixelOverlayBufferWake(overlayBufferSync, &overlayBufferSync->consumedSeq);
+    }
+    __atomic_add_fetch(&overlayBufferSync->frameNumber, 1, __ATOMIC_SEQ_CST);
+    PixelOverlayBufferWake(overlayBufferSync, &overlayBufferSync->frameNumber);
 }
 
 void PixelOverlayModel::setOverlayBufferScaledData(uint8_t* data, int w, int h) {
@@ -849,10 +1084,21 @@ void PixelOverlayModel::toJson(Json::Value& result) {
     result = config;
 }
 
-int32_t PixelOverlayModel::updateRunningEffects() {
+int32_t PixelOverlayModel::updateRunningEffects(int32_t lateMS) {
     std::unique_lock<std::recursive_mutex> l(effectLock);
     if (runningEffect) {
+        uint64_t start = GetTimeMicros();
         int32_t v = runningEffect->update();
+        uint32_t us = GetTimeMicros() - start;
+
+        effectStats.updates++;
+        effectStats.totalUS += us;
+        effectStats.lastUS = us;
+        effectStats.maxUS = std::max(effectStats.maxUS, us);
+        if (lateMS > EFFECT_LATE_MS) {
+            effectStats.lateUpdates++;
+        }
+        effectStats.maxLateMS = std::max(effectStats.maxLateMS, lateMS);
         if (v == 0) {
             delete runningEffect;
             runningEffect = nullptr;
@@ -862,6 +1108,15 @@ int32_t PixelOverlayModel::updateRunningEffects() {
     return 0;
 }
 
+void PixelOverlayModel::getEffectStats(Json::Value& v) {
+    v["updates"] = effectStats.updates;
+    v["lateUpdates"] = effectStats.lateUpdates;
+    v["maxLateMS"] = effectStats.maxLateMS;
+    v["lastRenderUS"] = effectStats.lastUS;
+    v["maxRenderUS"] = effectStats.maxUS;
+    v["avgRenderUS"] = effectStats.updates ? (Json::UInt)(effectStats.totalUS / effectStats.updates) : 0;
+}
+
 void PixelOverlayModel::setRunningEffect(RunningEffect* ef, int32_t firstUpdateMS) {
     std::unique_lock<std::recursive_mutex> l(effectLock);
     if (runningEffect) {
@@ -870,7 +1125,11 @@ void PixelOverlayModel::setRunningEffect(RunningEffect* ef, int32_t firstUpdateM
         }
         PixelOverlayManager::INSTANCE.removePeriodicUpdate(this);
     }
+    if (runningEffect != ef) {
+        effectStats = EffectStats();
+    }
     runningEffect = ef;
+    serialEffect = ef && ef->requiresSerialUpdates();
     PixelOverlayManager::INSTANCE.addPeriodicUpdate(firstUpdateMS, this);
 }
 
@@ -11,10 +11,13 @@
  * included LICENSE.LGPL file.
  */
 
+#include <atomic>
 #include <list>
 #include <mutex>
 #include <thread>
 
+#include "PixelOverlayBuffer.h"
+
 class RunningEffect;
 
 class PixelOverlayState {
@@ -23,7 +26,12 @@ public:
         Disabled,
         Enabled,
         Transparent,
-        TransparentRGB
+        TransparentRGB,
+        Alpha,    // dst + (src - dst) * opacity
+        Add,      // dst + src, saturated
+        Max,      // max(dst, src)
+        Multiply, // dst * src / 255
+        Subtract  // dst - src, saturated
     };
 
     PixelOverlayState() :
@@ -41,6 +49,16 @@ public:
             state = PixelState::Transparent;
         } else if (v == "TransparentRGB" || v == "Transparent RGB") {
             state = PixelState::TransparentRGB;
+        } else if (v == "Alpha") {
+            state = PixelState::Alpha;
+        } else if (v == "Add") {
+            state = PixelState::Add;
+        } else if (v == "Max") {
+            state = PixelState::Max;
+        } else if (v == "Multiply") {
+            state = PixelState::Multiply;
+        } else if (v == "Subtract") {
+            state = PixelState::Subtract;
         } else {
             state = PixelState::Disabled;
         }
@@ -72,6 +90,10 @@ public:
     PixelOverlayState getState() const;
     virtual void setState(const PixelOverlayState& state);
 
+    // 0-255, used by the Alpha state
+    int getOpacity() const { return opacity; }
+    virtual void setOpacity(int opacity);
+
     virtual void doOverlay(uint8_t* channels);
 
     int getStartChannel() const;
@@ -107,6 +129,9 @@ public:
     void setOverlayPixelValue(int x, int y, int r, int g, int b);
     void getOverlayPixelValue(int x, int y, int& r, int& g, int& b);
     void flushOverlayBuffer();
+    // Called once per output frame, copies in a frame published through
+    // the PixelOverlayBufferSync handoff
+    void consumeOverlayBufferFrame();
 
     // Operate on both the overlay buffer (if mapped) and the channelData
     void clear();
@@ -117,19 +142,26 @@ public:
     
     std::recursive_mutex& getRunningEffectMutex() { return effectLock; }
     RunningEffect* getRunningEffect() const { return runningEffect; } // make sure you have the mutex locked
-    int32_t updateRunningEffects();
+    bool hasSerialEffect() const { return serialEffect; }
+    int32_t updateRunningEffects(int32_t lateMS = 0);
+    void getEffectStats(Json::Value& v); // make sure you have the mutex locked
 
-    void setChildState(const std::string& n, const PixelOverlayState& state, int ox, int oy, int w, int h);
+    void setChildState(const std::string& n, const PixelOverlayState& state, int ox, int oy, int w, int h, int opacity = 255);
 
 protected:
     void setValue(uint8_t v, int startChannel = -1, int endChannel = -1);
     bool flushChildren(uint8_t* dst);
 
+    void buildChannelSpans();
+    template<class F>
+    void forEachSpan(int x, int y, int w, int h, F&& f) const;
+
     Json::Value config;
     std::string name;
     std::string type;
     int width, height;
     PixelOverlayState state;
+    uint8_t opacity = 255;
     int startChannel;
     int channelCount;
     int channelsPerNode;
@@ -137,18 +169,39 @@ protected:
     std::vector<uint32_t> channelMap;
     uint8_t* channelData;
 
+    // Runs of the width*height*3 buffer that map to consecutive channels
+    // in channelData, built from the channelMap when the model is loaded.
+    // Spans never cross a row, rowSpans[y] is the first span of row y.
+    struct ChannelSpan {
+        uint32_t src; // offset in the width*height*3 buffer
+        uint32_t dst; // offset in channelData
+        uint32_t len;
+    };
+    std::vector<ChannelSpan> channelSpans;
+    std::vector<uint32_t> rowSpans;
+
     volatile bool dirtyBuffer = false;
 
-    struct OverlayBufferData {
-        uint32_t width;
-        uint32_t height;
-        uint32_t flags;
-        uint8_t data[4];
-    } __attribute__((__packed__));
-    OverlayBufferData* overlayBufferData;
+    typedef PixelOverlayBuffer OverlayBufferData;
+    OverlayBufferData* overlayBufferData; // mapped on first use, published with __atomic_store_n
+    PixelOverlayBufferSync* overlayBufferSync = nullptr;
+    std::mutex overlayBufferLock;
 
     std::recursive_mutex effectLock;
     RunningEffect* runningEffect;
+    std::atomic_bool serialEffect = false; // runningEffect->requiresSerialUpdates()
+
+    // Render times of the current runningEffect
+    class EffectStats {
+    public:
+        uint32_t updates = 0;
+        uint32_t lateUpdates = 0;
+        int32_t maxLateMS = 0;
+        uint64_t totalUS = 0;
+        uint32_t lastUS = 0;
+        uint32_t maxUS = 0;
+    };
+    EffectStats effectStats;
 
     class ChildModelState {
     public:
@@ -158,6 +211,7 @@ protected:
         int yoffset = 0;
         int width = 0;
         int height = 0;
+        uint8_t opacity = 255;
     };
     std::list<ChildModelState> children;
 };
@@ -47,7 +47,13 @@ bool PixelOverlayModelSub::foundParent() {
 void PixelOverlayModelSub::setState(const PixelOverlayState& st) {
     PixelOverlayModel::setState(st);
     if (foundParent()) {
-        parent->setChildState(name, st, xOffset, yOffset, width, height);
+        parent->setChildState(name, st, xOffset, yOffset, width, height, opacity);
+    }
+}
+void PixelOverlayModelSub::setOpacity(int o) {
+    PixelOverlayModel::setOpacity(o);
+    if (state.getState() && foundParent()) {
+        parent->setChildState(name, state, xOffset, yOffset, width, height, opacity);
     }
 }
 
@@ -22,6 +22,7 @@ public:
     virtual void setData(const uint8_t* data) override;
 
     virtual void setState(const PixelOverlayState& st) override;
+    virtual void setOpacity(int o) override;
 
 private:
     bool foundParent();
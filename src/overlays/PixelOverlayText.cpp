@@ -0,0 +1,271 @@
+/*
+ * This file is part of the Falcon Player (FPP) and is Copyright (C)
+ * 2013-2022 by the Falcon Player Developers.
+ *
+ * The Falcon Player (FPP) is free software, and is covered under
+ * multiple Open Source licenses.  Please see the included 'LICENSES'
+ * file for descriptions of what files are covered by each license.
+ *
+ * This source file is covered under the LGPL v2.1 as described in the
+ * included LICENSE.LGPL file.
+ */
+
+#include "fpp-pch.h"
+
+#include <Magick++/Color.h>
+#include <Magick++/Geometry.h>
+#include <Magick++/Image.h>
+#include <Magick++/Include.h>
+#include <Magick++/TypeMetric.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string.h>
+#include <string>
+
+#include "../log.h"
+
+#include "PixelOverlayText.h"
+
+#define MAX_CACHED_RASTERS 64
+#define MAX_CACHED_RASTER_BYTES (16 * 1024 * 1024)
+
+// Characters that can be put together from single glyphs without
+// noticeably differing from rendering the whole string
+static const char* COMPOSABLE_CHARS = "0123456789:.,-+/% ";
+
+PixelOverlayTextCache PixelOverlayTextCache::INSTANCE;
+
+void TextRaster::toRGB(uint8_t* dst, int r, int g, int b) const {
+    int count = width * height;
+    for (int x = 0; x < count; x++, dst += 3) {
+        uint32_t c = coverage[x];
+        dst[0] = (c * r + 127) / 255;
+        dst[1] = (c * g + 127) / 255;
+        dst[2] = (c * b + 127) / 255;
+    }
+}
+
+static void setupImage(Magick::Image& image, const std::string& font, int fontSize, bool antialias) {
+    image.quiet(true);
+    image.depth(8);
+    image.font(font);
+    image.fontPointsize(fontSize);
+    image.antiAlias(antialias);
+    image.strokeAntiAlias(antialias);
+    image.fillColor(Magick::Color("white"));
+}
+
+// The text is drawn in white so any channel is the coverage
+static void readCoverage(Magick::Image& image, std::vector<uint8_t>& coverage) {
+    image.modifyImage();
+    int count = image.columns() * image.rows();
+    const MagickLib::PixelPacket* pixels = image.getConstPixels(0, 0, image.columns(), image.rows());
+    coverage.resize(count);
+    for (int x = 0; x < count; x++) {
+        coverage[x] = Magick::Color::scaleQuantumToDouble(pixels[x].red) * 255;
+    }
+}
+
+static bool isComposable(const std::string& msg) {
+    return !msg.empty() && msg.find_first_not_of(COMPOSABLE_CHARS) == std::string::npos;
+}
+
+static std::string cacheKey(const std::string& font, int fontSize, bool antialias,
+                            const std::string& msg, int w, int h) {
+    return font + "|" + std::to_string(fontSize) + "|" + (antialias ? "1" : "0") + "|" + std::to_string(w) + "x" + std::to_string(h) + "|" + msg;
+}
+
+PixelOverlayTextCache::PixelOverlayTextCache() {
+}
+PixelOverlayTextCache::~PixelOverlayTextCache() {
+}
+
+std::shared_ptr<const TextRaster> PixelOverlayTextCache::getText(const std::string& font, int fontSize, bool antialias,
+                                                                 const std::string& msg) {
+    std::unique_lock<std::mutex> l(lock);
+    std::string key = cacheKey(font, fontSize, antialias, msg, 0, 0);
+    auto it = rasters.find(key);
+    if (it != rasters.end()) {
+        lru.splice(lru.begin(), lru, it->second);
+        hits++;
+        return it->second->second;
+    }
+    std::shared_ptr<TextRaster> r;
+    if (isComposable(msg)) {
+        r = composeText(font, fontSize, antialias, msg);
+    } else {
+        r = renderText(font, fontSize, antialias, msg, 0, 0);
+    }
+    addToCache(key, r);
+    return r;
+}
+
+std::shared_ptr<const TextRaster> PixelOverlayTextCache::getCenteredText(const std::string& font, int fontSize, bool antialias,
+                                                                         const std::string& msg, int w, int h) {
+    std::unique_lock<std::mutex> l(lock);
+    std::string key = cacheKey(font, fontSize, antialias, msg, w, h);
+    auto it = rasters.find(key);
+    if (it != rasters.end()) {
+        lru.splice(lru.begin(), lru, it->second);
+        hits++;
+        return it->second->second;
+    }
+    std::shared_ptr<TextRaster> r;
+    if (isComposable(msg)) {
+        std::shared_ptr<TextRaster> text = composeText(font, fontSize, antialias, msg);
+        r = std::make_shared<TextRaster>();
+        r->width = w;
+        r->height = h;
+        r->ascent = text->ascent;
+        r->coverage.resize(w * h);
+        int xoff = (w - text->width) / 2;
+        int yoff = (h - text->height) / 2;
+        for (int y = 0; y < text->height; y++) {
+            int dy = y + yoff;
+            if (dy < 0 || dy >= h) {
+                continue;
+            }
+            int sx = std::max(0, -xoff);
+            int ex = std::min(text->width, w - xoff);
+            if (ex > sx) {
+                memcpy(&r->coverage[dy * w + sx + xoff], &text->coverage[y * text->width + sx], ex - sx);
+            }
+        }
+    } else {
+        r = renderText(font, fontSize, antialias, msg, w, h);
+    }
+    addToCache(key, r);
+    return r;
+}
+
+void PixelOverlayTextCache::clear() {
+    std::unique_lock<std::mutex> l(lock);
+    lru.clear();
+    rasters.clear();
+    rasterBytes = 0;
+    glyphSets.clear();
+}
+
+void PixelOverlayTextCache::addToCache(const std::string& key, std::shared_ptr<TextRaster> r) {
+    lru.emplace_front(key, r);
+    rasters[key] = lru.begin();
+    rasterBytes += r->coverage.size();
+    while (lru.size() > 1 && (lru.size() > MAX_CACHED_RASTERS || rasterBytes > MAX_CACHED_RASTER_BYTES)) {
+        rasterBytes -= lru.back().second->coverage.size();
+        rasters.erase(lru.back().first);
+        lru.pop_back();
+    }
+}
+
+std::shared_ptr<TextRaster> PixelOverlayTextCache::renderText(const std::string& font, int fontSize, bool antialias,
+                                                              const std::string& msg, int w, int h) {
+    Magick::Image image(Magick::Geometry(1, 1), Magick::Color("black"));
+    setupImage(image, font, fontSize, antialias);
+
+    int maxWid = 0;
+    int totalHi = 0;
+    Magick::TypeMetric metrics;
+    int last = 0;
+    for (int x = 0; x < msg.length(); x++) {
+        if (msg[x] == '\n' || ((x < msg.length() - 1) && msg[x] == '\\' && msg[x + 1] == 'n')) {
+            image.fontTypeMetrics(msg.substr(last, x - last), &metrics);
+            maxWid = std::max(maxWid, (int)metrics.textWidth());
+            totalHi += (int)metrics.textHeight();
+            if (msg[x] == '\n') {
+                last = x + 1;
+            } else {
+                last = x + 2;
+            }
+        }
+    }
+    image.fontTypeMetrics(msg.substr(last), &metrics);
+    maxWid = std::max(maxWid, (int)metrics.textWidth());
+    totalHi += (int)metrics.textHeight();
+
+    std::shared_ptr<TextRaster> r = std::make_shared<TextRaster>();
+    r->width = std::max(1, w ? w : maxWid);
+    r->height = std::max(1, h ? h : totalHi);
+    r->ascent = metrics.ascent();
+
+    Magick::Image canvas(Magick::Geometry(r->width, r->height), Magick::Color("black"));
+    setupImage(canvas, font, fontSize, antialias);
+    canvas.annotate(msg, Magick::CenterGravity);
+    readCoverage(canvas, r->coverage);
+
+    rendered++;
+    LogExcess(VB_CHANNELOUT, "Rendered text '%s' (%d rendered, %d composed, %d cached)\n", msg.c_str(), rendered, composed, hits);
+    return r;
+}
+
+const PixelOverlayTextCache::Glyph* PixelOverlayTextCache::getGlyph(GlyphSet& set, const std::string& font, int fontSize, bool antialias, char c) {
+    auto it = set.glyphs.find(c);
+    if (it != set.glyphs.end()) {
+        return &it->second;
+    }
+    Magick::Image image(Magick::Geometry(1, 1), Magick::Color("black"));
+    setupImage(image, font, fontSize, antialias);
+    Magick::TypeMetric metrics;
+    Glyph& g = set.glyphs[c];
+    if (c == ' ') {
+        // a lone space may be measured as empty, measure it between digits
+        Magick::TypeMetric m2;
+        image.fontTypeMetrics("0 0", &metrics);
+        image.fontTypeMetrics("00", &m2);
+        g.advance = metrics.textWidth() - m2.textWidth();
+    } else {
+        image.fontTypeMetrics(std::string(1, c), &metrics);
+        g.advance = metrics.textWidth();
+    }
+    if (set.height == 0) {
+        set.height = std::max(1, (int)metrics.textHeight());
+        set.ascent = metrics.ascent();
+    }
+    g.width = std::max(1, (int)std::ceil(g.advance));
+    if (c == ' ') {
+        g.coverage.resize(g.width * set.height);
+    } else {
+        Magick::Image canvas(Magick::Geometry(g.width, set.height), Magick::Color("black"));
+        setupImage(canvas, font, fontSize, antialias);
+        canvas.annotate(std::string(1, c), Magick::NorthWestGravity);
+        readCoverage(canvas, g.coverage);
+    }
+    return &g;
+}
+
+std::shared_ptr<TextRaster> PixelOverlayTextCache::composeText(const std::string& font, int fontSize, bool antialias,
+                                                               const std::string& msg) {
+    GlyphSet& set = glyphSets[font + "|" + std::to_string(fontSize) + "|" + (antialias ? "1" : "0")];
+    std::vector<const Glyph*> glyphs;
+    float width = 0;
+    for (auto c : msg) {
+        const Glyph* g = getGlyph(set, font, fontSize, antialias, c);
+        glyphs.push_back(g);
+        width += g->advance;
+    }
+
+    std::shared_ptr<TextRaster> r = std::make_shared<TextRaster>();
+    r->width = std::max(1, (int)std::ceil(width));
+    r->height = set.height;
+    r->ascent = set.ascent;
+    r->coverage.resize(r->width * r->height);
+
+    float x = 0;
+    for (auto g : glyphs) {
+        int x0 = std::lround(x);
+        int cols = std::min(g->width, r->width - x0);
+        x += g->advance;
+        if (cols <= 0) {
+            continue;
+        }
+        for (int y = 0; y < r->height; y++) {
+            const uint8_t* src = &g->coverage[y * g->width];
+            uint8_t* dst = &r->coverage[y * r->width + x0];
+            for (int gx = 0; gx < cols; gx++) {
+                dst[gx] = std::max(dst[gx], src[gx]);
+            }
+        }
+    }
+    composed++;
+    return r;
+}
@@ -0,0 +1,88 @@
+#pragma once
+/*
+ * This file is part of the Falcon Player (FPP) and is Copyright (C)
+ * 2013-2022 by the Falcon Player Developers.
+ *
+ * The Falcon Player (FPP) is free software, and is covered under
+ * multiple Open Source licenses.  Please see the included 'LICENSES'
+ * file for descriptions of what files are covered by each license.
+ *
+ * This source file is covered under the LGPL v2.1 as described in the
+ * included LICENSE.LGPL file.
+ */
+
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Rendered text stored as 8 bit coverage so the color is only applied
+// when it is copied out
+class TextRaster {
+public:
+    int width = 0;
+    int height = 0;
+    int ascent = 0; // of the last line
+    std::vector<uint8_t> coverage;
+
+    // dst is width * height * 3
+    void toRGB(uint8_t* dst, int r, int g, int b) const;
+};
+
+// Caches rendered text so updating or re-scrolling a message doesn't go
+// back through GraphicsMagick.  Strings that miss the cache and only use
+// characters that don't kern (digits and clock/date punctuation) are put
+// together from individually rendered glyphs so clocks and countdowns
+// never need a full render once their digits have been seen.
+class PixelOverlayTextCache {
+public:
+    static PixelOverlayTextCache INSTANCE;
+
+    // msg rendered on a canvas just big enough for it, lines are centered
+    std::shared_ptr<const TextRaster> getText(const std::string& font, int fontSize, bool antialias,
+                                              const std::string& msg);
+    // msg rendered centered on a w x h canvas
+    std::shared_ptr<const TextRaster> getCenteredText(const std::string& font, int fontSize, bool antialias,
+                                                      const std::string& msg, int w, int h);
+
+    void clear();
+
+private:
+    class Glyph {
+    public:
+        int width = 0;
+        float advance = 0;
+        std::vector<uint8_t> coverage;
+    };
+    class GlyphSet {
+    public:
+        int height = 0;
+        int ascent = 0;
+        std::map<char, Glyph> glyphs;
+    };
+
+    PixelOverlayTextCache();
+    ~PixelOverlayTextCache();
+
+    std::shared_ptr<TextRaster> renderText(const std::string& font, int fontSize, bool antialias,
+                                           const std::string& msg, int w, int h);
+    std::shared_ptr<TextRaster> composeText(const std::string& font, int fontSize, bool antialias,
+                                            const std::string& msg);
+    const Glyph* getGlyph(GlyphSet& set, const std::string& font, int fontSize, bool antialias, char c);
+
+    void addToCache(const std::string& key, std::shared_ptr<TextRaster> r);
+
+    std::mutex lock;
+    std::list<std::pair<std::string, std::shared_ptr<TextRaster>>> lru;
+    std::unordered_map<std::string, std::list<std::pair<std::string, std::shared_ptr<TextRaster>>>::iterator> rasters;
+    size_t rasterBytes = 0;
+    std::map<std::string, GlyphSet> glyphSets;
+
+    uint32_t hits = 0;
+    uint32_t composed = 0;
+    uint32_t rendered = 0;
+};
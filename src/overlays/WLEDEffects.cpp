@@ -41,6 +41,10 @@ public:
     const std::string& name() const override {
         return effectName;
     }
+    // the WLED code keeps a lot of its state in statics
+    bool requiresSerialUpdates() const override {
+        return true;
+    }
 
     virtual int32_t doIteration() = 0;
 
@@ -459,7 +463,7 @@ public:
             wled->service();
             WS2812FXExt::popCurrent();
 
-            wled->model->flushOverlayBuffer();
+            wled->flush();
             // no sense updating faster than the output
             float f = 1000.0f / GetChannelOutputRefreshRate();
             int i = f;
@@ -960,11 +960,19 @@ public:
     int mapping = 0;
     int brightness = 127;
 
+    // Effects draw into pixels (0x00RRGGBB, before brightness), flush()
+    // applies the brightness and copies them to the model once per frame
+    std::vector<uint32_t> pixels;
+    void flush();
     
     static void pushCurrent(WS2812FXExt *e);
     static void popCurrent();
 private:
     WS2812FXExt *parent = nullptr;
+
+    // byte offset of each pixel in rgb for the mapping
+    std::vector<uint32_t> offsets;
+    std::vector<uint8_t> rgb;
 };
 WS2812FXExt &strip();
 
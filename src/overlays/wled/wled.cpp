@@ -21,12 +21,17 @@
 #include <math.h>
 #include <time.h>
 
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #include "FX.h"
 #include "fcn_declare.h"
 #include "wled.h"
 
-#include "kiss_fftr.h"
-#include "../../mediaoutput/SDLOut.h"
+#include "../../mediaoutput/AudioAnalysis.h"
 
 uint16_t rand16seed = 0;
 time_t localTime = time(nullptr);
@@ -95,8 +100,6 @@ uint32_t get_millisecond_timer() {
     return GetTimeMS();
 }
 
-constexpr int NUM_SAMPLES = 1024;
-
 // RMS average
 static float fftAddAvgRMS(int from, int to, float* samples) {
     double result = 0.0;
@@ -115,34 +118,7 @@ static float mapf(float x, float in_min, float in_max, float out_min, float out_
     return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
 }
 
-/*
-static void GenerateSinWave(std::array<float, NUM_SAMPLES> &samples, float sampleRate, float frequency = 440)
-{
-    float sampleDurationSeconds = 1.0 / sampleRate;
-    for (int i = 0; i < NUM_SAMPLES; ++i) {
-        double sampleTime = (float)(i) * sampleDurationSeconds;
-        samples[i] = std::sin(2.0 * 3.14159 * frequency * sampleTime);
-    }
-}
-void HammingWindow(std::array<float, NUM_SAMPLES> &samples)
-{
-    static const double a0 = 25.0 / 46.0;
-    static const double a1 = 1 - a0;
-    for (int i = 0; i < NUM_SAMPLES; ++i)
-        samples[i] *= a0 - a1 * cos((2.0 * 3.14159 * i) / NUM_SAMPLES);
-}
-*/
-
-static um_data_t* processSamples(std::array<float, NUM_SAMPLES>& samples, int sampleRate) {
-    static kiss_fft_cpx fft_out[NUM_SAMPLES];
-    static kiss_fftr_cfg cfg = kiss_fftr_alloc(NUM_SAMPLES, false, 0, 0);
-
-    //GenerateSinWave(samples, sampleRate);
-    //HammingWindow(samples);
-
-    // compute fast fourier transform
-    kiss_fftr(cfg, (kiss_fft_scalar*)&samples[0], fft_out);
-
+static um_data_t* processAnalysis(const AudioAnalysisResult& audio) {
     static uint8_t samplePeak;
     static float FFT_MajorPeak;
     static uint8_t maxVol;
@@ -152,6 +128,10 @@ static um_data_t* processSamples(std::array<float, NUM_SAMPLES>& samples, int sa
     static float my_magnitude;
     //arrays
     static um_data_t* um_data = nullptr;
+    static uint64_t frame = (uint64_t)-1;
+    static std::mutex lock;
+
+    std::unique_lock<std::mutex> l(lock);
     if (!um_data) {
         // initialize um_data pointer structure
         // NOTE!!!
@@ -169,69 +149,23 @@ static um_data_t* processSamples(std::array<float, NUM_SAMPLES>& samples, int sa
         um_data->u_data[6] = &maxVol;
         um_data->u_data[7] = &binNum;
     }
-
-    std::array<float, 17> res;
-    for (int x = 0; x < 16; x++) {
-        res[x] = 0;
-    }
-    float rate = sampleRate;
-    int curBucket = 0;
-    double freqnext = 440.0 * exp2f(((float)((1 + 1) * 8) - 69.0) / 12.0);
-    int end = freqnext * (float)NUM_SAMPLES / rate;
-    float binHzRange = rate / (float)NUM_SAMPLES;
-
-    float maxValue = 0;
-    int maxBin = 0;
-    int maxBucket = 0;
-    for (int bin = 0; bin < (NUM_SAMPLES / 2); ++bin) {
-        if (bin > end) {
-            curBucket++;
-            if (curBucket == 18) {
-                break;
-            }
-            freqnext = 440.0 * exp2f(((double)((curBucket + 1) * 8) - 69.0) / 12.0);
-            end = freqnext * (double)NUM_SAMPLES / rate;
-        }
-        float nv = sqrtf(fft_out[bin].r * fft_out[bin].r + fft_out[bin].i * fft_out[bin].i);
-        if (nv > maxValue) {
-            maxValue = nv;
-            maxBin = bin;
-            maxBucket = curBucket;
-        }
-        res[curBucket] = std::max(res[curBucket], nv);
+    if (frame == audio.frame) {
+        // already filled in by another strip this frame
+        return um_data;
     }
+    frame = audio.frame;
 
     uint8_t* fftResult = (uint8_t*)um_data->u_data[2];
-    float maxFreq = (maxBin * binHzRange) + (binHzRange / 2);
-    int maxIdx = maxBin;
-
-    //printf("Max: %0.5f Hz   idx: %d\n", maxFreq, maxIdx);
-    int maxV = 0;
-    float maxRV = 0;
-    for (int x = 0; x < 16; x++) {
-        int v2 = round(log10(res[x]) * 120.0);
-        if (v2 > 255) {
-            v2 = 255;
-        }
-        if (v2 < 0) {
-            v2 = 0;
-        }
-        //printf("%d:   %0.2f  %0.2f    %d\n", x, res[x], (float)log10(res[x]), v2);
-        maxV = std::max(maxV, v2);
-        maxRV = std::max(maxRV, res[x]);
-        fftResult[x] = v2;
-    }
-    //printf("\n");
-    //volumeSmth = max * 127.0;
+    memcpy(fftResult, audio.bands, 16);
 
-    FFT_MajorPeak = maxFreq;
-    my_magnitude = maxRV;
-    maxVol = maxV;
-    binNum = maxBucket;
+    FFT_MajorPeak = audio.peakFrequency;
+    my_magnitude = audio.peakMagnitude;
+    maxVol = audio.maxBand;
+    binNum = audio.peakBand;
 
-    volumeSmth = maxFreq;
+    volumeSmth = audio.peakFrequency;
     volumeRaw = volumeSmth;
-    samplePeak = random8() > 250;
+    samplePeak = audio.beat;
     if (volumeSmth < 1)
         my_magnitude = 0.001f;
 
@@ -246,10 +180,9 @@ typedef enum UM_SoundSimulations {
     UMS_14_3
 } um_soundSimulations_t;
 um_data_t* simulateSound(uint8_t simulationId) {
-    std::array<float, NUM_SAMPLES> samples;
-    int sampleRate = 0;
-    if (SDLOutput::GetAudioSamples(&samples[0], NUM_SAMPLES, sampleRate)) {
-        return processSamples(samples, sampleRate);
+    AudioAnalysisResult audio = AudioAnalysis::INSTANCE.getResult();
+    if (audio.valid) {
+        return processAnalysis(audio);
     }
 
     static uint8_t samplePeak;
@@ -398,6 +331,7 @@ bool WS2812FX::deserializeMap(uint8_t n) {
 
 WS2812FXExt::WS2812FXExt() :
     WS2812FX() {
+    pixels.resize(1);
     pushCurrent(this);
     finalizeInit();
     popCurrent();
@@ -410,9 +344,31 @@ WS2812FXExt::WS2812FXExt(PixelOverlayModel* m, int map, int b,
                          const std::string& text) :
     WS2812FX(), model(m), mapping(map), brightness(b) {
     WS2812FXExt::pushCurrent(this);
-    if (m->getWidth() > 1 && m->getHeight() > 1) {
+    int w = m->getWidth();
+    int h = m->getHeight();
+    if (w > 1 && h > 1) {
         isMatrix = true;
     }
+    pixels.resize(w * h);
+    rgb.resize(w * h * 3);
+    offsets.resize(w * h);
+    for (int i = 0; i < w * h; i++) {
+        int x, y;
+        if (mapping == 1 || mapping == 3) {
+            y = i % h;
+            x = i / h;
+        } else {
+            x = i % w;
+            y = i / w;
+        }
+        if (mapping == 2) {
+            y = h - y - 1;
+        }
+        if (mapping == 3) {
+            x = w - x - 1;
+        }
+        offsets[i] = (y * w + x) * 3;
+    }
     Panel p;
     if (mapping == 0 || mapping == 2) {
         _segments.push_back(Segment(0, m->getWidth(), 0, m->getHeight()));
@@ -474,61 +430,64 @@ void WS2812FXExt::popCurrent() {
     }
 }
 
-int Bus::getLength() {
-    if (currentStrip->model) {
-        return currentStrip->model->getWidth() * currentStrip->model->getHeight();
+// data = min(data * brightness / 128, 255)
+static void scaleBrightness(uint8_t* data, int len, int brightness) {
+    // the NEON path needs it to fit in a byte, the SSE2 multiply in 16 bits
+    brightness = std::clamp(brightness, 0, 255);
+    int i = 0;
+#if defined(__ARM_NEON)
+    uint8x8_t b = vdup_n_u8(brightness);
+    for (; i + 16 <= len; i += 16) {
+        uint8x16_t d = vld1q_u8(data + i);
+        uint8x8_t lo = vqshrn_n_u16(vmull_u8(vget_low_u8(d), b), 7);
+        uint8x8_t hi = vqshrn_n_u16(vmull_u8(vget_high_u8(d), b), 7);
+        vst1q_u8(data + i, vcombine_u8(lo, hi));
     }
-    return 1;
-}
-uint32_t Bus::getPixelColor(int i) {
-    int x, y;
-    int w = currentStrip->model->getWidth();
-    int h = currentStrip->model->getHeight();
-    int mapping = currentStrip->mapping;
-    if (mapping == 1 || mapping == 3) {
-        y = i % h;
-        x = i / h;
-    } else {
-        x = i % w;
-        y = i / w;
+#elif defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i b = _mm_set1_epi16(brightness);
+    for (; i + 16 <= len; i += 16) {
+        __m128i d = _mm_loadu_si128((const __m128i*)(data + i));
+        __m128i lo = _mm_srli_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), b), 7);
+        __m128i hi = _mm_srli_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), b), 7);
+        _mm_storeu_si128((__m128i*)(data + i), _mm_packus_epi16(lo, hi));
     }
+#endif
+    for (; i < len; i++) {
+        data[i] = min(data[i] * brightness / 128, 255);
+    }
+}
 
-    if (mapping == 2) {
-        y = h - y - 1;
+void WS2812FXExt::flush() {
+    if (!model) {
+        return;
     }
-    if (mapping == 3) {
-        x = w - x - 1;
+    uint8_t* data = &rgb[0];
+    for (size_t i = 0; i < pixels.size(); i++) {
+        uint32_t c = pixels[i];
+        uint8_t* d = data + offsets[i];
+        d[0] = R(c);
+        d[1] = G(c);
+        d[2] = B(c);
     }
-
-    int r, g, b;
-    currentStrip->model->getOverlayPixelValue(x, y, r, g, b);
-    return (r << 16) | (g << 8) | b;
-}
-void Bus::setPixelColor(int i, uint32_t c) {
-    int x, y;
-    int w = currentStrip->model->getWidth();
-    int h = currentStrip->model->getHeight();
-    int mapping = currentStrip->mapping;
-    if (mapping == 1 || mapping == 3) {
-        y = i % h;
-        x = i / h;
-    } else {
-        x = i % w;
-        y = i / w;
+    if (brightness != 128) {
+        scaleBrightness(data, rgb.size(), brightness);
     }
+    model->setData(data);
+}
 
-    if (mapping == 2) {
-        y = h - y - 1;
+int Bus::getLength() {
+    return currentStrip->pixels.size();
+}
+uint32_t Bus::getPixelColor(int i) {
+    if ((size_t)i >= currentStrip->pixels.size()) {
+        return 0;
     }
-    if (mapping == 3) {
-        x = w - x - 1;
+    return currentStrip->pixels[i];
+}
+void Bus::setPixelColor(int i, uint32_t c) {
+    if ((size_t)i >= currentStrip->pixels.size()) {
+        return;
     }
-    int r = R(c);
-    int g = G(c);
-    int b = B(c);
-    int brightness = currentStrip->brightness;
-    r = r * brightness / 128;
-    g = g * brightness / 128;
-    b = b * brightness / 128;
-    currentStrip->model->setOverlayPixelValue(x, y, min(r, 255), min(g, 255), min(b, 255));
+    currentStrip->pixels[i] = c & 0xFFFFFF;
 }
@@ -0,0 +1,64 @@
+/*
+ * This file is part of the Falcon Player (FPP) and is Copyright (C)
+ * 2013-2022 by the Falcon Player Developers.
+ *
+ * The Falcon Player (FPP) is free software, and is covered under
+ * multiple Open Source licenses.  Please see the included 'LICENSES'
+ * file for descriptions of what files are covered by each license.
+ *
+ * This source file is covered under the LGPL v2.1 as described in the
+ * included LICENSE.LGPL file.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "channeloutput/UDPPacer.h"
+
+static int failures = 0;
+
+// Runs a pacer for one second of 1ms slots with more packets than the cap
+// allows and checks the rate actually sent
+static void testRate(int maxPPS) {
+    UDPPacer pacer(1000000, 25, maxPPS, 1000);
+    int sent = 0;
+    int maxBurst = 0;
+    for (int slot = 0; slot < 1000; slot++) {
+        int count = pacer.next();
+        sent += count;
+        if (count > maxBurst) {
+            maxBurst = count;
+        }
+    }
+    int burstLimit = maxPPS / 1000 + 2;
+    bool ok = abs(sent - maxPPS) <= 1 && maxBurst <= burstLimit;
+    printf("%s: cap %d pps sent %d in 1s, max %d per slot\n", ok ? "PASS" : "FAIL", maxPPS, sent, maxBurst);
+    if (!ok) {
+        failures++;
+    }
+}
+
+// Without a cap the packets are spread evenly over the window
+static void testWindow() {
+    UDPPacer pacer(100, 25, 0, 1000);
+    int sent = 0;
+    int slots = 0;
+    while (sent < 100) {
+        sent += pacer.next();
+        slots++;
+    }
+    bool ok = slots == 25;
+    printf("%s: 100 packets over 25 slots took %d slots\n", ok ? "PASS" : "FAIL", slots);
+    if (!ok) {
+        failures++;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    testRate(200);
+    testRate(1500);
+    testRate(2500);
+    testRate(1000);
+    testWindow();
+    return failures ? 1 : 0;
+}
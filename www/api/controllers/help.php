@@ -46,11 +46,11 @@ function help_help()
         [ 'GET /models/:ModelName', 'Gets a single Pixel Overlay Model', '' , '{"ChannelCount":6144,"Name":"Matrix","Orientation":"horizontal","StartChannel":1,"StartCorner":"TL","StrandsPerString":1,"StringCount":32}'],
         [ 'POST /models', 'Uploads a new model-overlays.json file', '{"models" : [ {"ChannelCount" : 6144,"Name" : "Matrix","Orientation" : "horizontal", "StartChannel" : 1,"StartCorner" : "TL","StrandsPerString" : 1,"StringCount" : 32}]}', 'OK'],
         [ 'GET /overlays/fonts', 'Gets a list of fonts that can be used on the overlay models', '', '["Courier","Courier-Bold","Courier-Oblique","Courier-BoldOblique","Helvetica","Helvetica-Bold","Helvetica-Oblique","Helvetica-BoldOblique","Helvetica-Narrow","Helvetica-Narrow-Oblique","Helvetica-Narrow-Bold","Helvetica-Narrow-BoldOblique","Times-Roman","Times-Bold","Times-Italic","Times-BoldItalic","Symbol"]'],
-        [ 'GET /overlays/models', 'Gets a list of the Pixel Overlay Models and their state', '', '[{"ChannelCount":6144,"Name":"Matrix","Orientation":"horizontal","StartChannel":1,"StartCorner":"TL","StrandsPerString":1,"StringCount":32,"isActive":0}]' ],
-        [ 'GET /overlays/model/:ModelName', 'Gets the given overlay model and it\'s state', '', '{"ChannelCount":6144,"Name":"Matrix","Orientation":"horizontal","StartChannel":1,"StartCorner":"TL","StrandsPerString":1,"StringCount":32,"isActive":0}'],
+        [ 'GET /overlays/models', 'Gets a list of the Pixel Overlay Models and their state', '', '[{"ChannelCount":6144,"Name":"Matrix","Orientation":"horizontal","StartChannel":1,"StartCorner":"TL","StrandsPerString":1,"StringCount":32,"isActive":0,"opacity":255}]' ],
+        [ 'GET /overlays/model/:ModelName', 'Gets the given overlay model and it\'s state', '', '{"ChannelCount":6144,"Name":"Matrix","Orientation":"horizontal","StartChannel":1,"StartCorner":"TL","StrandsPerString":1,"StringCount":32,"isActive":0,"opacity":255}'],
         [ 'GET /overlays/model/:ModelName/clear', 'Clears the given model', '', 'OK'],
         [ 'GET /overlays/model/:ModelName/data', 'Gets the current channel data for the model', '', '{"data":[0,0,0,0,0,0],"isLocked":false}'],
-        [ 'PUT /overlays/model/:ModelName/state', 'Sets the state of the overlay model', '{"State": 1}', 'OK'],
+        [ 'PUT /overlays/model/:ModelName/state', 'Sets the state of the overlay model.  State is 0-8 or the name: Disabled, Enabled, Transparent, TransparentRGB, Alpha, Add, Max, Multiply, Subtract.  The optional Opacity (0-255) is used by the Alpha state.', '{"State": 4, "Opacity": 128}', 'OK'],
         [ 'PUT /overlays/model/:ModelName/fill', 'Fills the entire overlay with the given color', '{"RGB": [255, 0, 0]}', 'OK'],
         [ 'PUT /overlays/model/:ModelName/pixel', 'Sets a specific pixel in the model to the given color', '{"X": 10, "Y": 12, "RGB": [255, 0, 0]}', 'OK'],
         [ 'PUT /overlays/model/:ModelName/text', 'Displays text on the overlay model', '{"Message": "Hello", "Position": "L2R", "Font": "Helvetica", "FontSize": 12, "AntiAlias": false, "PixelsPerSecond": 5, "Color": "#FF000", "AutoEnable": false}', 'OK'],
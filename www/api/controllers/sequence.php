@@ -35,13 +35,45 @@ function GetSequence()
         if (ob_get_level()) {
             ob_end_clean();
         }
+        $size = real_filesize($file);
         header('Content-Description: File Transfer');
         header('Content-Type: application/octet-stream');
         header('Content-Disposition: attachment; filename="' . basename($file) . '"');
         header('Expires: 0');
         header('Cache-Control: must-revalidate');
         header('Pragma: public');
-        header('Content-Length: ' . real_filesize($file));
+        header('Accept-Ranges: bytes');
+
+        // Remotes playing a sequence they don't have fetch it in pieces
+        if (isset($_SERVER['HTTP_RANGE']) && preg_match('/^bytes=(\d*)-(\d*)$/', $_SERVER['HTTP_RANGE'], $range)) {
+            if ($range[1] === '') {
+                $start = max(0, $size - intval($range[2]));
+                $end = $size - 1;
+            } else {
+                $start = intval($range[1]);
+                $end = ($range[2] === '') ? $size - 1 : min(intval($range[2]), $size - 1);
+            }
+            if ($start > $end || $start >= $size) {
+                header('Content-Range: bytes */' . $size);
+                halt(416);
+            }
+            http_response_code(206);
+            header('Content-Range: bytes ' . $start . '-' . $end . '/' . $size);
+            header('Content-Length: ' . ($end - $start + 1));
+
+            $fp = fopen($file, 'rb');
+            fseek($fp, $start);
+            $remaining = $end - $start + 1;
+            while ($remaining > 0 && !feof($fp)) {
+                $data = fread($fp, min(65536, $remaining));
+                echo $data;
+                $remaining -= strlen($data);
+            }
+            fclose($fp);
+            return;
+        }
+
+        header('Content-Length: ' . $size);
         readfile($file);
     } else {
         halt(404, "Not found: " . $sequence);